@@ -0,0 +1,349 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+/* Generates synthetic timelines and times the core editing operations of the timeline models, without any GUI.
+ *
+ * Usage: timeline_bench [--json output.json] [--clips 100,1000,10000,50000] [--tracks 2,10,100] [--samples 200]
+ * A timeline is built for each combination of clip and track count. Clips are spread evenly over the tracks, separated by a small gap. Each
+ * operation is then measured on randomly chosen clips, and undone (outside of the measurement) so that all samples see the same timeline.
+ * Results are printed as a table and optionally written as json, so that the scaling curves can be compared between releases.
+ * The Logger is disabled, so the timings do not include the tracing of the calls.
+ */
+
+#include "bin/model/markerlistmodel.hpp"
+#include "doc/docundostack.hpp"
+#include "fakeit_standalone.hpp"
+#include "logger.hpp"
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+#define private public
+#define protected public
+#include "bin/projectclip.h"
+#include "bin/projectfolder.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "project/projectmanager.h"
+#include "timeline2/model/timelinefunctions.hpp"
+#include "timeline2/model/timelineitemmodel.hpp"
+#include "timeline2/model/timelinemodel.hpp"
+#include "timeline2/model/trackmodel.hpp"
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using namespace fakeit;
+
+namespace {
+// Length of the generated clips, and gap between two clips of a track
+const int clipLength = 50;
+const int clipGap = 10;
+
+class Statistics
+{
+public:
+    struct Operation
+    {
+        std::vector<double> latencies; // in microseconds
+        int failures = 0;
+    };
+
+    /** @brief Run and time an operation, returns its result */
+    bool measure(const std::string &name, const std::function<bool()> &operation)
+    {
+        auto start = std::chrono::steady_clock::now();
+        bool result = operation();
+        auto end = std::chrono::steady_clock::now();
+        Operation &op = m_operations[name];
+        op.latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        if (!result) {
+            op.failures++;
+        }
+        return result;
+    }
+
+    static double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty()) {
+            return 0.;
+        }
+        size_t rank = size_t(p * double(sorted.size() - 1) + 0.5);
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    void print(int clips, int tracks) const
+    {
+        std::cout << clips << " clips on " << tracks << " tracks" << std::endl;
+        std::cout << std::left << std::setw(20) << "operation" << std::right << std::setw(8) << "count" << std::setw(8) << "failed" << std::setw(12)
+                  << "p50 (us)" << std::setw(12) << "p90 (us)" << std::setw(12) << "p99 (us)" << std::setw(12) << "max (us)" << std::setw(14)
+                  << "total (ms)" << std::endl;
+        for (const auto &entry : m_operations) {
+            std::vector<double> sorted = entry.second.latencies;
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0;
+            for (double l : sorted) {
+                total += l;
+            }
+            std::cout << std::left << std::setw(20) << entry.first << std::right << std::setw(8) << sorted.size() << std::setw(8)
+                      << entry.second.failures << std::fixed << std::setprecision(1) << std::setw(12) << percentile(sorted, 0.5) << std::setw(12)
+                      << percentile(sorted, 0.9) << std::setw(12) << percentile(sorted, 0.99) << std::setw(12) << sorted.back() << std::setw(14)
+                      << total / 1000. << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    QJsonObject toJson(int clips, int tracks) const
+    {
+        QJsonArray operations;
+        for (const auto &entry : m_operations) {
+            std::vector<double> sorted = entry.second.latencies;
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0;
+            for (double l : sorted) {
+                total += l;
+            }
+            QJsonObject obj;
+            obj.insert(QStringLiteral("name"), QString::fromStdString(entry.first));
+            obj.insert(QStringLiteral("count"), int(sorted.size()));
+            obj.insert(QStringLiteral("failures"), entry.second.failures);
+            obj.insert(QStringLiteral("p50_us"), percentile(sorted, 0.5));
+            obj.insert(QStringLiteral("p90_us"), percentile(sorted, 0.9));
+            obj.insert(QStringLiteral("p99_us"), percentile(sorted, 0.99));
+            obj.insert(QStringLiteral("max_us"), sorted.back());
+            obj.insert(QStringLiteral("total_us"), total);
+            operations.append(obj);
+        }
+        QJsonObject run;
+        run.insert(QStringLiteral("clips"), clips);
+        run.insert(QStringLiteral("tracks"), tracks);
+        run.insert(QStringLiteral("operations"), operations);
+        return run;
+    }
+
+private:
+    std::map<std::string, Operation> m_operations;
+};
+
+QString createProducer(Mlt::Profile &prof, const char *color, const std::shared_ptr<ProjectItemModel> &binModel)
+{
+    std::shared_ptr<Mlt::Producer> producer = std::make_shared<Mlt::Producer>(prof, "color", color);
+    producer->set("length", clipLength);
+    producer->set("out", clipLength - 1);
+    QString binId = QString::number(binModel->getFreeClipId());
+    auto binClip = ProjectClip::construct(binId, QIcon(), binModel, producer);
+    binClip->forceLimitedDuration();
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    binModel->addItem(binClip, binModel->getRootFolder()->clipId(), undo, redo);
+    return binId;
+}
+
+QList<int> parseList(const QString &arg)
+{
+    QList<int> result;
+    for (const QString &value : arg.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        if (value.toInt() > 0) {
+            result << value.toInt();
+        }
+    }
+    return result;
+}
+
+QJsonObject runBenchmark(int clipCount, int trackCount, int samples)
+{
+    Logger::clear();
+    Mlt::Profile profile;
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    Statistics stats;
+    std::default_random_engine g(42);
+    QStringList binIds;
+    for (const char *color : {"red", "green", "blue", "yellow"}) {
+        binIds << createProducer(profile, color, binModel);
+    }
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile, guideModel, undoStack);
+    std::vector<int> tracks;
+    for (int i = 0; i < trackCount; ++i) {
+        int tid;
+        timeline->requestTrackInsertion(-1, tid);
+        tracks.push_back(tid);
+    }
+
+    // Build the timeline: the clips of each track follow each other, separated by a gap
+    const int clipsPerTrack = (clipCount + trackCount - 1) / trackCount;
+    std::vector<std::vector<int>> clips(tracks.size());
+    for (int i = 0; i < clipCount; ++i) {
+        int track = i % trackCount;
+        int index = i / trackCount;
+        int cid = -1;
+        if (stats.measure("insert", [&]() {
+                return timeline->requestClipInsertion(binIds.at(i % binIds.size()), tracks[size_t(track)], index * (clipLength + clipGap), cid);
+            })) {
+            clips[size_t(track)].push_back(cid);
+        }
+    }
+    // Group the clips sharing the same position on two adjacent tracks, every 10 clips
+    std::vector<int> groupedClips;
+    for (size_t track = 0; track + 1 < clips.size(); track += 2) {
+        for (size_t index = 5; index < std::min(clips[track].size(), clips[track + 1].size()); index += 10) {
+            std::unordered_set<int> ids{clips[track][index], clips[track + 1][index]};
+            stats.measure("group", [&]() { return timeline->requestClipsGroup(ids) > -1; });
+            groupedClips.push_back(clips[track][index]);
+        }
+    }
+    undoStack->clear();
+
+    // Returns a random clip that is not grouped, with its track
+    auto randomClip = [&](int &trackId) {
+        size_t track = std::uniform_int_distribution<size_t>(0, clips.size() - 1)(g);
+        while (clips[track].empty()) {
+            track = (track + 1) % clips.size();
+        }
+        size_t index = std::uniform_int_distribution<size_t>(0, clips[track].size() - 1)(g);
+        if (index % 10 == 5 && clips[track].size() > 1) {
+            index = index > 0 ? index - 1 : index + 1;
+        }
+        trackId = tracks[track];
+        return clips[track][index];
+    };
+    const int duration = clipsPerTrack * (clipLength + clipGap);
+    for (int i = 0; i < samples; ++i) {
+        int tid;
+        int cid = randomClip(tid);
+        int position = timeline->getClipPosition(cid);
+        int delta = std::uniform_int_distribution<int>(1, clipGap / 2)(g);
+
+        if (stats.measure("move", [&]() { return timeline->requestClipMove(cid, tid, position + delta); })) {
+            stats.measure("undo", [&]() {
+                undoStack->undo();
+                return timeline->getClipPosition(cid) == position;
+            });
+            stats.measure("redo", [&]() {
+                undoStack->redo();
+                return timeline->getClipPosition(cid) == position + delta;
+            });
+            undoStack->undo();
+        }
+
+        if (!groupedClips.empty()) {
+            int gid = groupedClips[std::uniform_int_distribution<size_t>(0, groupedClips.size() - 1)(g)];
+            int groupPosition = timeline->getClipPosition(gid);
+            if (stats.measure("group_move", [&]() { return timeline->requestClipMove(gid, timeline->getClipTrackId(gid), groupPosition + delta); })) {
+                undoStack->undo();
+            }
+        }
+
+        if (stats.measure("resize", [&]() { return timeline->requestItemResize(cid, clipLength - delta, true) > -1; })) {
+            undoStack->undo();
+        }
+
+        if (stats.measure("cut", [&]() { return TimelineFunctions::requestClipCut(timeline, cid, position + clipLength / 2); })) {
+            undoStack->undo();
+        }
+
+        QString copy;
+        stats.measure("copy", [&]() {
+            copy = TimelineFunctions::copyClips(timeline, {cid});
+            return !copy.isEmpty();
+        });
+        if (!copy.isEmpty() && stats.measure("paste", [&]() { return TimelineFunctions::pasteClips(timeline, copy, tid, duration + clipGap); })) {
+            undoStack->undo();
+        }
+
+        int snapPosition = std::uniform_int_distribution<int>(0, duration)(g);
+        stats.measure("snap", [&]() { return timeline->suggestSnapPoint(snapPosition, clipGap) > -2; });
+    }
+    stats.measure("check_consistency", [&]() { return timeline->checkConsistency(); });
+
+    stats.print(clipCount, trackCount);
+    QJsonObject result = stats.toJson(clipCount, trackCount);
+    undoStack->clear();
+    timeline.reset();
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+    return result;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+    qputenv("MLT_TESTS", QByteArray("1"));
+    QString jsonFile;
+    QList<int> clipCounts{100, 1000, 10000, 50000};
+    QList<int> trackCounts{2, 10, 100};
+    int samples = 200;
+    const QStringList args = app.arguments();
+    for (int i = 1; i + 1 < args.size(); i += 2) {
+        if (args.at(i) == QLatin1String("--json")) {
+            jsonFile = args.at(i + 1);
+        } else if (args.at(i) == QLatin1String("--clips")) {
+            clipCounts = parseList(args.at(i + 1));
+        } else if (args.at(i) == QLatin1String("--tracks")) {
+            trackCounts = parseList(args.at(i + 1));
+        } else if (args.at(i) == QLatin1String("--samples")) {
+            samples = qMax(1, args.at(i + 1).toInt());
+        } else {
+            std::cerr << "Usage: timeline_bench [--json output.json] [--clips 100,1000] [--tracks 2,10] [--samples 200]" << std::endl;
+            return 1;
+        }
+    }
+    Core::build(false);
+    Logger::init();
+    // Every top-level model call would otherwise be traced by the Logger, which is not what we want to measure
+    Logger::set_enabled(false);
+    QJsonArray runs;
+    for (int trackCount : trackCounts) {
+        for (int clipCount : clipCounts) {
+            runs.append(runBenchmark(clipCount, trackCount, samples));
+        }
+    }
+    if (!jsonFile.isEmpty()) {
+        QFile file(jsonFile);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Cannot write " << jsonFile.toStdString() << std::endl;
+            return 1;
+        }
+        QJsonObject root;
+        root.insert(QStringLiteral("samples"), samples);
+        root.insert(QStringLiteral("runs"), runs);
+        file.write(QJsonDocument(root).toJson());
+    }
+    Core::m_self.reset();
+    return 0;
+}
@@ -0,0 +1,249 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+/* Replays an editing session recorded by the Logger (the fuzz_case_*.txt files written by Logger::print_trace, or the binary files written by
+ * Logger::start_recording) against the timeline models, without any GUI, and reports the latency distribution and the number of operator new calls (with
+ * the bytes requested) of each kind of operation. Allocations done directly with malloc, as by Qt containers, are not counted.
+ *
+ * Usage: trace_replay [--json output.json] [trace file]
+ * The trace is read from stdin if no file is given. Binary records must be given as a file.
+ *
+ * The replay is single threaded: every top-level model call holds the timeline lock for its whole duration, so the measured latency is also the
+ * lock hold time that the same operation imposes on the GUI thread. The Logger is disabled during the replay, so that its tracing overhead is not
+ * included in the latencies.
+ */
+
+#include "core.h"
+#include "fuzzing.hpp"
+#include "logger.hpp"
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <vector>
+
+namespace {
+std::atomic<size_t> allocationCount{0};
+std::atomic<size_t> allocationBytes{0};
+} // namespace
+
+// Count the calls to operator new. Memory allocated by Qt containers goes through malloc and is not counted.
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace {
+class ReplayStatistics : public FuzzObserver
+{
+public:
+    struct Operation
+    {
+        std::vector<double> latencies; // in microseconds
+        size_t allocations = 0;
+        size_t allocatedBytes = 0;
+        int failures = 0;
+    };
+
+    void operationStarted(const std::string &name) override
+    {
+        m_current = name;
+        m_startAllocations = allocationCount.load(std::memory_order_relaxed);
+        m_startBytes = allocationBytes.load(std::memory_order_relaxed);
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    void operationFinished(bool success) override
+    {
+        auto end = std::chrono::steady_clock::now();
+        Operation &op = m_operations[m_current];
+        op.latencies.push_back(std::chrono::duration<double, std::micro>(end - m_start).count());
+        op.allocations += allocationCount.load(std::memory_order_relaxed) - m_startAllocations;
+        op.allocatedBytes += allocationBytes.load(std::memory_order_relaxed) - m_startBytes;
+        if (!success) {
+            op.failures++;
+        }
+    }
+
+    static double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty()) {
+            return 0.;
+        }
+        size_t rank = size_t(p * double(sorted.size() - 1) + 0.5);
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    void print() const
+    {
+        std::cout << std::left << std::setw(40) << "operation" << std::right << std::setw(8) << "count" << std::setw(8) << "failed" << std::setw(12)
+                  << "p50 (us)" << std::setw(12) << "p90 (us)" << std::setw(12) << "p99 (us)" << std::setw(12) << "max (us)" << std::setw(14)
+                  << "total (ms)" << std::setw(12) << "new/op" << std::setw(12) << "new B/op" << std::endl;
+        for (const auto &entry : sortedByTotal()) {
+            const Operation &op = *entry.second;
+            std::vector<double> sorted = op.latencies;
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0;
+            for (double l : sorted) {
+                total += l;
+            }
+            const double count = double(sorted.size());
+            std::cout << std::left << std::setw(40) << entry.first << std::right << std::setw(8) << sorted.size() << std::setw(8) << op.failures
+                      << std::fixed << std::setprecision(1) << std::setw(12) << percentile(sorted, 0.5) << std::setw(12) << percentile(sorted, 0.9)
+                      << std::setw(12) << percentile(sorted, 0.99) << std::setw(12) << sorted.back() << std::setw(14) << total / 1000.
+                      << std::setw(12) << double(op.allocations) / count << std::setw(12) << double(op.allocatedBytes) / count << std::endl;
+        }
+    }
+
+    QJsonDocument toJson() const
+    {
+        QJsonArray operations;
+        for (const auto &entry : sortedByTotal()) {
+            const Operation &op = *entry.second;
+            std::vector<double> sorted = op.latencies;
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0;
+            for (double l : sorted) {
+                total += l;
+            }
+            QJsonObject obj;
+            obj.insert(QStringLiteral("name"), QString::fromStdString(entry.first));
+            obj.insert(QStringLiteral("count"), int(sorted.size()));
+            obj.insert(QStringLiteral("failures"), op.failures);
+            obj.insert(QStringLiteral("p50_us"), percentile(sorted, 0.5));
+            obj.insert(QStringLiteral("p90_us"), percentile(sorted, 0.9));
+            obj.insert(QStringLiteral("p99_us"), percentile(sorted, 0.99));
+            obj.insert(QStringLiteral("max_us"), sorted.back());
+            obj.insert(QStringLiteral("total_us"), total);
+            obj.insert(QStringLiteral("operator_new_calls"), double(op.allocations));
+            obj.insert(QStringLiteral("operator_new_bytes"), double(op.allocatedBytes));
+            operations.append(obj);
+        }
+        QJsonObject root;
+        root.insert(QStringLiteral("operations"), operations);
+        return QJsonDocument(root);
+    }
+
+private:
+    std::vector<std::pair<std::string, const Operation *>> sortedByTotal() const
+    {
+        std::vector<std::pair<std::string, const Operation *>> result;
+        std::map<const Operation *, double> totals;
+        for (const auto &entry : m_operations) {
+            double total = 0;
+            for (double l : entry.second.latencies) {
+                total += l;
+            }
+            totals[&entry.second] = total;
+            result.emplace_back(entry.first, &entry.second);
+        }
+        std::sort(result.begin(), result.end(), [&](const auto &a, const auto &b) { return totals[a.second] > totals[b.second]; });
+        return result;
+    }
+
+    std::map<std::string, Operation> m_operations;
+    std::string m_current;
+    size_t m_startAllocations = 0;
+    size_t m_startBytes = 0;
+    std::chrono::steady_clock::time_point m_start;
+};
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+    qputenv("MLT_TESTS", QByteArray("1"));
+    QString jsonFile;
+    QString traceFile;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args.at(i) == QLatin1String("--json") && i + 1 < args.size()) {
+            jsonFile = args.at(++i);
+        } else {
+            traceFile = args.at(i);
+        }
+    }
+    std::stringstream ss;
+    if (traceFile.isEmpty()) {
+        std::string str;
+        while (getline(std::cin, str)) {
+            ss << str << std::endl;
+        }
+    } else {
+        QFile file(traceFile);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::cerr << "Cannot open " << traceFile.toStdString() << std::endl;
+            return 1;
+        }
+        if (file.peek(4) == QByteArray("RLDK", 4)) {
+            // Binary record, convert it to the textual trace
+            file.close();
+            if (!Logger::convert_recording(traceFile.toStdString(), ss)) {
+                return 1;
+            }
+        } else {
+            ss << file.readAll().toStdString();
+        }
+    }
+    Core::build(false);
+    // The replayed calls must not be traced again, the Logger overhead would be included in the latencies
+    Logger::set_enabled(false);
+    ReplayStatistics stats;
+    auto start = std::chrono::steady_clock::now();
+    fuzz(ss.str(), &stats);
+    auto end = std::chrono::steady_clock::now();
+    stats.print();
+    std::cout << "Replayed in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    if (!jsonFile.isEmpty()) {
+        QFile file(jsonFile);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Cannot write " << jsonFile.toStdString() << std::endl;
+            return 1;
+        }
+        file.write(stats.toJson().toJson());
+    }
+    return 0;
+}
@@ -123,7 +123,7 @@ bool isIthParamARef(const rttr::method &method, size_t i)
 } // namespace
 } // namespace
 
-void fuzz(const std::string &input)
+void fuzz(const std::string &input, FuzzObserver *observer)
 {
     Logger::init();
     Logger::clear();
@@ -259,19 +259,35 @@ void fuzz(const std::string &input)
     };
     std::string c;
 
+    auto started = [&](const std::string &name) {
+        if (observer) {
+            observer->operationStarted(name);
+        }
+    };
+    auto finished = [&](bool success) {
+        if (observer) {
+            observer->operationFinished(success);
+        }
+    };
     while (ss >> c) {
         if (c == "u") {
-            std::cout << "UNDOING" << std::endl;
+            if (!observer) std::cout << "UNDOING" << std::endl;
+            started("undo");
             undoStack->undo();
+            finished(true);
         } else if (c == "r") {
-            std::cout << "REDOING" << std::endl;
+            if (!observer) std::cout << "REDOING" << std::endl;
+            started("redo");
             undoStack->redo();
+            finished(true);
         } else if (Logger::back_translation_table.count(c) > 0) {
             // std::cout << "found=" << c;
             c = Logger::back_translation_table[c];
             // std::cout << " translated=" << c << std::endl;
             if (c == "constr_TimelineModel") {
+                started(c);
                 all_timelines.emplace_back(TimelineItemModel::construct(&profile, guideModel, undoStack));
+                finished(true);
             } else if (c == "constr_ClipModel") {
                 auto timeline = get_timeline();
                 int id = 0, state_id;
@@ -290,7 +306,9 @@ void fuzz(const std::string &input)
                 }
                 state = static_cast<PlaylistState::ClipState>(state_id);
                 if (timeline && valid) {
+                    started(c);
                     ClipModel::construct(timeline, binClip, -1, state, speed);
+                    finished(true);
                 }
             } else if (c == "constr_TrackModel") {
                 auto timeline = get_timeline();
@@ -304,16 +322,22 @@ void fuzz(const std::string &input)
                 if (pos < -1) pos = 0;
                 pos = std::min((int)all_tracks[timeline].size(), pos);
                 if (timeline) {
+                    started(c);
                     TrackModel::construct(timeline, -1, pos, QString::fromStdString(name), audio);
+                    finished(true);
                 }
             } else if (c == "constr_test_producer") {
                 std::string color;
                 int length = 0;
                 bool limited = false;
                 ss >> color >> length >> limited;
+                started(c);
                 createProducer(profile, color, binModel, length, limited);
+                finished(true);
             } else if (c == "constr_test_producer_sound") {
+                started(c);
                 createProducerWithSound(profile, binModel);
+                finished(true);
             } else {
                 // std::cout << "executing " << c << std::endl;
                 rttr::type target_type = rttr::type::get<int>();
@@ -466,7 +490,7 @@ void fuzz(const std::string &input)
                         }
                     }
                     if (valid) {
-                        std::cout << "VALID!!! " << target_method.get_name().to_string() << std::endl;
+                        if (!observer) std::cout << "VALID!!! " << target_method.get_name().to_string() << std::endl;
                         std::vector<rttr::argument> args;
                         args.reserve(arguments.size());
                         for (auto &a : arguments) {
@@ -476,19 +500,21 @@ void fuzz(const std::string &input)
                         for (const auto &p : target_method.get_parameter_infos()) {
                             // std::cout << "expected=" << p.get_type().get_name().to_string() << std::endl;
                         }
+                        started(c);
                         rttr::variant res = target_method.invoke_variadic(ptr, args);
-                        if (res.is_valid()) {
-                            std::cout << "SUCCESS!!!" << std::endl;
-                        } else {
-                            std::cout << "!!!FAILLLLLL!!!" << std::endl;
+                        finished(res.is_valid() && (res.get_type() != rttr::type::get<bool>() || res.to_bool()));
+                        if (!observer) {
+                            std::cout << (res.is_valid() ? "SUCCESS!!!" : "!!!FAILLLLLL!!!") << std::endl;
                         }
                     }
                 }
             }
         }
         update_elems();
-        for (const auto &t : all_timelines) {
-            assert(t->checkConsistency());
+        if (!observer) {
+            for (const auto &t : all_timelines) {
+                assert(t->checkConsistency());
+            }
         }
     }
     undoStack->clear();
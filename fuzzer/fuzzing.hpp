@@ -23,4 +23,19 @@
 
 #include <string>
 
-void fuzz(const std::string &input);
+/** @brief Interface notified of each operation executed by fuzz(). It is used by the trace replay benchmark to measure every operation */
+class FuzzObserver
+{
+public:
+    virtual ~FuzzObserver() = default;
+    /** @brief Called right before executing an operation. name is the method or constructor name, or "undo"/"redo" */
+    virtual void operationStarted(const std::string &name) = 0;
+    /** @brief Called right after the operation started by the last call to operationStarted */
+    virtual void operationFinished(bool success) = 0;
+};
+
+/** @brief Execute the operations of a fuzz case, as written by Logger::print_trace
+ *  @param observer if not null, it is notified of each operation. Consistency checks and verbose output are then disabled so that they don't distort
+ *  measurements
+ */
+void fuzz(const std::string &input, FuzzObserver *observer = nullptr);
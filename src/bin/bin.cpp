@@ -3676,9 +3676,9 @@ void Bin::refreshProxySettings()
 QStringList Bin::getProxyHashList()
 {
     QStringList list;
-    QList<std::shared_ptr<ProjectClip>> clipList = m_itemModel->getRootFolder()->childClips();
-    for (const std::shared_ptr<ProjectClip> &clp : clipList) {
-        if (clp->clipType() == ClipType::AV || clp->clipType() == ClipType::Video || clp->clipType() == ClipType::Playlist) {
+    for (ClipType::ProducerType type : {ClipType::AV, ClipType::Video, ClipType::Playlist}) {
+        const QList<std::shared_ptr<ProjectClip>> clipList = m_itemModel->getClipsByType(type);
+        for (const std::shared_ptr<ProjectClip> &clp : clipList) {
             list << clp->hash();
         }
     }
@@ -3740,7 +3740,7 @@ void Bin::resetUsageCount()
 
 void Bin::getBinStats(uint *used, uint *unused, qint64 *usedSize, qint64 *unusedSize)
 {
-    QList<std::shared_ptr<ProjectClip>> clipList = m_itemModel->getRootFolder()->childClips();
+    const QList<std::shared_ptr<ProjectClip>> clipList = m_itemModel->getAllClips();
     for (const std::shared_ptr<ProjectClip> &clip : clipList) {
         if (clip->refCount() == 0) {
             *unused += 1;
@@ -0,0 +1,174 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "binclipindex.h"
+#include "projectclip.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+QString BinClipIndex::canonicalPath(const QString &path)
+{
+    if (path.isEmpty()) {
+        return QString();
+    }
+    // Same rules as QFileInfo::operator==: canonical path for existing files, cleaned absolute path otherwise
+    QFileInfo info(path);
+    QString canonical = info.canonicalFilePath();
+    if (canonical.isEmpty()) {
+        canonical = QDir::cleanPath(info.absoluteFilePath());
+    }
+    return canonical;
+}
+
+void BinClipIndex::update(const std::shared_ptr<ProjectClip> &clip)
+{
+    const QString binId = clip->clipId();
+    const QString path = canonicalPath(clip->clipUrl());
+    const QString hash = clip->getProducerProperty(QStringLiteral("kdenlive:file_hash"));
+    const int type = int(clip->clipType());
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(binId);
+    if (it != m_entries.end()) {
+        if (it->second.path == path && it->second.hash == hash && it->second.type == type && it->second.clip.lock() == clip) {
+            return;
+        }
+        unlink(binId, it->second);
+    }
+    Entry &entry = m_entries[binId];
+    entry.clip = clip;
+    entry.path = path;
+    entry.hash = hash;
+    entry.type = type;
+    if (!path.isEmpty()) {
+        m_byPath[path].insert(binId);
+    }
+    if (!hash.isEmpty()) {
+        m_byHash[hash].insert(binId);
+    }
+    m_byType[type].insert(binId);
+}
+
+void BinClipIndex::remove(const QString &binId)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(binId);
+    if (it == m_entries.end()) {
+        return;
+    }
+    unlink(binId, it->second);
+    m_entries.erase(it);
+}
+
+void BinClipIndex::unlink(const QString &binId, const Entry &entry)
+{
+    auto drop = [&binId](auto &map, const auto &key) {
+        auto it = map.find(key);
+        if (it != map.end()) {
+            it->second.erase(binId);
+            if (it->second.empty()) {
+                map.erase(it);
+            }
+        }
+    };
+    if (!entry.path.isEmpty()) {
+        drop(m_byPath, entry.path);
+    }
+    if (!entry.hash.isEmpty()) {
+        drop(m_byHash, entry.hash);
+    }
+    drop(m_byType, entry.type);
+}
+
+void BinClipIndex::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_byPath.clear();
+    m_byHash.clear();
+    m_byType.clear();
+}
+
+std::shared_ptr<ProjectClip> BinClipIndex::clip(const QString &binId) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(binId);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    return it->second.clip.lock();
+}
+
+QStringList BinClipIndex::clipsByPath(const QString &path) const
+{
+    QStringList result;
+    const QString key = canonicalPath(path);
+    QMutexLocker locker(&m_mutex);
+    auto it = m_byPath.find(key);
+    if (it != m_byPath.end()) {
+        for (const QString &binId : it->second) {
+            result << binId;
+        }
+    }
+    return result;
+}
+
+QStringList BinClipIndex::clipsByHash(const QString &hash) const
+{
+    QStringList result;
+    QMutexLocker locker(&m_mutex);
+    auto it = m_byHash.find(hash);
+    if (it != m_byHash.end()) {
+        for (const QString &binId : it->second) {
+            result << binId;
+        }
+    }
+    return result;
+}
+
+QList<std::shared_ptr<ProjectClip>> BinClipIndex::clipsByType(ClipType::ProducerType type) const
+{
+    QList<std::shared_ptr<ProjectClip>> result;
+    QMutexLocker locker(&m_mutex);
+    auto it = m_byType.find(int(type));
+    if (it != m_byType.end()) {
+        for (const QString &binId : it->second) {
+            if (auto clip = m_entries.at(binId).clip.lock()) {
+                result << clip;
+            }
+        }
+    }
+    return result;
+}
+
+QList<std::shared_ptr<ProjectClip>> BinClipIndex::allClips() const
+{
+    QList<std::shared_ptr<ProjectClip>> result;
+    QMutexLocker locker(&m_mutex);
+    result.reserve(int(m_entries.size()));
+    for (const auto &entry : m_entries) {
+        if (auto clip = entry.second.clip.lock()) {
+            result << clip;
+        }
+    }
+    return result;
+}
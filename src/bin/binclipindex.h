@@ -0,0 +1,77 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#ifndef BINCLIPINDEX_H
+#define BINCLIPINDEX_H
+
+#include "definitions.h"
+#include <QMutex>
+#include <QStringList>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+class ProjectClip;
+
+/**
+ * @class BinClipIndex
+ * @brief Lookup tables for the clips of the project bin, keyed by bin id, canonical file path, file hash and clip type.
+ * Entries are updated when a clip is registered in the model or its producer changes, so that bin wide queries
+ * do not need to walk every item of the model.
+ */
+class BinClipIndex
+{
+public:
+    /** @brief Add or refresh the entry of a clip from its current url, hash and type */
+    void update(const std::shared_ptr<ProjectClip> &clip);
+    void remove(const QString &binId);
+    void clear();
+
+    std::shared_ptr<ProjectClip> clip(const QString &binId) const;
+    /** @brief Returns the ids of the clips pointing to the given file */
+    QStringList clipsByPath(const QString &path) const;
+    /** @brief Returns the ids of the clips with the given file hash */
+    QStringList clipsByHash(const QString &hash) const;
+    /** @brief Returns the clips of the given type */
+    QList<std::shared_ptr<ProjectClip>> clipsByType(ClipType::ProducerType type) const;
+    QList<std::shared_ptr<ProjectClip>> allClips() const;
+
+    /** @brief Returns the key used to index a file path */
+    static QString canonicalPath(const QString &path);
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<ProjectClip> clip;
+        QString path;
+        QString hash;
+        int type{0};
+    };
+    void unlink(const QString &binId, const Entry &entry);
+
+    std::unordered_map<QString, Entry> m_entries;
+    std::unordered_map<QString, std::unordered_set<QString>> m_byPath;
+    std::unordered_map<QString, std::unordered_set<QString>> m_byHash;
+    std::unordered_map<int, std::unordered_set<QString>> m_byType;
+    mutable QMutex m_mutex;
+};
+
+#endif
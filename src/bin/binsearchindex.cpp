@@ -0,0 +1,209 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "binsearchindex.h"
+#include "abstractprojectitem.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+
+bool BinSearchIndex::Filter::isEmpty() const
+{
+    return text.isEmpty() && tags.isEmpty() && rating <= 0 && type <= 0;
+}
+
+void BinSearchIndex::addItem(const std::shared_ptr<AbstractProjectItem> &item)
+{
+    QMutexLocker locker(&m_mutex);
+    int id = item->getId();
+    m_entries[id].item = item;
+    m_dirty.insert(id);
+    m_revision++;
+}
+
+void BinSearchIndex::removeItem(int itemId)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(itemId);
+    if (it == m_entries.end()) {
+        return;
+    }
+    removeTrigrams(itemId, it->second);
+    m_entries.erase(it);
+    m_dirty.erase(itemId);
+    m_revision++;
+}
+
+void BinSearchIndex::markDirty(int itemId)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.count(itemId) > 0) {
+        m_dirty.insert(itemId);
+        m_revision++;
+    }
+}
+
+void BinSearchIndex::markStructureChanged()
+{
+    QMutexLocker locker(&m_mutex);
+    m_revision++;
+}
+
+void BinSearchIndex::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_trigrams.clear();
+    m_dirty.clear();
+    m_revision++;
+}
+
+int BinSearchIndex::revision() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_revision;
+}
+
+std::unordered_set<int> BinSearchIndex::visibleItems(const Filter &filter)
+{
+    QMutexLocker locker(&m_mutex);
+    for (int id : m_dirty) {
+        refresh(id, m_entries.at(id));
+    }
+    m_dirty.clear();
+
+    const QString text = filter.text.toCaseFolded();
+    QStringList foldedTags;
+    for (const QString &tag : filter.tags) {
+        foldedTags << tag.toCaseFolded();
+    }
+    // Only verify the items sharing the least common trigram of the searched text
+    const std::unordered_set<int> *candidates = nullptr;
+    for (quint64 trigram : trigrams(text)) {
+        auto it = m_trigrams.find(trigram);
+        if (it == m_trigrams.end()) {
+            return {};
+        }
+        if (candidates == nullptr || it->second.size() < candidates->size()) {
+            candidates = &it->second;
+        }
+    }
+    std::unordered_set<int> result;
+    auto accept = [&](const Entry &entry) {
+        if (!matches(entry, filter, text, foldedTags)) {
+            return;
+        }
+        // Accept the item and its ancestors, stopping at the first one already accepted
+        auto item = entry.item.lock();
+        while (item && result.insert(item->getId()).second) {
+            item = std::static_pointer_cast<AbstractProjectItem>(item->parentItem().lock());
+        }
+    };
+    if (candidates != nullptr) {
+        for (int id : *candidates) {
+            accept(m_entries.at(id));
+        }
+    } else {
+        for (const auto &entry : m_entries) {
+            accept(entry.second);
+        }
+    }
+    return result;
+}
+
+void BinSearchIndex::refresh(int itemId, Entry &entry)
+{
+    removeTrigrams(itemId, entry);
+    auto item = entry.item.lock();
+    if (!item) {
+        entry.fields.clear();
+        entry.trigrams.clear();
+        return;
+    }
+    // Same data as the name, date and description columns of the ProjectItemModel
+    entry.fields = QStringList{item->getData(AbstractProjectItem::DataName).toString().toCaseFolded(),
+                               item->getData(AbstractProjectItem::DataDate).toString().toCaseFolded(),
+                               item->getData(AbstractProjectItem::DataDescription).toString().toCaseFolded()};
+    entry.tags = item->getData(AbstractProjectItem::DataTag).toString().toCaseFolded();
+    entry.rating = item->getData(AbstractProjectItem::DataRating).toInt();
+    entry.type = item->getData(AbstractProjectItem::ClipType).toInt();
+    entry.trigrams.clear();
+    for (const QString &field : entry.fields) {
+        const auto fieldTrigrams = trigrams(field);
+        entry.trigrams.insert(entry.trigrams.end(), fieldTrigrams.begin(), fieldTrigrams.end());
+    }
+    std::sort(entry.trigrams.begin(), entry.trigrams.end());
+    entry.trigrams.erase(std::unique(entry.trigrams.begin(), entry.trigrams.end()), entry.trigrams.end());
+    for (quint64 trigram : entry.trigrams) {
+        m_trigrams[trigram].insert(itemId);
+    }
+}
+
+void BinSearchIndex::removeTrigrams(int itemId, const Entry &entry)
+{
+    for (quint64 trigram : entry.trigrams) {
+        auto it = m_trigrams.find(trigram);
+        if (it != m_trigrams.end()) {
+            it->second.erase(itemId);
+            if (it->second.empty()) {
+                m_trigrams.erase(it);
+            }
+        }
+    }
+}
+
+bool BinSearchIndex::matches(const Entry &entry, const Filter &filter, const QString &text, const QStringList &foldedTags) const
+{
+    if (filter.rating > 0 && entry.rating < filter.rating) {
+        return false;
+    }
+    if (filter.type > 0 && entry.type != filter.type) {
+        return false;
+    }
+    for (const QString &tag : foldedTags) {
+        if (!entry.tags.contains(tag)) {
+            return false;
+        }
+    }
+    if (text.isEmpty()) {
+        return true;
+    }
+    for (const QString &field : entry.fields) {
+        if (field.contains(text)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// static
+std::vector<quint64> BinSearchIndex::trigrams(const QString &text)
+{
+    std::vector<quint64> result;
+    if (text.size() < 3) {
+        return result;
+    }
+    result.reserve(size_t(text.size() - 2));
+    for (int i = 0; i + 2 < text.size(); ++i) {
+        result.push_back((quint64(text.at(i).unicode()) << 32) | (quint64(text.at(i + 1).unicode()) << 16) | quint64(text.at(i + 2).unicode()));
+    }
+    return result;
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#ifndef BINSEARCHINDEX_H
+#define BINSEARCHINDEX_H
+
+#include <QMutex>
+#include <QStringList>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class AbstractProjectItem;
+
+/**
+ * @class BinSearchIndex
+ * @brief Incrementally maintained index used to filter the project bin.
+ * Each bin item keeps a case folded copy of its searchable columns (name, date, description), tags, rating and type,
+ * and every trigram of the searchable text points to the items containing it. Entries are refreshed lazily when
+ * the model reports a change, so filtering does not have to query the model for every row on each keystroke.
+ */
+class BinSearchIndex
+{
+public:
+    struct Filter
+    {
+        QString text;
+        QStringList tags;
+        int rating{0};
+        int type{0};
+        bool isEmpty() const;
+    };
+
+    void addItem(const std::shared_ptr<AbstractProjectItem> &item);
+    void removeItem(int itemId);
+    /** @brief The displayed data of an item changed, its entry will be rebuilt on next query */
+    void markDirty(int itemId);
+    /** @brief Items were moved in the hierarchy */
+    void markStructureChanged();
+    void clear();
+
+    /** @brief Returns a number that changes each time the result of a query could change */
+    int revision() const;
+
+    /** @brief Returns the ids of the items matching the filter, and of all their ancestors so that matches stay reachable */
+    std::unordered_set<int> visibleItems(const Filter &filter);
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<AbstractProjectItem> item;
+        // case folded name, date and description
+        QStringList fields;
+        QString tags;
+        int rating{0};
+        int type{0};
+        std::vector<quint64> trigrams;
+    };
+    void refresh(int itemId, Entry &entry);
+    void removeTrigrams(int itemId, const Entry &entry);
+    bool matches(const Entry &entry, const Filter &filter, const QString &text, const QStringList &foldedTags) const;
+    static std::vector<quint64> trigrams(const QString &text);
+
+    std::unordered_map<int, Entry> m_entries;
+    std::unordered_map<quint64, std::unordered_set<int>> m_trigrams;
+    std::unordered_set<int> m_dirty;
+    int m_revision{0};
+    mutable QMutex m_mutex;
+};
+
+#endif
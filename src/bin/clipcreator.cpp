@@ -34,9 +34,15 @@
 #include <KMessageBox>
 #include <QApplication>
 #include <QDomDocument>
+#include <QEventLoop>
 #include <QMimeDatabase>
 #include <QProgressDialog>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtConcurrent>
+#include <deque>
 #include <utility>
+#include <vector>
 
 namespace {
 QDomElement createProducer(QDomDocument &xml, ClipType::ProducerType type, const QString &resource, const QString &name, int duration, const QString &service)
@@ -84,14 +90,13 @@ QString ClipCreator::createColorClip(const QString &color, int duration, const Q
     return res ? id : QStringLiteral("-1");
 }
 
-QDomDocument ClipCreator::getXmlFromUrl(const QString &path)
+QDomDocument ClipCreator::getXmlFromUrl(const QString &path, const QMimeType &mimeType)
 {
     QDomDocument xml;
-    QMimeDatabase db;
-    QMimeType type = db.mimeTypeForUrl(QUrl::fromLocalFile(path));
+    // Detecting the type may read the file, avoid it when the caller already did
+    const QMimeType type = mimeType.isValid() ? mimeType : QMimeDatabase().mimeTypeForUrl(QUrl::fromLocalFile(path));
 
     QDomElement prod;
-    qDebug()<<"=== GOT DROPPPED MIME: "<<type.name();
     if (type.name().startsWith(QLatin1String("image/"))) {
         int duration = pCore->currentDoc()->getFramePos(KdenliveSettings::image_duration());
         prod = createProducer(xml, ClipType::Image, path, QString(), duration, QString());
@@ -136,14 +141,13 @@ QDomDocument ClipCreator::getXmlFromUrl(const QString &path)
 }
 
 QString ClipCreator::createClipFromFile(const QString &path, const QString &parentFolder, const std::shared_ptr<ProjectItemModel> &model, Fun &undo, Fun &redo,
-                                        const std::function<void(const QString &)> &readyCallBack)
+                                        const std::function<void(const QString &)> &readyCallBack, const QMimeType &mimeType)
 {
     qDebug() << "/////////// createClipFromFile" << path << parentFolder << path;
-    QDomDocument xml = getXmlFromUrl(path);
+    QDomDocument xml = getXmlFromUrl(path, mimeType);
     if (xml.isNull()) {
         return QStringLiteral("-1");
     }
-    qDebug() << "/////////// final xml" << xml.toString();
     QString id;
     bool res = model->requestAddBinClip(id, xml.documentElement(), parentFolder, undo, redo, readyCallBack);
     return res ? id : QStringLiteral("-1");
@@ -207,13 +211,171 @@ QString ClipCreator::createTitleTemplate(const QString &path, const QString &tex
     return res ? id : QStringLiteral("-1");
 }
 
+namespace {
+// Files and subfolders found in a dropped folder
+struct ScannedFolder
+{
+    QString folderId;
+    // The supported files with their type
+    std::vector<std::pair<QString, QMimeType>> files;
+    QStringList subfolders;
+};
+
+bool isSupportedMime(const QMimeType &mType)
+{
+    const QString mimeAliases = mType.name();
+    return mimeAliases.contains(QLatin1String("video/")) || mimeAliases.contains(QLatin1String("audio/")) || mimeAliases.contains(QLatin1String("image/")) ||
+           mType.inherits(QLatin1String("video/mlt-playlist")) || mType.inherits(QLatin1String("application/x-kdenlivetitle"));
+}
+
+// List the supported files and the subfolders of a folder. Runs in a worker thread
+ScannedFolder scanFolder(const QString &path, const QString &folderId)
+{
+    ScannedFolder result;
+    result.folderId = folderId;
+    QDir dir(path);
+    QMimeDatabase db;
+    const QStringList files = dir.entryList(QDir::Files);
+    for (const QString &file : files) {
+        const QString filePath = dir.absoluteFilePath(file);
+        const QMimeType type = db.mimeTypeForUrl(QUrl::fromLocalFile(filePath));
+        if (isSupportedMime(type)) {
+            result.files.emplace_back(filePath, type);
+        }
+    }
+    const QStringList subfolders = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &sub : subfolders) {
+        result.subfolders << dir.absoluteFilePath(sub);
+    }
+    return result;
+}
+
+// True while a folder import runs its event loop, to refuse starting another import from it
+bool folderImportRunning = false;
+
+/* @brief Import folders recursively, recreating their structure in the bin.
+   Folders are listed by a thread pool. As each listing arrives, its subfolders are created in the bin and listed in turn, while its files
+   are added to the bin in small batches from the event loop, so that the interface stays responsive.
+   Returns false if the user canceled the import.
+*/
+bool importFolders(const QList<QUrl> &folders, const QList<QUrl> &excluded, const QString &parentFolder, const std::shared_ptr<ProjectItemModel> &model,
+                   Fun &undo, Fun &redo, QProgressDialog *progressDialog, QString &createdItem)
+{
+    // Number of clips added to the bin before giving control back to the event loop
+    const int batchSize = 50;
+    QEventLoop loop;
+    QTimer batchTimer;
+    batchTimer.setInterval(0);
+    // Files to add, with their type and bin folder
+    struct PendingClip
+    {
+        QString path;
+        QMimeType type;
+        QString folderId;
+    };
+    std::deque<PendingClip> pendingClips;
+    int running = 0;
+    int found = 0;
+    int added = 0;
+    bool canceled = false;
+    // Listing folders is mostly waiting for the disk, so we don't limit it to the number of cores
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+
+    auto updateProgress = [&]() {
+        if (progressDialog) {
+            progressDialog->setMaximum(found);
+            progressDialog->setValue(added);
+        }
+    };
+    auto checkFinished = [&]() {
+        if (running == 0 && pendingClips.empty()) {
+            loop.quit();
+        }
+    };
+    std::function<void(const QString &, const QString &)> addFolder = [&](const QString &path, const QString &parentId) {
+        QString folderId;
+        if (!model->requestAddFolder(folderId, QDir(path).dirName(), parentId, undo, redo)) {
+            return;
+        }
+        if (createdItem.isEmpty()) {
+            createdItem = folderId;
+        }
+        running++;
+        QtConcurrent::run(&pool, [&, path, folderId]() {
+            ScannedFolder result = scanFolder(path, folderId);
+            // Back to the GUI thread. If the import was canceled and the loop destroyed, this is discarded
+            QMetaObject::invokeMethod(&loop,
+                                      [&, result]() {
+                                          running--;
+                                          for (const auto &file : result.files) {
+                                              pendingClips.push_back({file.first, file.second, result.folderId});
+                                          }
+                                          found += int(result.files.size());
+                                          for (const QString &sub : result.subfolders) {
+                                              if (!excluded.contains(QUrl::fromLocalFile(sub))) {
+                                                  addFolder(sub, result.folderId);
+                                              }
+                                          }
+                                          updateProgress();
+                                          if (!pendingClips.empty()) {
+                                              batchTimer.start();
+                                          }
+                                          checkFinished();
+                                      },
+                                      Qt::QueuedConnection);
+        });
+    };
+    QObject::connect(&batchTimer, &QTimer::timeout, [&]() {
+        for (int i = 0; i < batchSize && !pendingClips.empty(); ++i) {
+            const auto clip = pendingClips.front();
+            pendingClips.pop_front();
+            const QString clipId = ClipCreator::createClipFromFile(clip.path, clip.folderId, model, undo, redo, [](const QString &) {}, clip.type);
+            if (createdItem.isEmpty() && clipId != QLatin1String("-1")) {
+                createdItem = clipId;
+            }
+            added++;
+        }
+        updateProgress();
+        if (pendingClips.empty()) {
+            batchTimer.stop();
+        }
+        checkFinished();
+    });
+    if (progressDialog) {
+        QObject::connect(progressDialog, &QProgressDialog::canceled, &loop, [&]() {
+            canceled = true;
+            loop.quit();
+        });
+    }
+    for (const QUrl &folder : folders) {
+        addFolder(folder.toLocalFile(), parentFolder);
+    }
+    if (running > 0) {
+        loop.exec();
+    }
+    batchTimer.stop();
+    // Drop the folders not listed yet and wait for the ones being listed
+    pool.clear();
+    pool.waitForDone();
+    return !canceled;
+}
+} // namespace
+
 const QString ClipCreator::createClipsFromList(const QList<QUrl> &list, bool checkRemovable, const QString &parentFolder, const std::shared_ptr<ProjectItemModel> &model,
                                       Fun &undo, Fun &redo, bool topLevel)
 {
+    if (folderImportRunning) {
+        // The undo and redo of the running import are not complete yet
+        pCore->displayMessage(i18n("Another import is running"), InformationMessage, 500);
+        return QString();
+    }
     QString createdItem;
     QScopedPointer<QProgressDialog> progressDialog;
     if (topLevel) {
         progressDialog.reset(new QProgressDialog(pCore->window()));
+        // Modality has to be set before the dialog is shown
+        progressDialog->setWindowModality(Qt::WindowModal);
         progressDialog->setWindowTitle(i18n("Loading clips"));
         progressDialog->setCancelButton(nullptr);
         progressDialog->setLabelText(i18n("Importing bin clips..."));
@@ -223,103 +385,50 @@ const QString ClipCreator::createClipsFromList(const QList<QUrl> &list, bool che
         qApp->processEvents();
     }
     qDebug() << "/////////// creatclipsfromlist" << list << checkRemovable << parentFolder;
-    bool created = false;
     QMimeDatabase db;
+    QList<QUrl> folders;
     for (const QUrl &file : list) {
         if (!QFile::exists(file.toLocalFile())) {
             continue;
         }
         QMimeType mType = db.mimeTypeForUrl(file);
+        if (checkRemovable && isOnRemovableDevice(file) && !isOnRemovableDevice(pCore->currentDoc()->projectDataFolder())) {
+            int answer = KMessageBox::warningContinueCancel(
+                QApplication::activeWindow(),
+                i18n("Clip <b>%1</b><br /> is on a removable device, will not be available when device is unplugged or mounted at a different position. You "
+                     "may want to copy it first to your hard-drive. Would you like to add it anyways?",
+                     file.path()),
+                i18n("Removable device"), KStandardGuiItem::cont(), KStandardGuiItem::cancel(), QStringLiteral("confirm_removable_device"));
+
+            if (answer == KMessageBox::Cancel) continue;
+        }
         if (mType.inherits(QLatin1String("inode/directory"))) {
             // user dropped a folder, import its files
-            QDir dir(file.path());
-            QString folderId;
-            Fun local_undo = []() { return true; };
-            Fun local_redo = []() { return true; };
-            bool folderCreated = pCore->projectItemModel()->requestAddFolder(folderId, dir.dirName(), parentFolder, local_undo, local_redo);
-            if (!folderCreated) {
-                continue;
-            }
-            createdItem = folderId;
-            QStringList result = dir.entryList(QDir::Files);
-            QStringList subfolders = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-            QList<QUrl> folderFiles;
-            for (const QString &path : result) {
-                QUrl url = QUrl::fromLocalFile(dir.absoluteFilePath(path));
-                // Check file is of a supported type
-                mType = db.mimeTypeForUrl(url);
-                QString mimeAliases = mType.name();
-                bool isValid = mimeAliases.contains(QLatin1String("video/"));
-                if (!isValid) {
-                    isValid = mimeAliases.contains(QLatin1String("audio/"));
-                }
-                if (!isValid) {
-                    isValid = mimeAliases.contains(QLatin1String("image/"));
-                }
-                if (!isValid && (mType.inherits(QLatin1String("video/mlt-playlist")) || mType.inherits(QLatin1String("application/x-kdenlivetitle")))) {
-                    isValid = true;
-                }
-                if (isValid) {
-                    folderFiles.append(url);
-                }
-            }
-            if (folderFiles.isEmpty()) {
-                QList<QUrl> sublist;
-                for (const QString &sub : subfolders) {
-                    QUrl url = QUrl::fromLocalFile(dir.absoluteFilePath(sub));
-                    if (!list.contains(url)) {
-                        sublist << url;
-                    }
-                }
-                if (!sublist.isEmpty()) {
-                    // load subfolders
-                    const QString clipId = createClipsFromList(sublist, checkRemovable, folderId, model, undo, redo, false);
-                    if (createdItem.isEmpty() && clipId != QLatin1String("-1")) {
-                        createdItem = clipId;
-                    }
-                }
-            } else {
-                const QString clipId = createClipsFromList(folderFiles, checkRemovable, folderId, model, local_undo, local_redo, false);
-                if (clipId.isEmpty() || clipId == QLatin1String("-1")) {
-                    local_undo();
-                } else {
-                    if (createdItem.isEmpty()) {
-                        createdItem = clipId;
-                    }
-                    UPDATE_UNDO_REDO_NOLOCK(local_redo, local_undo, undo, redo)
-                }
-                // Check subfolders
-                QList<QUrl> sublist;
-                for (const QString &sub : subfolders) {
-                    QUrl url = QUrl::fromLocalFile(dir.absoluteFilePath(sub));
-                    if (!list.contains(url)) {
-                        sublist << url;
-                    }
-                }
-                if (!sublist.isEmpty()) {
-                    // load subfolders
-                    createClipsFromList(sublist, checkRemovable, folderId, model, undo, redo, false);
-                }
-            }
+            folders << file;
         } else {
-            // file is not a directory
-            if (checkRemovable && isOnRemovableDevice(file) && !isOnRemovableDevice(pCore->currentDoc()->projectDataFolder())) {
-                int answer = KMessageBox::warningContinueCancel(
-                    QApplication::activeWindow(),
-                    i18n("Clip <b>%1</b><br /> is on a removable device, will not be available when device is unplugged or mounted at a different position. You "
-                         "may want to copy it first to your hard-drive. Would you like to add it anyways?",
-                         file.path()),
-                    i18n("Removable device"), KStandardGuiItem::cont(), KStandardGuiItem::cancel(), QStringLiteral("confirm_removable_device"));
-
-                if (answer == KMessageBox::Cancel) continue;
-            }
-            const QString clipId = ClipCreator::createClipFromFile(file.toLocalFile(), parentFolder, model, undo, redo);
+            const QString clipId = ClipCreator::createClipFromFile(file.toLocalFile(), parentFolder, model, undo, redo, [](const QString &) {}, mType);
             if (createdItem.isEmpty() && clipId != QLatin1String("-1")) {
                 createdItem = clipId;
             }
         }
     }
-    qDebug() << "/////////// creatclipsfromlist return" << created;
+    if (!folders.isEmpty()) {
+        if (progressDialog) {
+            progressDialog->setAutoReset(false);
+            progressDialog->setAutoClose(false);
+            progressDialog->setCancelButtonText(i18n("Cancel"));
+        }
+        folderImportRunning = true;
+        bool finished = importFolders(folders, list, parentFolder, model, undo, redo, progressDialog.data(), createdItem);
+        folderImportRunning = false;
+        if (!finished) {
+            // Canceled, remove everything that was added
+            undo();
+            undo = []() { return true; };
+            redo = []() { return true; };
+            return QString();
+        }
+    }
     return createdItem == QLatin1String("-1") ? QString() : createdItem;
 }
 
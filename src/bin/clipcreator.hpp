@@ -24,6 +24,7 @@
 
 #include "definitions.h"
 #include "undohelper.hpp"
+#include <QMimeType>
 #include <QString>
 #include <memory>
 #include <unordered_map>
@@ -80,13 +81,16 @@ QString createSlideshowClip(const QString &path, int duration, const QString &na
    @param path : path to the file
    @param parentFolder: the binId of the containing folder
    @param model: a shared pointer to the bin item model
+   @param mimeType: the type of the file if it was already detected, otherwise it is detected from the file
    @return the binId of the created clip
 */
 QString createClipFromFile(const QString &path, const QString &parentFolder, const std::shared_ptr<ProjectItemModel> &model, Fun &undo, Fun &redo,
-                           const std::function<void(const QString &)> &readyCallBack = [](const QString &) {});
+                           const std::function<void(const QString &)> &readyCallBack = [](const QString &) {}, const QMimeType &mimeType = QMimeType());
 bool createClipFromFile(const QString &path, const QString &parentFolder, std::shared_ptr<ProjectItemModel> model);
 
 /* @brief Iterates recursively through the given url list and add the files it finds, recreating a folder structure
+   Folders are listed in background threads and their files added to the bin progressively. If the user cancels the import, everything is removed
+   and an empty string is returned.
    @param list: the list of items (can be folders)
    @param checkRemovable: if true, it will check if files are on removable devices, and warn the user if so
    @param parentFolder: the binId of the containing folder
@@ -97,8 +101,9 @@ const QString createClipsFromList(const QList<QUrl> &list, bool checkRemovable,
 const QString createClipsFromList(const QList<QUrl> &list, bool checkRemovable, const QString &parentFolder, std::shared_ptr<ProjectItemModel> model);
 
 /* @brief Create minimal xml description from an url
+   @param mimeType: the type of the file if it was already detected, otherwise it is detected from the file
  */
-QDomDocument getXmlFromUrl(const QString &path);
+QDomDocument getXmlFromUrl(const QString &path, const QMimeType &mimeType = QMimeType());
 } // namespace ClipCreator
 
 #endif
@@ -23,6 +23,11 @@
 
 #include <QFileInfo>
 
+namespace {
+// Number of watched files above which we watch their folders instead
+const size_t directoryModeThreshold = 1000;
+} // namespace
+
 FileWatcher::FileWatcher(QObject *parent)
     : QObject(parent)
     , m_fileWatcher(new KDirWatch())
@@ -40,16 +45,63 @@ void FileWatcher::addFile(const QString &binId, const QString &url)
     if (url.isEmpty()) {
         return;
     }
-    QFileInfo check_file(url);
-    // check if file exists and if yes: Is it really a file and no directory?
-    if (!check_file.exists() || !check_file.isFile()) {
-        return;
-    }
-    if (m_occurences.count(url) == 0) {
-        m_fileWatcher->addFile(url);
+    if (!m_watchDirectories) {
+        QFileInfo check_file(url);
+        // check if file exists and if yes: Is it really a file and no directory?
+        if (!check_file.exists() || !check_file.isFile()) {
+            return;
+        }
     }
+    bool newUrl = m_occurences.count(url) == 0;
     m_occurences[url].insert(binId);
     m_binClipPaths[binId] = url;
+    if (newUrl) {
+        if (!m_watchDirectories && m_occurences.size() > directoryModeThreshold) {
+            m_occurences.erase(url);
+            switchToDirectories();
+            m_occurences[url].insert(binId);
+        }
+        watchUrl(url);
+    }
+}
+
+void FileWatcher::watchUrl(const QString &url)
+{
+    if (!m_watchDirectories) {
+        m_fileWatcher->addFile(url);
+        return;
+    }
+    const QString dir = QFileInfo(url).absolutePath();
+    if (m_directories[dir]++ == 0) {
+        m_fileWatcher->addDir(dir, KDirWatch::WatchFiles);
+    }
+}
+
+void FileWatcher::unwatchUrl(const QString &url)
+{
+    if (!m_watchDirectories) {
+        m_fileWatcher->removeFile(url);
+        return;
+    }
+    const QString dir = QFileInfo(url).absolutePath();
+    auto it = m_directories.find(dir);
+    if (it != m_directories.end() && --it->second == 0) {
+        m_fileWatcher->removeDir(dir);
+        m_directories.erase(it);
+    }
+}
+
+void FileWatcher::switchToDirectories()
+{
+    m_fileWatcher->stopScan();
+    for (const auto &f : m_occurences) {
+        unwatchUrl(f.first);
+    }
+    m_watchDirectories = true;
+    for (const auto &f : m_occurences) {
+        watchUrl(f.first);
+    }
+    m_fileWatcher->startScan();
 }
 
 void FileWatcher::removeFile(const QString &binId)
@@ -61,13 +113,17 @@ void FileWatcher::removeFile(const QString &binId)
     m_occurences[url].erase(binId);
     m_binClipPaths.erase(binId);
     if (m_occurences[url].empty()) {
-        m_fileWatcher->removeFile(url);
+        unwatchUrl(url);
         m_occurences.erase(url);
     }
 }
 
 void FileWatcher::slotUrlModified(const QString &path)
 {
+    if (m_occurences.count(path) == 0) {
+        // In folder mode, we are notified of the changes to all files of the folder
+        return;
+    }
     if (m_modifiedUrls.count(path) == 0) {
         m_modifiedUrls.insert(path);
         for (const QString &id : m_occurences[path]) {
@@ -81,6 +137,14 @@ void FileWatcher::slotUrlModified(const QString &path)
 
 void FileWatcher::slotUrlAdded(const QString &path)
 {
+    if (m_occurences.count(path) == 0) {
+        return;
+    }
+    if (m_watchDirectories) {
+        // The file may still be written, reload once it is stable
+        slotUrlModified(path);
+        return;
+    }
     for (const QString &id : m_occurences[path]) {
         emit binClipModified(id);
     }
@@ -88,6 +152,10 @@ void FileWatcher::slotUrlAdded(const QString &path)
 
 void FileWatcher::slotUrlMissing(const QString &path)
 {
+    if (m_occurences.count(path) == 0) {
+        return;
+    }
+    m_modifiedUrls.erase(path);
     for (const QString &id : m_occurences[path]) {
         emit binClipMissing(id);
     }
@@ -97,7 +165,13 @@ void FileWatcher::slotProcessModifiedUrls()
 {
     auto checkList = m_modifiedUrls;
     for (const QString &path : checkList) {
-        if (m_fileWatcher->ctime(path).msecsTo(QDateTime::currentDateTime()) > 1000) {
+        // Files inside a watched folder are not registered in the watcher
+        const QDateTime modified = m_watchDirectories ? QFileInfo(path).lastModified() : m_fileWatcher->ctime(path);
+        if (!modified.isValid()) {
+            m_modifiedUrls.erase(path);
+            continue;
+        }
+        if (modified.msecsTo(QDateTime::currentDateTime()) > 1000) {
             for (const QString &id : m_occurences[path]) {
                 emit binClipModified(id);
             }
@@ -113,9 +187,11 @@ void FileWatcher::clear()
 {
     m_fileWatcher->stopScan();
     for (const auto &f : m_occurences) {
-        m_fileWatcher->removeFile(f.first);
+        unwatchUrl(f.first);
     }
     m_occurences.clear();
+    m_directories.clear();
+    m_watchDirectories = false;
     m_modifiedUrls.clear();
     m_binClipPaths.clear();
     m_fileWatcher->startScan();
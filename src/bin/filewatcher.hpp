@@ -30,6 +30,8 @@
 
 /** @brief This class is responsible for watching all files used in the project
     and triggers a reload notification when a file changes.
+    Each file is watched individually until the project uses many of them. Then, to stay below the system limit of watches,
+    we switch to watching the folders containing them, and filter the notifications on the files used by the project.
  */
 
 class FileWatcher : public QObject
@@ -61,6 +63,12 @@ private slots:
     void slotProcessModifiedUrls();
 
 private:
+    /** @brief Start watching a url, or its folder in folder mode */
+    void watchUrl(const QString &url);
+    void unwatchUrl(const QString &url);
+    /** @brief Replace the watches on files by watches on their folders */
+    void switchToDirectories();
+
     // This is a handle to the watcher singleton, not owned by this class.
     std::unique_ptr<KDirWatch> m_fileWatcher;
     // A list with urls as keys, and the corresponding clip ids as value
@@ -71,6 +79,11 @@ private:
     // List of files for which we received an update since the last send
     std::unordered_set<QString> m_modifiedUrls;
 
+    // True if we watch the folders of the files instead of the files
+    bool m_watchDirectories{false};
+    // In folder mode, the watched folders and the number of watched files they contain
+    std::unordered_map<QString, int> m_directories;
+
     QTimer m_modifiedTimer;
 };
 
@@ -46,9 +46,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "timecode.h"
 #include "timeline2/model/snapmodel.hpp"
 
+#include "utils/producercache.hpp"
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
 #include <QPainter>
+#include <QSemaphore>
+#include <QThread>
 #include <jobs/proxyclipjob.h>
 #include <kimagecache.h>
 
@@ -61,6 +64,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QDomElement>
 #include <QFile>
+#include <atomic>
 #include <memory>
 
 #pragma GCC diagnostic push
@@ -77,11 +81,20 @@ RTTR_REGISTRATION
     registration::class_<ProjectClip>("ProjectClip");
 }
 
+namespace {
+// Total size of the audioFrameCache of all clips, reported to the memory budget
+std::atomic<qint64> audioThumbnailsBytes{0};
+// Limits the number of thumbnail producers opened at the same time over all clips, opening a file is expensive
+QSemaphore thumbProducerCreations(QThread::idealThreadCount());
+// Maximum time a thumbnail request waits for a producer of the clip to be released before opening one more, in case a thread needs two of them
+const unsigned long thumbProducerWaitTimeout = 5000;
+} // namespace
+
 ProjectClip::ProjectClip(const QString &id, const QIcon &thumb, const std::shared_ptr<ProjectItemModel> &model, std::shared_ptr<Mlt::Producer> producer)
     : AbstractProjectItem(AbstractProjectItem::ClipItem, id, model)
     , ClipController(id, std::move(producer))
-    , m_thumbsProducer(nullptr)
 {
+    initThumbProducerPool();
     m_markerModel = std::make_shared<MarkerListModel>(id, pCore->projectManager()->undoStack());
     m_clipStatus = StatusReady;
     m_name = clipName();
@@ -128,8 +141,8 @@ void ProjectClip::importEffects(const std::shared_ptr<Mlt::Producer> &producer)
 ProjectClip::ProjectClip(const QString &id, const QDomElement &description, const QIcon &thumb, const std::shared_ptr<ProjectItemModel> &model)
     : AbstractProjectItem(AbstractProjectItem::ClipItem, id, model)
     , ClipController(id)
-    , m_thumbsProducer(nullptr)
 {
+    initThumbProducerPool();
     m_clipStatus = StatusWaiting;
     m_thumbnail = thumb;
     m_markerModel = std::make_shared<MarkerListModel>(m_binId, pCore->projectManager()->undoStack());
@@ -166,6 +179,7 @@ ProjectClip::~ProjectClip()
     m_requestedThumbs.clear();
     m_thumbMutex.unlock();
     m_thumbThread.waitForFinished();
+    audioThumbnailsBytes -= audioFrameCache.size();
     audioFrameCache.clear();
 }
 
@@ -199,10 +213,17 @@ QString ProjectClip::getXmlProperty(const QDomElement &producer, const QString &
 
 void ProjectClip::updateAudioThumbnail(const QVector<uint8_t> audioLevels)
 {
+    audioThumbnailsBytes += audioLevels.size() - audioFrameCache.size();
     audioFrameCache = audioLevels;
     m_audioThumbCreated = true;
 }
 
+// static
+qint64 ProjectClip::audioThumbnailsSize()
+{
+    return audioThumbnailsBytes;
+}
+
 bool ProjectClip::audioThumbCreated() const
 {
     return (m_audioThumbCreated);
@@ -311,7 +332,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged, bool
         // Clear cache first
         ThumbnailCache::get()->invalidateThumbsForClip(clipId(), false);
         pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
-        m_thumbsProducer.reset();
+        clearThumbProducers();
         pCore->jobManager()->startJob<ThumbJob>({clipId()}, loadjobId, QString(), -1, true, true);
     } else {
         // If another load job is running?
@@ -325,7 +346,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged, bool
         QDomElement xml = toXml(doc);
         if (!xml.isNull()) {
             pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
-            m_thumbsProducer.reset();
+            clearThumbProducers();
             ClipType::ProducerType type = clipType();
             if (type != ClipType::Color && type != ClipType::Image && type != ClipType::SlideShow) {
                 xml.removeAttribute("out");
@@ -407,7 +428,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     qDebug() << "################### ProjectClip::setproducer";
     QMutexLocker locker(&m_producerMutex);
     updateProducer(producer);
-    m_thumbsProducer.reset();
+    clearThumbProducers();
     connectEffectStack();
 
     // Update info
@@ -439,6 +460,9 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     }
     // Make sure we have a hash for this clip
     getFileHash();
+    if (auto ptr = m_model.lock()) {
+        std::static_pointer_cast<ProjectItemModel>(ptr)->updateClipIndex(std::static_pointer_cast<ProjectClip>(shared_from_this()));
+    }
     // set parent again (some info need to be stored in producer)
     updateParent(parentItem().lock());
 
@@ -477,6 +501,10 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
             if (!skipProducer && getProducerIntProperty(QStringLiteral("meta.media.width")) >= KdenliveSettings::proxyminsize()) {
                 clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
             }
+        } else if (pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateproxy")).toInt() == 1 && m_clipType == ClipType::Playlist &&
+                   getProducerProperty(QStringLiteral("kdenlive:proxy")) == QStringLiteral()) {
+            // Nested sequences are expensive to render for each frame, use a cached render
+            clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
         }
         if (!clipList.isEmpty()) {
             pCore->currentDoc()->slotProxyCurrentItem(true, clipList, false);
@@ -503,45 +531,151 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
 
 std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
 {
-    if (m_thumbsProducer) {
-        return m_thumbsProducer;
-    }
     if (clipType() == ClipType::Unknown) {
         return nullptr;
     }
+    std::shared_ptr<Mlt::Producer> prod;
+    QMutexLocker lock(&m_thumbPoolMutex);
+    while (m_idleThumbProducers.empty() && m_thumbProducerCount >= QThread::idealThreadCount()) {
+        // All producers are in use, wait for one instead of opening the file once more
+        if (!m_thumbProducerReleased.wait(&m_thumbPoolMutex, thumbProducerWaitTimeout)) {
+            break;
+        }
+    }
+    int generation = m_thumbPoolGeneration;
+    if (!m_idleThumbProducers.empty()) {
+        prod = std::move(m_idleThumbProducers.back().first);
+        m_idleThumbProducers.pop_back();
+        lock.unlock();
+    } else {
+        m_thumbProducerCount++;
+        lock.unlock();
+        thumbProducerCreations.acquire();
+        prod = createThumbProducer();
+        thumbProducerCreations.release();
+        if (!prod) {
+            lock.relock();
+            if (generation == m_thumbPoolGeneration) {
+                m_thumbProducerCount--;
+                m_thumbProducerReleased.wakeOne();
+            }
+            return nullptr;
+        }
+    }
+    // The caller has exclusive use of the producer, it goes back to the pool when the last copy of the returned pointer is released
+    std::weak_ptr<ProjectClip> clip = std::static_pointer_cast<ProjectClip>(shared_from_this());
+    return std::shared_ptr<Mlt::Producer>(prod.get(), [clip, prod, generation](Mlt::Producer *) {
+        if (auto ptr = clip.lock()) {
+            ptr->releaseThumbProducer(prod, generation);
+        }
+    });
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::createThumbProducer()
+{
     QMutexLocker lock(&m_thumbMutex);
     std::shared_ptr<Mlt::Producer> prod = originalProducer();
     if (!prod->is_valid()) {
         return nullptr;
     }
+    std::shared_ptr<Mlt::Producer> thumbsProducer;
     if (KdenliveSettings::gpu_accel()) {
         // TODO: when the original producer changes, we must reload this thumb producer
-        m_thumbsProducer = softClone(ClipController::getPassPropertiesList());
+        thumbsProducer = softClone(ClipController::getPassPropertiesList());
         Mlt::Filter converter(*prod->profile(), "avcolor_space");
-        m_thumbsProducer->attach(converter);
+        thumbsProducer->attach(converter);
     } else {
         QString mltService = m_masterProducer->get("mlt_service");
         const QString mltResource = m_masterProducer->get("resource");
         if (mltService == QLatin1String("avformat")) {
             mltService = QStringLiteral("avformat-novalidate");
         }
-        m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
-        if (m_thumbsProducer->is_valid()) {
+        thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
+        if (thumbsProducer->is_valid()) {
             Mlt::Properties original(m_masterProducer->get_properties());
-            Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
+            Mlt::Properties cloneProps(thumbsProducer->get_properties());
             cloneProps.pass_list(original, ClipController::getPassPropertiesList());
             Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
             Mlt::Filter padder(*pCore->thumbProfile(), "resize");
             Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-            m_thumbsProducer->set("audio_index", -1);
+            thumbsProducer->set("audio_index", -1);
             // Required to make get_playtime() return > 1
-            m_thumbsProducer->set("out", m_thumbsProducer->get_length() -1);
-            m_thumbsProducer->attach(scaler);
-            m_thumbsProducer->attach(padder);
-            m_thumbsProducer->attach(converter);
+            thumbsProducer->set("out", thumbsProducer->get_length() -1);
+            thumbsProducer->attach(scaler);
+            thumbsProducer->attach(padder);
+            thumbsProducer->attach(converter);
+        }
+    }
+    if (thumbsProducer->is_valid()) {
+        ProducerCache::get()->touch(std::static_pointer_cast<ProjectClip>(shared_from_this()));
+    }
+    return thumbsProducer;
+}
+
+void ProjectClip::initThumbProducerPool()
+{
+    // The purge runs periodically while several producers are idle. It is not postponed by new requests, so that a clip
+    // being scrubbed still closes the producers it doesn't need anymore
+    m_thumbPoolTimer.setInterval(thumbProducerIdleTimeout / 4);
+    connect(&m_thumbPoolTimer, &QTimer::timeout, this, &ProjectClip::purgeIdleThumbProducers);
+}
+
+void ProjectClip::releaseThumbProducer(const std::shared_ptr<Mlt::Producer> &producer, int generation)
+{
+    QMutexLocker lock(&m_thumbPoolMutex);
+    if (generation != m_thumbPoolGeneration) {
+        // The clip was reloaded, drop this producer
+        return;
+    }
+    m_thumbProducerReleased.wakeOne();
+    if (!producer->is_valid()) {
+        m_thumbProducerCount--;
+        return;
+    }
+    QElapsedTimer lastUse;
+    lastUse.start();
+    m_idleThumbProducers.emplace_back(producer, lastUse);
+    if (m_idleThumbProducers.size() > 1) {
+        // Producers can be released from any thread, the timer lives in the clip's thread
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_thumbPoolTimer.isActive()) {
+                m_thumbPoolTimer.start();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ProjectClip::purgeIdleThumbProducers()
+{
+    std::vector<std::shared_ptr<Mlt::Producer>> expired;
+    QMutexLocker lock(&m_thumbPoolMutex);
+    // Keep the most recently used producer so that the next request does not have to reopen the file
+    auto it = m_idleThumbProducers.begin();
+    while (m_idleThumbProducers.size() > 1 && it != m_idleThumbProducers.end() - 1) {
+        if (it->second.hasExpired(thumbProducerIdleTimeout)) {
+            expired.push_back(std::move(it->first));
+            it = m_idleThumbProducers.erase(it);
+            m_thumbProducerCount--;
+        } else {
+            ++it;
         }
     }
-    return m_thumbsProducer;
+    if (m_idleThumbProducers.size() <= 1) {
+        m_thumbPoolTimer.stop();
+    }
+    lock.unlock();
+    // expired producers are closed here, outside of the lock
+}
+
+void ProjectClip::clearThumbProducers()
+{
+    std::vector<std::pair<std::shared_ptr<Mlt::Producer>, QElapsedTimer>> idle;
+    QMutexLocker lock(&m_thumbPoolMutex);
+    // Producers currently in use will be dropped when released
+    m_thumbPoolGeneration++;
+    m_thumbProducerCount = 0;
+    std::swap(idle, m_idleThumbProducers);
+    m_thumbProducerReleased.wakeAll();
 }
 
 void ProjectClip::createDisabledMasterProducer()
@@ -551,9 +685,35 @@ void ProjectClip::createDisabledMasterProducer()
         m_disabledProducer->set("set.test_audio", 1);
         m_disabledProducer->set("set.test_image", 1);
         m_effectStack->addService(m_disabledProducer);
+        ProducerCache::get()->touch(std::static_pointer_cast<ProjectClip>(shared_from_this()));
     }
 }
 
+void ProjectClip::releaseProducers()
+{
+    clearThumbProducers();
+    if (!m_registeredClips.empty()) {
+        // Timeline clips use the track producers
+        return;
+    }
+    if (m_disabledProducer) {
+        m_effectStack->removeService(m_disabledProducer);
+        m_disabledProducer.reset();
+    }
+    for (auto &p : m_audioProducers) {
+        m_effectStack->removeService(p.second);
+    }
+    for (auto &p : m_videoProducers) {
+        m_effectStack->removeService(p.second);
+    }
+    for (auto &p : m_timewarpProducers) {
+        m_effectStack->removeService(p.second);
+    }
+    m_audioProducers.clear();
+    m_videoProducers.clear();
+    m_timewarpProducers.clear();
+}
+
 std::shared_ptr<Mlt::Producer> ProjectClip::getTimelineProducer(int trackId, int clipId, PlaylistState::ClipState state, double speed)
 {
     if (!m_masterProducer) {
@@ -578,6 +738,7 @@ std::shared_ptr<Mlt::Producer> ProjectClip::getTimelineProducer(int trackId, int
                 m_audioProducers[trackId]->set("set.test_audio", 0);
                 m_audioProducers[trackId]->set("set.test_image", 1);
                 m_effectStack->addService(m_audioProducers[trackId]);
+                ProducerCache::get()->touch(std::static_pointer_cast<ProjectClip>(shared_from_this()));
             }
             return std::shared_ptr<Mlt::Producer>(m_audioProducers[trackId]->cut());
         }
@@ -593,6 +754,7 @@ std::shared_ptr<Mlt::Producer> ProjectClip::getTimelineProducer(int trackId, int
                 m_videoProducers[trackId]->set("set.test_audio", 1);
                 m_videoProducers[trackId]->set("set.test_image", 0);
                 m_effectStack->addService(m_videoProducers[trackId]);
+                ProducerCache::get()->touch(std::static_pointer_cast<ProjectClip>(shared_from_this()));
             }
             int duration = m_masterProducer->time_to_frames(m_masterProducer->get("kdenlive:duration"));
             return std::shared_ptr<Mlt::Producer>(m_videoProducers[trackId]->cut(-1, duration > 0 ? duration : -1));
@@ -1238,6 +1400,7 @@ void ProjectClip::discardAudioThumb()
     if (!audioThumbPath.isEmpty()) {
         QFile::remove(audioThumbPath);
     }
+    audioThumbnailsBytes -= audioFrameCache.size();
     audioFrameCache.clear();
     qCDebug(KDENLIVE_LOG) << "////////////////////  DISCARD AUIIO THUMBNS";
     m_audioThumbCreated = false;
@@ -28,9 +28,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "mltcontroller/clipcontroller.h"
 #include "timeline2/model/timelinemodel.hpp"
 
+#include <QElapsedTimer>
 #include <QFuture>
 #include <QMutex>
+#include <QTimer>
+#include <QWaitCondition>
 #include <memory>
+#include <vector>
 
 class ClipPropertiesController;
 class ProjectFolder;
@@ -149,7 +153,10 @@ public:
     /** @brief Returns true if this clip already has a producer. */
     bool isReady() const;
 
-    /** @brief Returns this clip's producer. */
+    /** @brief Returns a producer to extract thumbnails from this clip.
+     *  The producer is reserved to the caller until the returned pointer is released, so that several threads can seek and
+     *  decode the same clip concurrently. At most idealThreadCount() producers exist per clip, further callers wait for one to be released.
+     *  Released producers are kept in a small pool and closed after some idle time. */
     std::shared_ptr<Mlt::Producer> thumbProducer();
 
     /** @brief Recursively disable/enable bin effects. */
@@ -173,6 +180,8 @@ public:
     /** format is frame -> channel ->bytes */
     QVector<uint8_t> audioFrameCache;
     bool audioThumbCreated() const;
+    /** @brief Returns the memory used by the audio thumbnails of all clips, in bytes */
+    static qint64 audioThumbnailsSize();
 
     void setWaitingStatus(const QString &id);
     /** @brief Returns true if the clip matched a condition, for example vcodec=mpeg1video. */
@@ -225,6 +234,11 @@ public:
     /** @brief Display Bin thumbnail given a percent
      */
     void getThumbFromPercent(int percent);
+    /** @brief Close the producers opened on demand that are not in use: idle thumbnail producers and, if the clip is not in a timeline,
+        its disabled and track producers. They are reopened the next time they are requested. The master producer is kept.
+        Called by ProducerCache when the clip was not used recently, must be called from the main thread.
+    */
+    void releaseProducers();
 
 protected:
     friend class ClipModel;
@@ -260,9 +274,23 @@ public slots:
 private:
     /** @brief Generate and store file hash if not available. */
     const QString getFileHash();
-    std::shared_ptr<Mlt::Producer> m_thumbsProducer;
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
+    /** @brief Idle producers available for thumbnail extraction, with the time they were released */
+    std::vector<std::pair<std::shared_ptr<Mlt::Producer>, QElapsedTimer>> m_idleThumbProducers;
+    QMutex m_thumbPoolMutex;
+    /** @brief Incremented when the clip is reloaded, producers created before that are not returned to the pool */
+    int m_thumbPoolGeneration{0};
+    /** @brief Number of thumbnail producers of the current generation, idle or in use */
+    int m_thumbProducerCount{0};
+    QWaitCondition m_thumbProducerReleased;
+    QTimer m_thumbPoolTimer;
+    static const int thumbProducerIdleTimeout = 20000;
+    std::shared_ptr<Mlt::Producer> createThumbProducer();
+    void initThumbProducerPool();
+    void releaseThumbProducer(const std::shared_ptr<Mlt::Producer> &producer, int generation);
+    void purgeIdleThumbProducers();
+    void clearThumbProducers();
     QFuture<void> m_thumbThread;
     QList<int> m_requestedThumbs;
     const QString geometryWithOffset(const QString &data, int offset);
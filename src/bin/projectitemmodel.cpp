@@ -23,13 +23,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "projectitemmodel.h"
 #include "abstractprojectitem.h"
+#include "binclipindex.h"
 #include "binplaylist.hpp"
+#include "binsearchindex.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
 #include "filewatcher.hpp"
 #include "jobs/audiothumbjob.hpp"
 #include "jobs/jobmanager.h"
 #include "jobs/loadjob.hpp"
+#include "jobs/proxyclipjob.h"
 #include "jobs/thumbjob.hpp"
 #include "jobs/cachejob.hpp"
 #include "kdenlivesettings.h"
@@ -39,6 +42,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "projectclip.h"
 #include "projectfolder.h"
 #include "projectsubclip.h"
+#include "utils/memorybudget.hpp"
+#include "utils/producercache.hpp"
 #include "xml/xml.hpp"
 
 #include <KLocalizedString>
@@ -55,6 +60,8 @@ ProjectItemModel::ProjectItemModel(QObject *parent)
     , m_lock(QReadWriteLock::Recursive)
     , m_binPlaylist(new BinPlaylist())
     , m_fileWatcher(new FileWatcher())
+    , m_searchIndex(new BinSearchIndex())
+    , m_clipIndex(new BinClipIndex())
     , m_nextId(1)
     , m_blankThumb()
     , m_dragType(PlaylistState::Disabled)
@@ -65,6 +72,21 @@ ProjectItemModel::ProjectItemModel(QObject *parent)
     connect(m_fileWatcher.get(), &FileWatcher::binClipModified, this, &ProjectItemModel::reloadClip);
     connect(m_fileWatcher.get(), &FileWatcher::binClipWaiting, this, &ProjectItemModel::setClipWaiting);
     connect(m_fileWatcher.get(), &FileWatcher::binClipMissing, this, &ProjectItemModel::setClipInvalid);
+    // Keep the search index in sync. These connections are made before any view is attached, so the index is updated
+    // before the filter proxy reevaluates the changed rows
+    connect(this, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            QModelIndex ix = index(row, 0, topLeft.parent());
+            if (ix.isValid()) {
+                m_searchIndex->markDirty(int(ix.internalId()));
+            }
+        }
+    });
+    connect(this, &QAbstractItemModel::rowsInserted, this, [this]() { m_searchIndex->markStructureChanged(); });
+    connect(this, &QAbstractItemModel::rowsRemoved, this, [this]() { m_searchIndex->markStructureChanged(); });
+    connect(this, &QAbstractItemModel::rowsMoved, this, [this]() { m_searchIndex->markStructureChanged(); });
+    connect(this, &QAbstractItemModel::modelReset, this, [this]() { m_searchIndex->markStructureChanged(); });
+    m_memoryConsumer = MemoryBudget::get()->registerConsumer(i18n("Audio thumbnails"), []() { return ProjectClip::audioThumbnailsSize(); });
 }
 
 std::shared_ptr<ProjectItemModel> ProjectItemModel::construct(QObject *parent)
@@ -74,7 +96,10 @@ std::shared_ptr<ProjectItemModel> ProjectItemModel::construct(QObject *parent)
     return self;
 }
 
-ProjectItemModel::~ProjectItemModel() = default;
+ProjectItemModel::~ProjectItemModel()
+{
+    MemoryBudget::get()->unregisterConsumer(m_memoryConsumer);
+}
 
 int ProjectItemModel::mapToColumn(int column) const
 {
@@ -375,13 +400,7 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     if (binId.contains(QLatin1Char('_'))) {
         return getClipByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c);
-        }
-    }
-    return nullptr;
+    return m_clipIndex->clip(binId);
 }
 
 const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId)
@@ -484,6 +503,8 @@ void ProjectItemModel::clean()
     Q_ASSERT(rootItem->childCount() == 0);
     m_nextId = 1;
     m_fileWatcher->clear();
+    m_clipIndex->clear();
+    ProducerCache::get()->clear();
 }
 
 std::shared_ptr<ProjectFolder> ProjectItemModel::getRootFolder() const
@@ -594,9 +615,11 @@ void ProjectItemModel::registerItem(const std::shared_ptr<TreeItem> &item)
     auto clip = std::static_pointer_cast<AbstractProjectItem>(item);
     m_binPlaylist->manageBinItemInsertion(clip);
     AbstractTreeModel::registerItem(item);
+    m_searchIndex->addItem(clip);
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = std::static_pointer_cast<ProjectClip>(clip);
         updateWatcher(clipItem);
+        m_clipIndex->update(clipItem);
     }
 }
 void ProjectItemModel::deregisterItem(int id, TreeItem *item)
@@ -606,9 +629,12 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     m_binPlaylist->manageBinItemDeletion(clip);
     // TODO : here, we should suspend jobs belonging to the item we delete. They can be restarted if the item is reinserted by undo
     AbstractTreeModel::deregisterItem(id, item);
+    m_searchIndex->removeItem(id);
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = static_cast<ProjectClip *>(clip);
         m_fileWatcher->removeFile(clipItem->clipId());
+        m_clipIndex->remove(clipItem->clipId());
+        ProducerCache::get()->remove(clipItem->clipId());
     }
 }
 
@@ -866,16 +892,25 @@ std::vector<QString> ProjectItemModel::getAllClipIds() const
 QStringList ProjectItemModel::getClipByUrl(const QFileInfo &url) const
 {
     READ_LOCK();
-    QStringList result;
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem) {
-            if (QFileInfo(std::static_pointer_cast<ProjectClip>(c)->clipUrl()) == url) {
-                result << c->clipId();
-            }
-        }
-    }
-    return result;
+    return m_clipIndex->clipsByPath(url.filePath());
+}
+
+QStringList ProjectItemModel::getClipsByHash(const QString &hash) const
+{
+    READ_LOCK();
+    return m_clipIndex->clipsByHash(hash);
+}
+
+QList<std::shared_ptr<ProjectClip>> ProjectItemModel::getClipsByType(ClipType::ProducerType type) const
+{
+    READ_LOCK();
+    return m_clipIndex->clipsByType(type);
+}
+
+QList<std::shared_ptr<ProjectClip>> ProjectItemModel::getAllClips() const
+{
+    READ_LOCK();
+    return m_clipIndex->allClips();
 }
 
 bool ProjectItemModel::loadFolders(Mlt::Properties &folders)
@@ -1042,6 +1077,14 @@ void ProjectItemModel::reloadClip(const QString &binId)
     std::shared_ptr<ProjectClip> clip = getClipByBinID(binId);
     if (clip) {
         clip->reloadProducer();
+        if (clip->clipType() == ClipType::Playlist && clip->hasProxy()) {
+            // The nested sequence was edited, update its cached render once reloaded. Only the modified chunks are encoded again
+            int loadjobId = -1;
+            pCore->jobManager()->hasPendingJob(binId, AbstractClipJob::LOADJOB, &loadjobId);
+            pCore->jobManager()->discardJobs(binId, AbstractClipJob::PROXYJOB);
+            clip->setProducerProperty(QStringLiteral("_overwriteproxy"), 1);
+            pCore->jobManager()->startJob<ProxyJob>({binId}, loadjobId, QString());
+        }
     }
 }
 
@@ -1074,12 +1117,25 @@ void ProjectItemModel::updateWatcher(const std::shared_ptr<ProjectClip> &clipIte
     }
 }
 
+void ProjectItemModel::updateClipIndex(const std::shared_ptr<ProjectClip> &clipItem)
+{
+    QWriteLocker locker(&m_lock);
+    if (m_allItems.count(clipItem->getId()) > 0) {
+        m_clipIndex->update(clipItem);
+    }
+}
+
 void ProjectItemModel::setDragType(PlaylistState::ClipState type)
 {
     QWriteLocker locker(&m_lock);
     m_dragType = type;
 }
 
+BinSearchIndex *ProjectItemModel::searchIndex() const
+{
+    return m_searchIndex.get();
+}
+
 int ProjectItemModel::clipsCount() const
 {
     READ_LOCK();
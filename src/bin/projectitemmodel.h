@@ -34,7 +34,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSize>
 
 class AbstractProjectItem;
+class BinClipIndex;
 class BinPlaylist;
+class BinSearchIndex;
 class FileWatcher;
 class MarkerListModel;
 class ProjectClip;
@@ -72,6 +74,12 @@ public:
 
     /** @brief Returns a list of clips using the given url */
     QStringList getClipByUrl(const QFileInfo &url) const;
+    /** @brief Returns a list of clips whose file hash is @hash */
+    QStringList getClipsByHash(const QString &hash) const;
+    /** @brief Returns all the clips of the given type */
+    QList<std::shared_ptr<ProjectClip>> getClipsByType(ClipType::ProducerType type) const;
+    /** @brief Returns all the clips of the project, in no particular order */
+    QList<std::shared_ptr<ProjectClip>> getAllClips() const;
 
     /** @brief Helper to check whether a clip with a given id exists */
     bool hasClip(const QString &binId);
@@ -207,6 +215,9 @@ public:
     /** @brief Number of clips in the bin playlist */
     int clipsCount() const;
 
+    /** @brief Returns the index used to filter the bin views */
+    BinSearchIndex *searchIndex() const;
+
 protected:
     /* @brief Register the existence of a new element
      */
@@ -222,6 +233,8 @@ protected:
 
     /* @brief Function to be called when the url of a clip changes */
     void updateWatcher(const std::shared_ptr<ProjectClip> &item);
+    /* @brief Function to be called from the main thread when the producer of a clip changes (url, hash or type) */
+    void updateClipIndex(const std::shared_ptr<ProjectClip> &item);
 
 public slots:
     /** @brief An item in the list was modified, notify */
@@ -246,6 +259,12 @@ private:
 
     std::unique_ptr<FileWatcher> m_fileWatcher;
 
+    std::unique_ptr<BinSearchIndex> m_searchIndex;
+
+    std::unique_ptr<BinClipIndex> m_clipIndex;
+    /** @brief Id of the audio thumbnails in the MemoryBudget */
+    int m_memoryConsumer;
+
     int m_nextId;
     QIcon m_blankThumb;
     PlaylistState::ClipState m_dragType;
@@ -21,13 +21,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "projectsortproxymodel.h"
 #include "abstractprojectitem.h"
+#include "projectitemmodel.h"
 
 #include <QItemSelectionModel>
 
 ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
-    , m_searchType(0)
-    , m_searchRating(0)
+    , m_acceptedRevision(-1)
 {
     m_collator.setLocale(QLocale());
     m_collator.setCaseSensitivity(Qt::CaseInsensitive);
@@ -40,75 +40,19 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
 // Responsible for item sorting!
 bool ProjectSortProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    if (filterAcceptsRowItself(sourceRow, sourceParent)) {
+    if (m_filter.isEmpty()) {
         return true;
     }
-    // accept if any of the children is accepted on it's own merits
-    return hasAcceptedChildren(sourceRow, sourceParent);
-}
-
-bool ProjectSortProxyModel::filterAcceptsRowItself(int sourceRow, const QModelIndex &sourceParent) const
-{
-    for (int i = 0; i < 3; i++) {
-        QModelIndex index0 = sourceModel()->index(sourceRow, i, sourceParent);
-        if (!index0.isValid()) {
-            return false;
-        }
-        auto data = sourceModel()->data(index0);
-        if (m_searchRating > 0) {
-            // Column 7 contains the rating
-            QModelIndex indexTag = sourceModel()->index(sourceRow, 7, sourceParent);
-            if (sourceModel()->data(indexTag).toInt() < m_searchRating) {
-                return false;
-            }
-        }
-        if (m_searchType > 0) {
-            // Column 3 contains the item type (video, image, title, etc)
-            QModelIndex indexTag = sourceModel()->index(sourceRow, 3, sourceParent);
-            if (sourceModel()->data(indexTag).toInt() != m_searchType) {
-                return false;
-            }
-        }
-        if (!m_searchTag.isEmpty()) {
-            // Column 4 contains the item tag data
-            QModelIndex indexTag = sourceModel()->index(sourceRow, 4, sourceParent);
-            auto tagData = sourceModel()->data(indexTag);
-            for (const QString &tag : m_searchTag) {
-                if (!tagData.toString().contains(tag, Qt::CaseInsensitive)) {
-                    return false;
-                }
-            }
-        }
-        if (data.toString().contains(m_searchString, Qt::CaseInsensitive)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex &source_parent) const
-{
-    QModelIndex item = sourceModel()->index(sourceRow, 0, source_parent);
-    if (!item.isValid()) {
-        return false;
-    }
-
-    // check if there are children
-    int childCount = item.model()->rowCount(item);
-    if (childCount == 0) {
-        return false;
-    }
-
-    for (int i = 0; i < childCount; ++i) {
-        if (filterAcceptsRowItself(i, item)) {
-            return true;
-        }
-        // recursive call -> NOTICE that this is depth-first searching, you're probably better off with breadth first search...
-        if (hasAcceptedChildren(i, item)) {
-            return true;
-        }
+    auto *model = static_cast<ProjectItemModel *>(sourceModel());
+    BinSearchIndex *searchIndex = model->searchIndex();
+    int revision = searchIndex->revision();
+    if (revision != m_acceptedRevision) {
+        // Items are accepted if they match or if any of their children match
+        m_acceptedItems = searchIndex->visibleItems(m_filter);
+        m_acceptedRevision = revision;
     }
-    return false;
+    QModelIndex item = model->index(sourceRow, 0, sourceParent);
+    return item.isValid() && m_acceptedItems.count(int(item.internalId())) > 0;
 }
 
 bool ProjectSortProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
@@ -138,23 +82,26 @@ QItemSelectionModel *ProjectSortProxyModel::selectionModel()
 
 void ProjectSortProxyModel::slotSetSearchString(const QString &str)
 {
-    m_searchString = str;
+    m_filter.text = str;
+    m_acceptedRevision = -1;
     invalidateFilter();
 }
 
 void ProjectSortProxyModel::slotSetFilters(const QStringList tagFilters, const int rateFilters, const int typeFilters)
 {
-    m_searchType = typeFilters;
-    m_searchRating = rateFilters;
-    m_searchTag = tagFilters;
+    m_filter.type = typeFilters;
+    m_filter.rating = rateFilters;
+    m_filter.tags = tagFilters;
+    m_acceptedRevision = -1;
     invalidateFilter();
 }
 
 void ProjectSortProxyModel::slotClearSearchFilters()
 {
-    m_searchTag.clear();
-    m_searchRating = 0;
-    m_searchType = 0;
+    m_filter.tags.clear();
+    m_filter.rating = 0;
+    m_filter.type = 0;
+    m_acceptedRevision = -1;
     invalidateFilter();
 }
 
@@ -22,8 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PROJECTSORTPROXYMODEL_H
 #define PROJECTSORTPROXYMODEL_H
 
+#include "binsearchindex.h"
+
 #include <QCollator>
 #include <QSortFilterProxyModel>
+#include <unordered_set>
 
 class QItemSelectionModel;
 
@@ -62,15 +65,14 @@ protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
     /** @brief Reimplemented to show folders first  */
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
-    bool filterAcceptsRowItself(int source_row, const QModelIndex &source_parent) const;
-    bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
 
 private:
     QItemSelectionModel *m_selection;
-    QString m_searchString;
-    QStringList m_searchTag;
-    int m_searchType;
-    int m_searchRating;
+    BinSearchIndex::Filter m_filter;
+    /** @brief Items accepted by the current filter (matches and their ancestors), computed from the model's search index */
+    mutable std::unordered_set<int> m_acceptedItems;
+    /** @brief Search index revision m_acceptedItems was computed for, -1 if the filter changed since */
+    mutable int m_acceptedRevision;
     QCollator m_collator;
 
 signals:
@@ -29,6 +29,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
+#include "utils/thumbnailcache.hpp"
 
 #include <mlt++/MltRepository.h>
 
@@ -785,6 +786,8 @@ void Core::triggerAction(const QString &name)
 
 void Core::clean()
 {
+    // Done explicitly, the cache must not depend on the destruction order of the singletons
+    ThumbnailCache::get()->shutdown();
     m_self.reset();
 }
 
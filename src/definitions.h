@@ -133,7 +133,7 @@ enum MessageType { DefaultMessage, ProcessingJobMessage, OperationCompletedMessa
 
 enum TrackType { AudioTrack = 0, VideoTrack = 1, AnyTrack = 2 };
 
-enum CacheType { SystemCacheRoot = -1, CacheRoot = 0, CacheBase = 1, CachePreview = 2, CacheProxy = 3, CacheAudio = 4, CacheThumbs = 5 };
+enum CacheType { SystemCacheRoot = -1, CacheRoot = 0, CacheBase = 1, CachePreview = 2, CacheProxy = 3, CacheAudio = 4, CacheThumbs = 5, CacheSequence = 6 };
 
 enum TrimMode { NormalTrim, RippleTrim, RollingTrim, SlipTrim, SlideTrim };
 
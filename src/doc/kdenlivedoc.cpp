@@ -40,6 +40,7 @@
 #include "project/projectcommands.h"
 #include "titler/titlewidget.h"
 #include "transitions/transitionsrepository.hpp"
+#include "utils/proxycache.hpp"
 
 #include <config-kdenlive.h>
 
@@ -1186,6 +1187,11 @@ void KdenliveDoc::slotProxyCurrentItem(bool doProxy, QList<std::shared_ptr<Proje
         initProxySettings();
     }
     QString extension = QLatin1Char('.') + m_proxyExtension;
+    // Proxies are keyed by the encoding parameters so that projects sharing the proxy folder only reuse matching proxies
+    QString proxyParams = getDocumentProperty(QStringLiteral("proxyparams")).simplified();
+    if (proxyParams.isEmpty()) {
+        proxyParams = getAutoProxyProfile();
+    }
     // getDocumentProperty(QStringLiteral("proxyextension"));
     /*QString params = getDocumentProperty(QStringLiteral("proxyparams"));
     if (params.contains(QStringLiteral("-s "))) {
@@ -1238,7 +1244,21 @@ void KdenliveDoc::slotProxyCurrentItem(bool doProxy, QList<std::shared_ptr<Proje
                     }
                 }
                 if (path.isEmpty()) {
-                    path = dir.absoluteFilePath(item->hash() + (t == ClipType::Image ? QStringLiteral(".png") : extension));
+                    if (t == ClipType::Playlist) {
+                        // Nested sequences are cached in chunks, listed in an MLT playlist
+                        bool sequenceOk = false;
+                        QDir sequenceDir = getCacheDir(CacheSequence, &sequenceOk);
+                        if (sequenceOk) {
+                            path = sequenceDir.absoluteFilePath(ProxyCache::proxyName(item->hash(), proxyParams, QStringLiteral(".mlt")));
+                        }
+                    }
+                }
+                if (path.isEmpty()) {
+                    if (t == ClipType::Image) {
+                        path = ProxyCache::proxyPath(dir, item->hash(), QString::number(KdenliveSettings::proxyimagesize()), QStringLiteral(".png"));
+                    } else {
+                        path = ProxyCache::proxyPath(dir, item->hash(), proxyParams, extension);
+                    }
                 }
                 newProps.insert(QStringLiteral("kdenlive:proxy"), path);
                 // We need to insert empty proxy so that undo will work
@@ -1638,6 +1658,7 @@ void KdenliveDoc::initCacheDirs()
     dir.mkdir(QStringLiteral("preview"));
     dir.mkdir(QStringLiteral("audiothumbs"));
     dir.mkdir(QStringLiteral("videothumbs"));
+    dir.mkdir(QStringLiteral("sequences"));
     QDir cacheDir(kdenliveCacheDir);
     cacheDir.mkdir(QStringLiteral("proxy"));
 }
@@ -1678,6 +1699,9 @@ QDir KdenliveDoc::getCacheDir(CacheType type, bool *ok) const
     case CacheThumbs:
         basePath.append(QStringLiteral("/videothumbs"));
         break;
+    case CacheSequence:
+        basePath.append(QStringLiteral("/sequences"));
+        break;
     default:
         break;
     }
@@ -28,6 +28,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QImage>
 #include <QPixmap>
+#include <QVarLengthArray>
+
 // static
 QPixmap KThumb::getImage(const QUrl &url, int width, int height)
 {
@@ -111,15 +113,40 @@ QImage KThumb::getFrame(Mlt::Frame *frame, int width, int height, int scaledWidt
     int oh = height;
     mlt_image_format format = mlt_image_rgb24a;
     const uchar *imagedata = frame->get_image(format, ow, oh);
-    if (imagedata) {
-        QImage temp(ow, oh, QImage::Format_ARGB32);
-        memcpy(temp.scanLine(0), imagedata, (unsigned)(ow * oh * 4));
-        if (scaledWidth == 0 || scaledWidth == width) {
-            return temp.rgbSwapped();
+    if (imagedata == nullptr) {
+        return QImage();
+    }
+    // MLT's rgb24a byte order is Qt's RGBA8888, so the frame can be copied without swapping channels
+    const int targetWidth = (scaledWidth <= 0 || scaledWidth == ow) ? ow : scaledWidth;
+    QImage result(targetWidth, oh, QImage::Format_RGBA8888);
+    if (result.isNull()) {
+        return result;
+    }
+    const int sourceStride = ow * 4;
+    if (targetWidth == ow) {
+        if (result.bytesPerLine() == sourceStride) {
+            memcpy(result.bits(), imagedata, size_t(sourceStride) * size_t(oh));
+        } else {
+            for (int y = 0; y < oh; ++y) {
+                memcpy(result.scanLine(y), imagedata + y * sourceStride, size_t(sourceStride));
+            }
+        }
+        return result;
+    }
+    // Horizontal rescale (for non square pixels), done while copying so that the frame is only read once.
+    // Like the QImage::scaled() call it replaces, this uses nearest neighbour sampling
+    QVarLengthArray<int, 1024> sourceX(targetWidth);
+    for (int x = 0; x < targetWidth; ++x) {
+        sourceX[x] = int((qint64(x) * ow + ow / 2) / targetWidth);
+    }
+    for (int y = 0; y < oh; ++y) {
+        const auto *src = reinterpret_cast<const quint32 *>(imagedata + y * sourceStride);
+        auto *dest = reinterpret_cast<quint32 *>(result.scanLine(y));
+        for (int x = 0; x < targetWidth; ++x) {
+            dest[x] = src[sourceX[x]];
         }
-        return temp.rgbSwapped().scaled(scaledWidth, height);
     }
-    return QImage();
+    return result;
 }
 
 // static
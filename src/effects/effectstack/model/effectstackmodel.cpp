@@ -276,16 +276,49 @@ QDomElement EffectStackModel::rowToXml(int row, QDomDocument &document)
     return container;
 }
 
-bool EffectStackModel::fromXml(const QDomElement &effectsXml, Fun &undo, Fun &redo)
+std::vector<EffectStackModel::XmlEffect> EffectStackModel::parseXml(const QDomElement &effectsXml)
 {
+    std::vector<XmlEffect> result;
     QDomNodeList nodeList = effectsXml.elementsByTagName(QStringLiteral("effect"));
     int parentIn = effectsXml.attribute(QStringLiteral("parentIn")).toInt();
-    qDebug()<<"// GOT PREVIOUS PARENTIN: "<<parentIn<<"\n\n=======\n=======\n\n";
-    int currentIn = pCore->getItemIn(m_ownerId);
-    PlaylistState::ClipState state = pCore->getItemState(m_ownerId);
+    result.reserve(size_t(nodeList.count()));
     for (int i = 0; i < nodeList.count(); ++i) {
         QDomElement node = nodeList.item(i).toElement();
-        const QString effectId = node.attribute(QStringLiteral("id"));
+        XmlEffect effect;
+        effect.id = node.attribute(QStringLiteral("id"));
+        // Effects merged from several clips carry the in point of their own clip
+        effect.parentIn = node.hasAttribute(QStringLiteral("parentIn")) ? node.attribute(QStringLiteral("parentIn")).toInt() : parentIn;
+        if (Xml::hasXmlProperty(node, QLatin1String("disable"))) {
+            effect.enabled = Xml::getXmlProperty(node, QLatin1String("disable")).toInt() != 1;
+        }
+        effect.in = node.attribute(QStringLiteral("in"));
+        effect.out = node.attribute(QStringLiteral("out"));
+        QDomNodeList params = node.elementsByTagName(QStringLiteral("property"));
+        for (int j = 0; j < params.count(); j++) {
+            QDomElement pnode = params.item(j).toElement();
+            const QString pName = pnode.attribute(QStringLiteral("name"));
+            if (pName == QLatin1String("in") || pName == QLatin1String("out")) {
+                continue;
+            }
+            effect.parameters.append(QPair<QString, QString>(pName, pnode.text()));
+        }
+        result.push_back(effect);
+    }
+    return result;
+}
+
+bool EffectStackModel::fromXml(const QDomElement &effectsXml, Fun &undo, Fun &redo)
+{
+    return appendEffects(parseXml(effectsXml), undo, redo);
+}
+
+bool EffectStackModel::appendEffects(const std::vector<XmlEffect> &effects, Fun &undo, Fun &redo, bool notify)
+{
+    QWriteLocker locker(&m_lock);
+    int currentIn = pCore->getItemIn(m_ownerId);
+    PlaylistState::ClipState state = pCore->getItemState(m_ownerId);
+    for (const XmlEffect &data : effects) {
+        const QString &effectId = data.id;
         EffectType type = EffectsRepository::get()->getType(effectId);
         bool isAudioEffect = type == EffectType::Audio || type == EffectType::CustomAudio;
         if (isAudioEffect) {
@@ -295,32 +328,21 @@ bool EffectStackModel::fromXml(const QDomElement &effectsXml, Fun &undo, Fun &re
         } else if (state != PlaylistState::VideoOnly) {
             continue;
         }
-        bool effectEnabled = true;
-        if (Xml::hasXmlProperty(node, QLatin1String("disable"))) {
-            effectEnabled = Xml::getXmlProperty(node, QLatin1String("disable")).toInt() != 1;
-        }
-        auto effect = EffectItemModel::construct(effectId, shared_from_this(), effectEnabled);
-        const QString in = node.attribute(QStringLiteral("in"));
-        const QString out = node.attribute(QStringLiteral("out"));
-        if (!out.isEmpty()) {
-            effect->filter().set("in", in.toUtf8().constData());
-            effect->filter().set("out", out.toUtf8().constData());
+        auto effect = EffectItemModel::construct(effectId, shared_from_this(), data.enabled);
+        if (!data.out.isEmpty()) {
+            effect->filter().set("in", data.in.toUtf8().constData());
+            effect->filter().set("out", data.out.toUtf8().constData());
         }
         QStringList keyframeParams = effect->getKeyframableParameters();
         QVector<QPair<QString, QVariant>> parameters;
-        QDomNodeList params = node.elementsByTagName(QStringLiteral("property"));
-        for (int j = 0; j < params.count(); j++) {
-            QDomElement pnode = params.item(j).toElement();
-            const QString pName = pnode.attribute(QStringLiteral("name"));
-            if (pName == QLatin1String("in") || pName == QLatin1String("out")) {
-                continue;
-            }
-            if (keyframeParams.contains(pName)) {
+        parameters.reserve(data.parameters.size());
+        for (const auto &param : data.parameters) {
+            if (keyframeParams.contains(param.first)) {
                 // This is a keyframable parameter, fix offset
-                QString pValue = KeyframeModel::getAnimationStringWithOffset(effect, pnode.text(), currentIn - parentIn);
-                parameters.append(QPair<QString, QVariant>(pName, QVariant(pValue)));
+                QString pValue = KeyframeModel::getAnimationStringWithOffset(effect, param.second, currentIn - data.parentIn);
+                parameters.append(QPair<QString, QVariant>(param.first, QVariant(pValue)));
             } else {
-                parameters.append(QPair<QString, QVariant>(pName, QVariant(pnode.text())));
+                parameters.append(QPair<QString, QVariant>(param.first, QVariant(param.second)));
             }
         }
         effect->setParameters(parameters);
@@ -345,7 +367,7 @@ bool EffectStackModel::fromXml(const QDomElement &effectsXml, Fun &undo, Fun &re
         local_redo();
         UPDATE_UNDO_REDO(local_redo, local_undo, undo, redo);
     }
-    if (true) {
+    if (notify) {
         Fun update = [this]() {
             emit dataChanged(QModelIndex(), QModelIndex(), {});
             return true;
@@ -416,6 +438,17 @@ bool EffectStackModel::copyEffect(const std::shared_ptr<AbstractEffectItem> &sou
 }
 
 bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
+{
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    bool res = appendEffect(effectId, makeCurrent, undo, redo);
+    if (res) {
+        PUSH_UNDO(undo, redo, i18n("Add effect %1", EffectsRepository::get()->getName(effectId)));
+    }
+    return res;
+}
+
+bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent, Fun &undo, Fun &redo, bool notify)
 {
     QWriteLocker locker(&m_lock);
     std::unordered_set<int> previousFadeIn = m_fadeIns;
@@ -431,9 +464,9 @@ bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
         // Cannot add effect to this clip
         return false;
     }
-    Fun undo = removeItem_lambda(effect->getId());
+    Fun local_undo = removeItem_lambda(effect->getId());
     // TODO the parent should probably not always be the root
-    Fun redo = addItem_lambda(effect, rootItem->getId());
+    Fun local_redo = addItem_lambda(effect, rootItem->getId());
     effect->prepareKeyframes();
     connect(effect.get(), &AssetParameterModel::modelChanged, this, &EffectStackModel::modelChanged);
     connect(effect.get(), &AssetParameterModel::replugEffect, this, &EffectStackModel::replugEffect, Qt::DirectConnection);
@@ -443,7 +476,7 @@ bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
             srvPtr->set("kdenlive:activeeffect", rowCount());
         }
     }
-    bool res = redo();
+    bool res = local_redo();
     if (res) {
         int inFades = 0;
         int outFades = 0;
@@ -462,7 +495,10 @@ bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
         } else if (m_ownerId.first == ObjectType::TimelineTrack) {
             effect->filter().set("out", pCore->getItemDuration(m_ownerId));
         }
-        Fun update = [this, inFades, outFades]() {
+        Fun update = [this, inFades, outFades, notify]() {
+            if (!notify) {
+                return true;
+            }
             // TODO: only update if effect is fade or keyframe
             QVector<int> roles = {TimelineModel::EffectNamesRole};
             if (inFades > 0) {
@@ -474,7 +510,7 @@ bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
             emit dataChanged(QModelIndex(), QModelIndex(), roles);
             return true;
         };
-        Fun update_undo = [this, inFades, outFades, previousFadeIn, previousFadeOut]() {
+        Fun update_undo = [this, inFades, outFades, previousFadeIn, previousFadeOut, notify]() {
             // TODO: only update if effect is fade or keyframe
             QVector<int> roles = {TimelineModel::EffectNamesRole};
             if (inFades > 0) {
@@ -484,14 +520,16 @@ bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
                 m_fadeOuts = previousFadeOut;
                 roles << TimelineModel::FadeOutRole;
             }
-            pCore->updateItemKeyframes(m_ownerId);
-            emit dataChanged(QModelIndex(), QModelIndex(), roles);
+            if (notify) {
+                pCore->updateItemKeyframes(m_ownerId);
+                emit dataChanged(QModelIndex(), QModelIndex(), roles);
+            }
             return true;
         };
         update();
-        PUSH_LAMBDA(update, redo);
-        PUSH_LAMBDA(update_undo, undo);
-        PUSH_UNDO(undo, redo, i18n("Add effect %1", EffectsRepository::get()->getName(effectId)));
+        PUSH_LAMBDA(update, local_redo);
+        PUSH_LAMBDA(update_undo, local_undo);
+        UPDATE_UNDO_REDO(local_redo, local_undo, undo, redo);
     } else if (makeCurrent) {
         if (auto srvPtr = m_masterService.lock()) {
             srvPtr->set("kdenlive:activeeffect", currentActive);
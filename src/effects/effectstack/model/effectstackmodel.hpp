@@ -30,6 +30,7 @@
 #include <memory>
 #include <mlt++/Mlt.h>
 #include <unordered_set>
+#include <vector>
 
 /* @brief This class an effect stack as viewed by the back-end.
    It is responsible for planting and managing effects into the list of producer it holds a pointer to.
@@ -58,8 +59,29 @@ protected:
     EffectStackModel(std::weak_ptr<Mlt::Service> service, ObjectId ownerId, std::weak_ptr<DocUndoStack> undo_stack);
 
 public:
+    /* @brief Pre-parsed xml description of an effect, so that the same stack can be applied to many items without parsing the xml again */
+    struct XmlEffect
+    {
+        QString id;
+        bool enabled{true};
+        QString in;
+        QString out;
+        int parentIn{0};
+        QVector<QPair<QString, QString>> parameters;
+    };
+    /* @brief Parse the effects contained in an xml representation of a stack (as produced by toXml) */
+    static std::vector<XmlEffect> parseXml(const QDomElement &effectsXml);
+
     /* @brief Add an effect at the bottom of the stack */
     bool appendEffect(const QString &effectId, bool makeCurrent = false);
+    /* @brief Add an effect at the bottom of the stack, storing the operation in the given undo/redo lambdas instead of pushing an undo command.
+       @param notify if false, no data change is emitted and the caller is responsible for notifying the owner's views
+    */
+    bool appendEffect(const QString &effectId, bool makeCurrent, Fun &undo, Fun &redo, bool notify = true);
+    /* @brief Append pre-parsed effects at the bottom of the stack, storing the operations in the given undo/redo lambdas.
+       @param notify if false, no data change is emitted and the caller is responsible for notifying the owner's views
+    */
+    bool appendEffects(const std::vector<XmlEffect> &effects, Fun &undo, Fun &redo, bool notify = true);
     /* @brief Copy an existing effect and append it at the bottom of the stack
      */
     bool copyEffect(const std::shared_ptr<AbstractEffectItem> &sourceItem, PlaylistState::ClipState state);
@@ -29,10 +29,10 @@
 #include "klocalizedstring.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
+#include "processrunner.hpp"
 #include "utils/thumbnailcache.hpp"
 #include <QScopedPointer>
 #include <QTemporaryFile>
-#include <QProcess>
 #include <memory>
 #include <mlt++/MltProducer.h>
 
@@ -117,24 +117,16 @@ bool AudioThumbJob::computeWithFFMPEG()
     if (filePath.isEmpty()) {
         filePath = m_prod->get("resource");
     }
-    m_ffmpegProcess.reset(new QProcess);
+    m_ffmpegProcess.reset(new ProcessRunner);
+    connect(m_ffmpegProcess.get(), &ProcessRunner::standardOutputLine, this, &AudioThumbJob::updateFfmpegProgress, Qt::DirectConnection);
+    connect(this, &AudioThumbJob::jobCanceled, m_ffmpegProcess.get(), &ProcessRunner::cancel, Qt::DirectConnection);
     if (!m_thumbInCache) {
         QStringList args;
         args << QStringLiteral("-hide_banner") << QStringLiteral("-y")<< QStringLiteral("-i") << QUrl::fromLocalFile(filePath).toLocalFile() << QStringLiteral("-filter_complex:a");
         args << QString("showwavespic=s=%1x%2:split_channels=1:scale=cbrt:colors=0xffdddd|0xddffdd").arg(m_thumbSize.width()).arg(m_thumbSize.height());
         args << QStringLiteral("-frames:v") << QStringLiteral("1");
         args << m_binClip->getAudioThumbPath(true);
-        connect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress, Qt::UniqueConnection);
-        connect(this, &AudioThumbJob::jobCanceled, [&] () {
-            if (m_ffmpegProcess) {
-                m_ffmpegProcess->kill();
-            }
-            m_done = true;
-            m_successful = false;
-        });
-        m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
-        m_ffmpegProcess->waitForFinished(-1);
-        if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
+        if (m_ffmpegProcess->execute(KdenliveSettings::ffmpegpath(), args)) {
             m_thumbInCache = true;
             if (m_dataInCache) {
                 m_done = true;
@@ -145,6 +137,10 @@ bool AudioThumbJob::computeWithFFMPEG()
             }
         }
     }
+    if (m_ffmpegProcess->isCanceled()) {
+        m_done = true;
+        m_successful = false;
+    }
     if (!m_dataInCache && !m_done) {
         m_audioLevels.clear();
         std::vector<std::unique_ptr<QTemporaryFile>> channelFiles;
@@ -190,16 +186,7 @@ bool AudioThumbJob::computeWithFFMPEG()
                  << QStringLiteral("-f") << QStringLiteral("data") << channelFiles[size_t(i)]->fileName();
             }
         }
-        m_ffmpegProcess.reset(new QProcess);
-        connect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress, Qt::UniqueConnection);
-        connect(this, &AudioThumbJob::jobCanceled, [&]() {
-            if (m_ffmpegProcess) {
-                m_ffmpegProcess->kill();
-            }
-        });
-        m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
-        m_ffmpegProcess->waitForFinished(-1);
-        if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
+        if (m_ffmpegProcess->execute(KdenliveSettings::ffmpegpath(), args)) {
             int dataSize = 0;
             std::vector<const qint16 *> rawChannels;
             std::vector<QByteArray> sourceChannels;
@@ -260,7 +247,7 @@ bool AudioThumbJob::computeWithFFMPEG()
             return true;
         }
     }
-    QString err = m_ffmpegProcess->readAllStandardError();
+    QString err = m_ffmpegProcess->errorOutput();
     m_ffmpegProcess.reset();
     // m_errorMessage += err;
     // m_errorMessage.append(i18n("Failed to create FFmpeg audio thumbnails, we now try to use MLT"));
@@ -268,17 +255,13 @@ bool AudioThumbJob::computeWithFFMPEG()
     return false;
 }
 
-void AudioThumbJob::updateFfmpegProgress()
+void AudioThumbJob::updateFfmpegProgress(const QString &data)
 {
-    QString result = m_ffmpegProcess->readAllStandardOutput();
-    const QStringList lines = result.split(QLatin1Char('\n'));
-    for (const QString &data : lines) {
-        if (data.startsWith(QStringLiteral("out_time_ms"))) {
-            double ms = data.section(QLatin1Char('='), 1).toDouble();
-            emit jobProgress((int)(ms / m_binClip->duration().ms() / 10));
-        } else {
-            m_logDetails += data + QStringLiteral("\n");
-        }
+    if (data.startsWith(QStringLiteral("out_time_ms"))) {
+        double ms = data.section(QLatin1Char('='), 1).toDouble();
+        emit jobProgress((int)(ms / m_binClip->duration().ms() / 10));
+    } else {
+        m_logDetails += data + QStringLiteral("\n");
     }
 }
 
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "abstractclipjob.h"
+#include "processrunner.hpp"
 
 #include <memory>
 #include <QImage>
@@ -33,7 +34,6 @@ class ProjectClip;
 namespace Mlt {
 class Producer;
 }
-class QProcess;
 class AudioThumbJob : public AbstractClipJob
 {
     Q_OBJECT
@@ -58,8 +58,8 @@ protected:
     // MLT audio thumbs: slower but safer
     bool computeWithMlt();
 
-    // process the stdout/stderr from ffmpeg
-    void updateFfmpegProgress();
+    // process a line of the stdout from ffmpeg
+    void updateFfmpegProgress(const QString &data);
 
 private:
     std::shared_ptr<ProjectClip> m_binClip;
@@ -73,5 +73,5 @@ private:
     bool m_done{false}, m_successful{false};
     int m_channels, m_frequency, m_lengthInFrames, m_audioStream;
     QVector <uint8_t>m_audioLevels;
-    std::unique_ptr<QProcess> m_ffmpegProcess;
+    std::unique_ptr<ProcessRunner> m_ffmpegProcess;
 };
@@ -32,7 +32,18 @@
 #include <QScopedPointer>
 #include <mlt++/MltProducer.h>
 
+#include <map>
 #include <set>
+#include <vector>
+
+// MLT's avformat producer decodes forward instead of seeking when the requested frame is less than this many frames ahead
+static const int FORWARD_DECODE_LIMIT = 12;
+
+// Video codecs where each frame is a keyframe, so that seeking is always cheap
+static const QStringList intraOnlyCodecs = {QStringLiteral("prores"),   QStringLiteral("dnxhd"),    QStringLiteral("mjpeg"), QStringLiteral("png"),
+                                            QStringLiteral("tiff"),     QStringLiteral("dvvideo"),  QStringLiteral("ffv1"),  QStringLiteral("huffyuv"),
+                                            QStringLiteral("rawvideo"), QStringLiteral("v210"),     QStringLiteral("cfhd"),  QStringLiteral("utvideo"),
+                                            QStringLiteral("qtrle"),    QStringLiteral("jpeg2000"), QStringLiteral("gif")};
 
 CacheJob::CacheJob(const QString &binId, int thumbsCount, int inPoint, int outPoint)
     : AbstractClipJob(CACHEJOB, binId)
@@ -79,8 +90,9 @@ bool CacheJob::startJob()
         m_done = true;
         return true;
     }
-    m_prod = m_binClip->thumbProducer();
-    if ((m_prod == nullptr) || !m_prod->is_valid()) {
+    // The producer is leased from the clip's pool, it must be released when the job returns since finished jobs are kept
+    std::shared_ptr<Mlt::Producer> prod = m_binClip->thumbProducer();
+    if ((prod == nullptr) || !prod->is_valid()) {
         qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
         return false;
     }
@@ -92,31 +104,80 @@ bool CacheJob::startJob()
     for (int i = 1; i <= m_thumbsCount; ++i) {
         frames.insert(m_inPoint + (duration * i / m_thumbsCount));
     }
-    int size = (int)frames.size();
-    int count = 0;
+    // Group the requested positions by the frame that will actually be decoded for them
+    const int gop = keyframeInterval();
+    const int lastFrame = m_inPoint + duration;
+    std::map<int, std::vector<int>> plan;
     for (int i : frames) {
+        if (ThumbnailCache::get()->hasThumbnail(m_clipId, i)) {
+            continue;
+        }
+        int decodePos = i;
+        if (gop > 1) {
+            decodePos = qBound(m_inPoint, qRound(double(i) / gop) * gop, lastFrame);
+        }
+        plan[decodePos].push_back(i);
+    }
+    if (plan.empty()) {
+        m_done = true;
+        return true;
+    }
+    int thumbs = 0;
+    for (const auto &item : plan) {
+        thumbs += (int)item.second.size();
+    }
+    int size = (int)frames.size();
+    int count = size - thumbs;
+    int lastPos = -1;
+    for (const auto &item : plan) {
         if (m_done) {
             break;
         }
         emit jobProgress(100 * count / size);
-        count++;
-        if (ThumbnailCache::get()->hasThumbnail(m_clipId, i)) {
-            continue;
+        const int pos = item.first;
+        if (lastPos >= 0 && pos > lastPos && pos - lastPos < FORWARD_DECODE_LIMIT) {
+            // Continue decoding from the previous position
+            for (int p = lastPos + 1; p < pos && !m_done; ++p) {
+                prod->seek(p);
+                QScopedPointer<Mlt::Frame> skipped(prod->get_frame());
+                if (skipped != nullptr && skipped->is_valid()) {
+                    // Fetching the image is what drives the decoder
+                    mlt_image_format format = mlt_image_yuv422;
+                    int width = m_imageWidth;
+                    int height = m_imageHeight;
+                    skipped->get_image(format, width, height);
+                }
+            }
         }
-        m_prod->seek(i);
-        QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
-        frame->set("deinterlace_method", "onefield");
-        frame->set("top_field_first", -1);
-        frame->set("rescale.interp", "nearest");
+        lastPos = pos;
+        count += (int)item.second.size();
+        prod->seek(pos);
+        QScopedPointer<Mlt::Frame> frame(prod->get_frame());
         if (frame != nullptr && frame->is_valid()) {
+            frame->set("deinterlace_method", "onefield");
+            frame->set("top_field_first", -1);
+            frame->set("rescale.interp", "nearest");
             QImage result = KThumb::getFrame(frame.data(), m_imageWidth, m_imageHeight, m_fullWidth);
-            ThumbnailCache::get()->storeThumbnail(m_clipId, i, result, true);
+            // Store under the requested positions, which are the ones looked up on the next run
+            for (int i : item.second) {
+                ThumbnailCache::get()->storeThumbnail(m_clipId, i, result, true);
+            }
         }
     }
     m_done = true;
     return true;
 }
 
+int CacheJob::keyframeInterval() const
+{
+    const QString codec = m_binClip->codec(false);
+    if (codec.isEmpty() || intraOnlyCodecs.contains(codec)) {
+        return 1;
+    }
+    // MLT does not expose the keyframe positions, assume the usual 1 second interval of long GOP sources
+    return qMax(1, qRound(m_binClip->getOriginalFps()));
+}
+
 bool CacheJob::commitResult(Fun &undo, Fun &redo)
 {
     Q_UNUSED(undo)
@@ -38,9 +38,11 @@ class CacheJob : public AbstractClipJob
     Q_OBJECT
 
 public:
-    /* @brief Extract a thumb for given clip.
-       @param frameNumber is the frame to extract. Leave to -1 for default
-       @param persistent: if true, we will use the persistent cache (for query and saving)
+    /* @brief Extract evenly spaced thumbs for given clip.
+       @param thumbsCount is the number of thumbs to extract
+       @param inPoint / outPoint is the zone to use, leave outPoint to 0 for the whole clip
+       For long GOP sources, the positions are snapped to the (estimated) keyframes to avoid decoding from the
+       previous keyframe for each thumb. The images are stored under the requested positions.
     */
     CacheJob(const QString &binId, int thumbsCount = 10, int inPoint = 0, int outPoint = 0);
 
@@ -53,12 +55,14 @@ public:
     bool commitResult(Fun &undo, Fun &redo) override;
 
 private:
+    /** @brief Returns the estimated keyframe interval of the clip, 1 for intra-only codecs */
+    int keyframeInterval() const;
+
     int m_imageHeight;
     int m_imageWidth;
     int m_fullWidth;
 
     std::shared_ptr<ProjectClip> m_binClip;
-    std::shared_ptr<Mlt::Producer> m_prod;
 
     bool m_done{false};
     int m_thumbsCount;
@@ -31,6 +31,7 @@
 #include "macros.hpp"
 #include "profiles/profilemodel.hpp"
 #include "project/dialogs/slideshowclip.h"
+#include "utils/probecache.hpp"
 #include "effects/effectsrepository.hpp"
 #include "effects/effectstack/model/effectstackmodel.hpp"
 #include "monitor/monitor.h"
@@ -384,12 +385,23 @@ bool LoadJob::startJob()
         m_producer = std::make_shared<Mlt::Producer>(pCore->getCurrentProfile()->profile(), nullptr, m_resource.toUtf8().constData());
         break;
     default:
+        if (service.startsWith(QLatin1String("avformat"))) {
+            // Skip opening and probing the file if it is unchanged since last time
+            m_producer = ProbeCache::get()->restore(pCore->getCurrentProfile()->profile(), m_resource);
+            m_probeCached = m_producer != nullptr;
+            if (m_probeCached) {
+                break;
+            }
+        }
         if (!service.isEmpty()) {
             service.append(QChar(':'));
             m_producer = loadResource(m_resource, service);
         } else {
             m_producer = std::make_shared<Mlt::Producer>(pCore->getCurrentProfile()->profile(), nullptr, m_resource.toUtf8().constData());
         }
+        if (m_producer->is_valid() && qstrcmp(m_producer->get("mlt_service"), "avformat") == 0) {
+            ProbeCache::get()->store(m_resource, *m_producer.get());
+        }
         break;
     }
     if (!m_producer || m_producer->is_blank() || !m_producer->is_valid()) {
@@ -485,6 +497,9 @@ bool LoadJob::startJob()
             m_producer->set("out", fixedLength - 1);
         }
     } else if (mltService == QLatin1String("avformat")) {
+        if (m_probeCached) {
+            ProbeCache::get()->revalidate(m_resource, m_clipId);
+        }
         // check if there are multiple streams
         vindex = m_producer->get_int("video_index");
         // List streams
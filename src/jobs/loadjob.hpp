@@ -78,4 +78,6 @@ private:
     std::shared_ptr<Mlt::Producer> m_producer;
     QList<int> m_audio_list, m_video_list;
     QString m_resource;
+    // True if the producer was built from the probe cache, without opening the file
+    bool m_probeCached{false};
 };
@@ -0,0 +1,225 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "processrunner.hpp"
+
+#include <QEventLoop>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace {
+/** @brief Encoder slots shared by all the jobs of the application */
+struct EncoderSlots
+{
+    QMutex mutex;
+    QWaitCondition released;
+    int processes = 0;
+    int threads = 0;
+    const int maxProcesses = qMax(1, QThread::idealThreadCount() / 4);
+    const int maxThreads = qMax(1, QThread::idealThreadCount());
+};
+
+EncoderSlots &encoderSlots()
+{
+    static EncoderSlots encoders;
+    return encoders;
+}
+
+// Maximum size of the error output kept to report failures
+const int maxErrorTail = 4096;
+} // namespace
+
+ProcessRunner::ProcessRunner(QObject *parent)
+    : QObject(parent)
+    , m_process(nullptr)
+    , m_canceled(false)
+    , m_threads(0)
+    , m_exitCode(0)
+    , m_exitStatus(QProcess::NormalExit)
+{
+}
+
+ProcessRunner::~ProcessRunner()
+{
+    releaseSlot();
+}
+
+int ProcessRunner::defaultThreadCount()
+{
+    int threadCount = QThread::idealThreadCount();
+    if (threadCount > 2) {
+        threadCount = qMin(threadCount - 1, 4);
+    } else {
+        threadCount = 1;
+    }
+    return threadCount;
+}
+
+int ProcessRunner::acquireSlot(int threads)
+{
+    if (m_threads > 0) {
+        return m_threads;
+    }
+    EncoderSlots &encoders = encoderSlots();
+    threads = qBound(1, threads, encoders.maxThreads);
+    QMutexLocker lock(&encoders.mutex);
+    bool released = false;
+    while (!m_canceled && (encoders.processes >= encoders.maxProcesses || encoders.threads + threads > encoders.maxThreads)) {
+        if (!released) {
+            // Let the pool start another job while we wait
+            QThreadPool::globalInstance()->releaseThread();
+            released = true;
+        }
+        // Wake up regularly to check for cancelation
+        encoders.released.wait(&encoders.mutex, 200);
+    }
+    if (released) {
+        QThreadPool::globalInstance()->reserveThread();
+    }
+    if (m_canceled) {
+        return 0;
+    }
+    encoders.processes++;
+    encoders.threads += threads;
+    m_threads = threads;
+    return m_threads;
+}
+
+void ProcessRunner::releaseSlot()
+{
+    if (m_threads == 0) {
+        return;
+    }
+    EncoderSlots &encoders = encoderSlots();
+    QMutexLocker lock(&encoders.mutex);
+    encoders.processes--;
+    encoders.threads -= m_threads;
+    m_threads = 0;
+    encoders.released.wakeAll();
+}
+
+bool ProcessRunner::execute(const QString &program, const QStringList &arguments)
+{
+    m_exitCode = -1;
+    m_exitStatus = QProcess::CrashExit;
+    m_outputBuffer.clear();
+    m_errorBuffer.clear();
+    m_errorTail.clear();
+    QProcess process;
+    QEventLoop loop;
+    connect(&process, &QProcess::readyReadStandardOutput, this, [this, &process]() { splitLines(process.readAllStandardOutput(), m_outputBuffer, false); });
+    connect(&process, &QProcess::readyReadStandardError, this, [this, &process]() { splitLines(process.readAllStandardError(), m_errorBuffer, true); });
+    connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop, &QEventLoop::quit);
+    connect(&process, &QProcess::errorOccurred, &loop, [&loop](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            loop.quit();
+        }
+    });
+    m_process = &process;
+    bool started = false;
+    if (!m_canceled) {
+        process.start(program, arguments, QIODevice::ReadOnly);
+        started = process.waitForStarted(-1);
+    }
+    if (started && process.state() != QProcess::NotRunning) {
+        // The process now runs on its own, let the pool use this thread slot for other jobs
+        QThreadPool::globalInstance()->releaseThread();
+        loop.exec();
+        QThreadPool::globalInstance()->reserveThread();
+    }
+    m_process = nullptr;
+    if (started) {
+        // Flush the last lines, which may not end with a newline
+        splitLines(process.readAllStandardOutput() + '\n', m_outputBuffer, false);
+        splitLines(process.readAllStandardError() + '\n', m_errorBuffer, true);
+        m_exitCode = process.exitCode();
+        m_exitStatus = process.exitStatus();
+    } else {
+        m_errorTail = process.errorString().toUtf8();
+    }
+    releaseSlot();
+    return started && !m_canceled && m_exitStatus == QProcess::NormalExit;
+}
+
+void ProcessRunner::cancel()
+{
+    m_canceled = true;
+    encoderSlots().released.wakeAll();
+    // The process lives in the runner's thread, kill it from there
+    QMetaObject::invokeMethod(this, "killProcess", Qt::QueuedConnection);
+}
+
+void ProcessRunner::killProcess()
+{
+    if (m_process) {
+        m_process->kill();
+    }
+}
+
+bool ProcessRunner::isCanceled() const
+{
+    return m_canceled;
+}
+
+int ProcessRunner::exitCode() const
+{
+    return m_exitCode;
+}
+
+QProcess::ExitStatus ProcessRunner::exitStatus() const
+{
+    return m_exitStatus;
+}
+
+QString ProcessRunner::errorOutput() const
+{
+    return QString::fromUtf8(m_errorTail);
+}
+
+void ProcessRunner::splitLines(const QByteArray &data, QByteArray &buffer, bool errorChannel)
+{
+    if (errorChannel) {
+        m_errorTail.append(data);
+        if (m_errorTail.size() > maxErrorTail) {
+            m_errorTail.remove(0, m_errorTail.size() - maxErrorTail);
+        }
+    }
+    buffer.append(data);
+    int start = 0;
+    for (int i = 0; i < buffer.size(); ++i) {
+        const char c = buffer.at(i);
+        if (c != '\n' && c != '\r') {
+            continue;
+        }
+        if (i > start) {
+            const QString line = QString::fromUtf8(buffer.constData() + start, i - start);
+            if (errorChannel) {
+                emit standardErrorLine(line);
+            } else {
+                emit standardOutputLine(line);
+            }
+        }
+        start = i + 1;
+    }
+    buffer.remove(0, start);
+}
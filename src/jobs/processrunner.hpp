@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <atomic>
+
+/** @class ProcessRunner
+    @brief Runs an external encoder (FFmpeg, melt) on behalf of a clip job.
+    Instead of blocking in QProcess::waitForFinished, the job's thread waits on a local event loop and is handed back to the global
+    thread pool for the duration of the process, so that long transcodes do not starve short thumbnail or load jobs.
+    Output is split in lines as it arrives, so that progress can be parsed incrementally.
+    The number of encoder processes running at the same time, and the total number of threads they are allowed to use, are capped
+    for the whole application. Short analysis processes (audio thumbnails) do not reserve a slot, so they never wait behind encodes.
+ */
+class ProcessRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessRunner(QObject *parent = nullptr);
+    ~ProcessRunner() override;
+
+    /** @brief Wait until an encoder slot is available and reserve it.
+        @param threads is the number of threads the encoder would like to use
+        Returns the number of threads granted to the encoder, or 0 if the runner was canceled while waiting */
+    int acquireSlot(int threads = defaultThreadCount());
+    /** @brief Start the program and wait for it to exit, then release the encoder slot if one was acquired.
+        Only encoders go through acquireSlot, other processes like analysis tools start immediately.
+        Returns true if the process exited normally */
+    bool execute(const QString &program, const QStringList &arguments);
+    /** @brief Kill the running process, or abort the wait for a slot. Can be called from any thread */
+    void cancel();
+    bool isCanceled() const;
+
+    int exitCode() const;
+    QProcess::ExitStatus exitStatus() const;
+    /** @brief Returns the end of the error output of the last process */
+    QString errorOutput() const;
+
+    /** @brief The number of threads an encoder should use by default */
+    static int defaultThreadCount();
+
+signals:
+    void standardOutputLine(const QString &line);
+    void standardErrorLine(const QString &line);
+
+private slots:
+    void killProcess();
+
+private:
+    void releaseSlot();
+    /** @brief Emit each complete line of data, keeping the incomplete end in buffer. FFmpeg statistics end with a carriage return */
+    void splitLines(const QByteArray &data, QByteArray &buffer, bool errorChannel);
+
+    QProcess *m_process;
+    std::atomic<bool> m_canceled;
+    int m_threads;
+    int m_exitCode;
+    QProcess::ExitStatus m_exitStatus;
+    QByteArray m_outputBuffer;
+    QByteArray m_errorBuffer;
+    QByteArray m_errorTail;
+};
@@ -27,10 +27,14 @@
 #include "kdenlive_debug.h"
 #include "kdenlivesettings.h"
 #include "macros.hpp"
+#include "processrunner.hpp"
+#include "profiles/profilemodel.hpp"
+#include "utils/proxycache.hpp"
+#include "utils/sequencecache.hpp"
 
-#include <QProcess>
 #include <QTemporaryFile>
-#include <QThread>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
 
 #include <klocalizedstring.h>
 
@@ -38,8 +42,9 @@ ProxyJob::ProxyJob(const QString &binId)
     : AbstractClipJob(PROXYJOB, binId)
     , m_jobDuration(0)
     , m_isFfmpegJob(true)
-    , m_jobProcess(nullptr)
     , m_done(false)
+    , m_chunkCount(0)
+    , m_renderedChunks(0)
 {
 }
 
@@ -52,14 +57,20 @@ bool ProxyJob::startJob()
 {
     auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
     const QString dest = binClip->getProducerProperty(QStringLiteral("kdenlive:proxy"));
-    QFileInfo fInfo(dest);
-    if (binClip->getProducerIntProperty(QStringLiteral("_overwriteproxy")) == 0 && fInfo.exists() && fInfo.size() > 0) {
-        // Proxy clip already created
+    ClipType::ProducerType type = binClip->clipType();
+    // The proxy of a nested sequence is a playlist of chunks, which are checked even if the playlist exists
+    bool sequence = type == ClipType::Playlist && dest.endsWith(QLatin1String(".mlt"));
+    if (!sequence && binClip->getProducerIntProperty(QStringLiteral("_overwriteproxy")) == 0 && ProxyCache::get()->use(dest)) {
+        // Proxy clip already created, possibly by another project
         m_done = true;
         return true;
     }
-    ClipType::ProducerType type = binClip->clipType();
+    // Encode to a partial file, moved to dest once complete
+    const QString output = ProxyCache::partialPath(dest);
     bool result;
+    ProcessRunner runner;
+    connect(this, &ProxyJob::jobCanceled, &runner, &ProcessRunner::cancel, Qt::DirectConnection);
+    connect(&runner, &ProcessRunner::standardErrorLine, this, &ProxyJob::processLogInfo, Qt::DirectConnection);
     QString source = binClip->getProducerProperty(QStringLiteral("kdenlive:originalurl"));
     int exif = binClip->getProducerIntProperty(QStringLiteral("_exif_orientation"));
     if (type == ClipType::Playlist || type == ClipType::SlideShow) {
@@ -69,8 +80,10 @@ bool ProxyJob::startJob()
         QTemporaryFile *playlist = nullptr;
         // set clip origin
         if (type == ClipType::Playlist) {
-            // Special case: playlists use the special 'consumer' producer to support resizing
-            source.prepend(QStringLiteral("consumer:"));
+            if (!sequence) {
+                // Special case: playlists use the special 'consumer' producer to support resizing
+                source.prepend(QStringLiteral("consumer:"));
+            }
         } else {
             // create temporary playlist to generate proxy
             // we save a temporary .mlt clip for rendering
@@ -87,7 +100,7 @@ bool ProxyJob::startJob()
         }
         mltParameters << source;
         // set destination
-        mltParameters << QStringLiteral("-consumer") << QStringLiteral("avformat:") + dest;
+        mltParameters << QStringLiteral("-consumer") << QStringLiteral("avformat:") + output;
         QString parameter = pCore->currentDoc()->getDocumentProperty(QStringLiteral("proxyparams")).simplified();
         if (parameter.isEmpty()) {
             // Automatic setting, decide based on hw support
@@ -140,11 +153,12 @@ bool ProxyJob::startJob()
             }
             mltParameters << t;
         }
-        int threadCount = QThread::idealThreadCount();
-        if (threadCount > 2) {
-            threadCount = qMin(threadCount - 1, 4);
-        } else {
-            threadCount = 1;
+        int threadCount = runner.acquireSlot();
+        if (threadCount == 0) {
+            // Canceled while waiting for other encoders
+            delete playlist;
+            m_done = false;
+            return false;
         }
         mltParameters.append(QStringLiteral("real_time=-%1").arg(threadCount));
         mltParameters.append(QStringLiteral("threads=%1").arg(threadCount));
@@ -156,13 +170,12 @@ bool ProxyJob::startJob()
         // Ask for progress reporting
         mltParameters << QStringLiteral("progress=1");
 
-        m_jobProcess = new QProcess;
-        // m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
-        connect(this, &ProxyJob::jobCanceled, m_jobProcess, &QProcess::kill, Qt::DirectConnection);
-        connect(m_jobProcess, &QProcess::readyReadStandardError, this, &ProxyJob::processLogInfo);
-        m_jobProcess->start(KdenliveSettings::rendererpath(), mltParameters);
-        m_jobProcess->waitForFinished(-1);
-        result = m_jobProcess->exitStatus() == QProcess::NormalExit;
+        if (sequence) {
+            // Only pass the encoding parameters to the chunk renderer
+            result = renderSequence(runner, source, output, mltParameters.mid(3), parameter);
+        } else {
+            result = runner.execute(KdenliveSettings::rendererpath(), mltParameters);
+        }
         delete playlist;
     } else if (type == ClipType::Image) {
         m_isFfmpegJob = false;
@@ -213,12 +226,15 @@ bool ProxyJob::startJob()
                 break;
             }
             processed = proxy.transformed(matrix);
-            processed.save(dest);
+            processed.save(output);
         } else {
-            proxy.save(dest);
+            proxy.save(output);
         }
-        m_done = true;
-        return true;
+        m_done = ProxyCache::get()->commit(output, dest);
+        if (!m_done) {
+            m_errorMessage.append(i18n("Failed to create proxy clip."));
+        }
+        return m_done;
     } else {
         m_isFfmpegJob = true;
         if (KdenliveSettings::ffmpegpath().isEmpty()) {
@@ -280,21 +296,24 @@ bool ProxyJob::startJob()
             }
         }
 
+        int threadCount = runner.acquireSlot();
+        if (threadCount == 0) {
+            // Canceled while waiting for other encoders
+            m_done = false;
+            return false;
+        }
+        if (!parameters.contains(QLatin1String("-threads"))) {
+            parameters << QStringLiteral("-threads") << QString::number(threadCount);
+        }
+
         // Make sure we don't block when proxy file already exists
-        parameters << dest;
+        parameters << output;
          qDebug()<<"/// FULL PROXY PARAMS:\n"<<parameters<<"\n------";
-        m_jobProcess = new QProcess;
-        // m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
-        connect(m_jobProcess, &QProcess::readyReadStandardError, this, &ProxyJob::processLogInfo);
-        connect(this, &ProxyJob::jobCanceled, m_jobProcess, &QProcess::kill, Qt::DirectConnection);
-        m_jobProcess->start(KdenliveSettings::ffmpegpath(), parameters, QIODevice::ReadOnly);
-        m_jobProcess->waitForFinished(-1);
-        result = m_jobProcess->exitStatus() == QProcess::NormalExit;
+        result = runner.execute(KdenliveSettings::ffmpegpath(), parameters);
     }
     // remove temporary playlist if it exists
     if (result) {
-        if (QFileInfo(dest).size() == 0) {
-            QFile::remove(dest);
+        if (!ProxyCache::get()->commit(output, dest)) {
             // File was not created
             m_done = false;
             m_errorMessage.append(i18n("Failed to create proxy clip."));
@@ -303,18 +322,87 @@ bool ProxyJob::startJob()
         }
     } else {
         // Proxy process crashed
-        QFile::remove(dest);
+        QFile::remove(output);
         m_done = false;
-        m_errorMessage.append(QString::fromUtf8(m_jobProcess->readAll()));
+        m_errorMessage.append(runner.errorOutput());
     }
-    m_jobProcess->deleteLater();
     return result;
 }
 
-void ProxyJob::processLogInfo()
+bool ProxyJob::renderSequence(ProcessRunner &runner, const QString &source, const QString &output, const QStringList &encoderParams,
+                              const QString &proxyParams)
 {
-    const QString buffer = QString::fromUtf8(m_jobProcess->readAllStandardError());
-    m_logDetails.append(buffer);
+    auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
+    int chunkSize = KdenliveSettings::timelinechunks();
+    const QString extension = pCore->currentDoc()->getDocumentProperty(QStringLiteral("proxyextension"));
+    Mlt::Profile &profile = pCore->getCurrentProfile()->profile();
+    // The sequence may have been edited since the clip was loaded, so read its current length
+    Mlt::Producer sequenceProducer(profile, source.toUtf8().constData());
+    int length = sequenceProducer.is_valid() ? sequenceProducer.get_playtime() : binClip->getFramePlaytime();
+    const QString salt = QStringLiteral("%1x%2 %3/%4").arg(profile.width()).arg(profile.height()).arg(profile.frame_rate_num()).arg(profile.frame_rate_den());
+    const QStringList fingerprints = SequenceCache::chunkFingerprints(source, length, chunkSize, pCore->getCurrentFps(), salt);
+    if (fingerprints.isEmpty()) {
+        m_errorMessage.append(i18n("Cannot read playlist %1.", source));
+        return false;
+    }
+    // Chunks are named after their content, so the chunks that were not modified since the last encoding are found in the cache
+    const QDir dir = QFileInfo(output).absoluteDir();
+    QStringList chunks;
+    QStringList missing;
+    for (int i = 0; i < fingerprints.count(); ++i) {
+        chunks << dir.absoluteFilePath(ProxyCache::proxyName(fingerprints.at(i), proxyParams, QLatin1Char('.') + extension));
+        if (!ProxyCache::get()->use(chunks.last())) {
+            missing << QString::number(i * chunkSize);
+        }
+    }
+    if (!missing.isEmpty()) {
+        // The renderer names the chunks after their first frame, use a work folder
+        QDir work(dir.absoluteFilePath(QStringLiteral("work-%1").arg(m_clipId)));
+        work.removeRecursively();
+        if (!work.mkpath(QStringLiteral("."))) {
+            m_errorMessage.append(i18n("Cannot create folder %1", work.absolutePath()));
+            return false;
+        }
+        m_chunkCount = missing.count();
+        m_renderedChunks = 0;
+        QStringList arguments{KdenliveSettings::rendererpath(),
+                              source,
+                              work.absolutePath(),
+                              QStringLiteral("-split"),
+                              missing.join(QLatin1Char(',')),
+                              QString::number(chunkSize - 1),
+                              pCore->getCurrentProfilePath(),
+                              extension,
+                              encoderParams.join(QLatin1Char(' '))};
+        bool ok = runner.execute(SequenceCache::rendererPath(), arguments) && runner.exitCode() == 0;
+        for (const QString &frame : missing) {
+            const QString rendered = work.absoluteFilePath(QStringLiteral("%1.%2").arg(frame, extension));
+            // Keep the chunks that were completed, even if the render was interrupted
+            if (!ProxyCache::get()->commit(rendered, chunks.at(frame.toInt() / chunkSize))) {
+                ok = false;
+            }
+        }
+        work.removeRecursively();
+        m_chunkCount = 0;
+        if (!ok) {
+            return false;
+        }
+    }
+    if (!SequenceCache::writePlaylist(profile, chunks, chunkSize, length, output)) {
+        m_errorMessage.append(i18n("Cannot create playlist %1.", output));
+        return false;
+    }
+    // The previous render is named after the previous content of the sequence, remove the chunks that were not reused
+    const QString previous = binClip->getProducerProperty(QStringLiteral("kdenlive:proxy"));
+    if (!previous.isEmpty() && previous != output && QFileInfo(previous).absoluteDir() == dir) {
+        SequenceCache::removePlaylist(previous, chunks);
+    }
+    return true;
+}
+
+void ProxyJob::processLogInfo(const QString &buffer)
+{
+    m_logDetails.append(buffer + QLatin1Char('\n'));
     int progress = 0;
     if (m_isFfmpegJob) {
         // Parse FFmpeg output
@@ -344,6 +432,11 @@ void ProxyJob::processLogInfo()
             }
             emit jobProgress((int)(100.0 * progress / m_jobDuration));
         }
+    } else if (m_chunkCount > 0) {
+        // Parse chunk renderer output
+        if (buffer.startsWith(QLatin1String("DONE:"))) {
+            emit jobProgress(100 * ++m_renderedChunks / m_chunkCount);
+        }
     } else {
         // Parse MLT output
         if (buffer.contains(QLatin1String("percentage:"))) {
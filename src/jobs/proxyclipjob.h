@@ -23,7 +23,7 @@
 
 #include "abstractclipjob.h"
 
-class QProcess;
+class ProcessRunner;
 
 class ProxyJob : public AbstractClipJob
 {
@@ -38,13 +38,18 @@ public:
     bool commitResult(Fun &undo, Fun &redo) override;
 
 private slots:
-    void processLogInfo();
+    void processLogInfo(const QString &buffer);
 
 private:
+    /** @brief Encode the chunks of a nested sequence that are not cached yet, and write the playlist of chunks to output */
+    bool renderSequence(ProcessRunner &runner, const QString &source, const QString &output, const QStringList &encoderParams, const QString &proxyParams);
+
     int m_jobDuration;
     bool m_isFfmpegJob;
-    QProcess *m_jobProcess;
     bool m_done;
+    // Number of chunks encoded by the chunk renderer, and number of them already done
+    int m_chunkCount;
+    int m_renderedChunks;
 };
 
 #endif
@@ -96,18 +96,19 @@ bool ThumbJob::startJob()
         m_inCache = true;
         return true;
     }
-    m_prod = m_binClip->thumbProducer();
-    if ((m_prod == nullptr) || !m_prod->is_valid()) {
+    // The producer is leased from the clip's pool, it must be released when the job returns since finished jobs are kept
+    std::shared_ptr<Mlt::Producer> prod = m_binClip->thumbProducer();
+    if ((prod == nullptr) || !prod->is_valid()) {
         qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
         return false;
     }
-    int max = m_prod->get_length();
+    int max = prod->get_length();
     m_frameNumber = m_binClip->clipType() == ClipType::Image ? 0 : qMin(m_frameNumber, max - 1);
 
     if (m_frameNumber > 0) {
-        m_prod->seek(m_frameNumber);
+        prod->seek(m_frameNumber);
     }
-    QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
+    QScopedPointer<Mlt::Frame> frame(prod->get_frame());
     frame->set("deinterlace_method", "onefield");
     frame->set("top_field_first", -1);
     frame->set("rescale.interp", "nearest");
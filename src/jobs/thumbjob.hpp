@@ -60,7 +60,6 @@ private:
     int m_fullWidth;
 
     std::shared_ptr<ProjectClip> m_binClip;
-    std::shared_ptr<Mlt::Producer> m_prod;
 
     QImage m_result;
     bool m_done{false};
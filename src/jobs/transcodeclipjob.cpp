@@ -28,9 +28,7 @@
 #include "kdenlive_debug.h"
 #include "kdenlivesettings.h"
 #include "macros.hpp"
-
-#include <QProcess>
-#include <QThread>
+#include "processrunner.hpp"
 
 #include <klocalizedstring.h>
 
@@ -38,7 +36,6 @@ TranscodeJob::TranscodeJob(const QString &binId, QString params)
     : AbstractClipJob(TRANSCODEJOB, binId)
     , m_jobDuration(0)
     , m_isFfmpegJob(true)
-    , m_jobProcess(nullptr)
     , m_done(false)
     , m_transcodeParams(params)
 {
@@ -78,6 +75,9 @@ bool TranscodeJob::startJob()
     }
 
     bool result;
+    ProcessRunner runner;
+    connect(this, &TranscodeJob::jobCanceled, &runner, &ProcessRunner::cancel, Qt::DirectConnection);
+    connect(&runner, &ProcessRunner::standardErrorLine, this, &TranscodeJob::processLogInfo, Qt::DirectConnection);
     if (type == ClipType::Playlist || type == ClipType::SlideShow) {
         // change FFmpeg params to MLT format
         m_isFfmpegJob = false;
@@ -107,11 +107,10 @@ bool TranscodeJob::startJob()
             }
             mltParameters << t;
         }
-        int threadCount = QThread::idealThreadCount();
-        if (threadCount > 2) {
-            threadCount = qMin(threadCount - 1, 4);
-        } else {
-            threadCount = 1;
+        int threadCount = runner.acquireSlot();
+        if (threadCount == 0) {
+            // Canceled while waiting for other encoders
+            return false;
         }
         mltParameters.append(QStringLiteral("real_time=-%1").arg(threadCount));
         mltParameters.append(QStringLiteral("threads=%1").arg(threadCount));
@@ -123,13 +122,7 @@ bool TranscodeJob::startJob()
             mltParameters.prepend(QString("in=%1").arg(m_inPoint));
         }
         mltParameters.prepend(source);
-        m_jobProcess = new QProcess;
-        // m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
-        connect(this, &TranscodeJob::jobCanceled, m_jobProcess, &QProcess::kill, Qt::DirectConnection);
-        connect(m_jobProcess, &QProcess::readyReadStandardError, this, &TranscodeJob::processLogInfo);
-        m_jobProcess->start(KdenliveSettings::rendererpath(), mltParameters);
-        m_jobProcess->waitForFinished(-1);
-        result = m_jobProcess->exitStatus() == QProcess::NormalExit;
+        result = runner.execute(KdenliveSettings::rendererpath(), mltParameters);
     } else {
         m_isFfmpegJob = true;
         QStringList parameters;
@@ -151,6 +144,14 @@ bool TranscodeJob::startJob()
         // Only output error data
         parameters << QStringLiteral("-v") << QStringLiteral("error");
         QStringList params = m_transcodeParams.split(QLatin1Char(' '));
+        int threadCount = runner.acquireSlot();
+        if (threadCount == 0) {
+            // Canceled while waiting for other encoders
+            return false;
+        }
+        if (!params.contains(QLatin1String("-threads"))) {
+            parameters << QStringLiteral("-threads") << QString::number(threadCount);
+        }
         QStringList finalParams{QStringLiteral("-i"),source};
         for (const QString &s : params) {
             QString t = s.simplified();
@@ -161,13 +162,7 @@ bool TranscodeJob::startJob()
             }
         }
         qDebug()<<"/// FULL PROXY PARAMS:\n"<<parameters<<"\n------";
-        m_jobProcess = new QProcess;
-        // m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
-        connect(m_jobProcess, &QProcess::readyReadStandardError, this, &TranscodeJob::processLogInfo);
-        connect(this, &TranscodeJob::jobCanceled, m_jobProcess, &QProcess::kill, Qt::DirectConnection);
-        m_jobProcess->start(KdenliveSettings::ffmpegpath(), parameters, QIODevice::ReadOnly);
-        m_jobProcess->waitForFinished(-1);
-        result = m_jobProcess->exitStatus() == QProcess::NormalExit;
+        result = runner.execute(KdenliveSettings::ffmpegpath(), parameters);
     }
     m_destUrl.append(transcoderExt);
     // remove temporary playlist if it exists
@@ -184,16 +179,14 @@ bool TranscodeJob::startJob()
         // Proxy process crashed
         QFile::remove(m_destUrl);
         m_done = false;
-        m_errorMessage.append(QString::fromUtf8(m_jobProcess->readAll()));
+        m_errorMessage.append(runner.errorOutput());
     }
-    m_jobProcess->deleteLater();
     return result;
 }
 
-void TranscodeJob::processLogInfo()
+void TranscodeJob::processLogInfo(const QString &buffer)
 {
-    const QString buffer = QString::fromUtf8(m_jobProcess->readAllStandardError());
-    m_logDetails.append(buffer);
+    m_logDetails.append(buffer + QLatin1Char('\n'));
     int progress = 0;
     if (m_isFfmpegJob) {
         // Parse FFmpeg output
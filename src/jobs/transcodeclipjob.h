@@ -23,8 +23,6 @@
 
 #include "abstractclipjob.h"
 
-class QProcess;
-
 class TranscodeJob : public AbstractClipJob
 {
     Q_OBJECT
@@ -38,12 +36,11 @@ public:
     bool commitResult(Fun &undo, Fun &redo) override;
 
 private slots:
-    void processLogInfo();
+    void processLogInfo(const QString &buffer);
 
 private:
     int m_jobDuration;
     bool m_isFfmpegJob;
-    QProcess *m_jobProcess;
     bool m_done;
     QString m_destUrl;
     QString m_transcodeParams;
@@ -10,6 +10,7 @@
 
 #include "fftTools.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -31,7 +32,7 @@ FFTTools::FFTTools()
 }
 FFTTools::~FFTTools()
 {
-    QHash<QString, kiss_fftr_cfg>::iterator i;
+    QHash<int, kiss_fftr_cfg>::iterator i;
     for (i = m_fftCfgs.begin(); i != m_fftCfgs.end(); ++i) {
         free(*i);
     }
@@ -111,9 +112,40 @@ const QVector<float> FFTTools::window(const WindowType windowType, const int siz
     return QVector<float>();
 }
 
+kiss_fftr_cfg FFTTools::plan(const int size)
+{
+    // Get the kiss_fft configuration from the config cache
+    // or build a new configuration if the requested one is not available.
+    auto it = m_fftCfgs.constFind(size);
+    if (it != m_fftCfgs.constEnd()) {
+        return it.value();
+    }
+#ifdef DEBUG_FFTTOOLS
+    qCDebug(KDENLIVE_LOG) << "Creating FFT configuration with size " << size;
+#endif
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(size, 0, nullptr, nullptr);
+    m_fftCfgs.insert(size, cfg);
+    return cfg;
+}
+
+const QVector<float> &FFTTools::cachedWindow(const WindowType windowType, const int size)
+{
+    // Window sizes are even and well below 2^28, so size and type fit into one key
+    const int key = (size << 2) | int(windowType);
+    auto it = m_windowFunctions.find(key);
+    if (it == m_windowFunctions.end()) {
+#ifdef DEBUG_FFTTOOLS
+        qCDebug(KDENLIVE_LOG) << "Building new window function with signature " << windowSignature(windowType, size, 0);
+#endif
+        it = m_windowFunctions.insert(key, FFTTools::window(windowType, size, 0));
+    }
+    return it.value();
+}
+
 void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum, const WindowType windowType,
                              const uint windowSize, const float param)
 {
+    Q_UNUSED(param)
 #ifdef DEBUG_FFTTOOLS
     QTime start = QTime::currentTime();
 #endif
@@ -124,64 +156,48 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
         return;
     }
 
-    const QString cfgSig = cfgSignature((int)windowSize);
-    const QString winSig = windowSignature(windowType, (int)windowSize, param);
+    kiss_fftr_cfg myCfg = plan((int)windowSize);
 
-    // Get the kiss_fft configuration from the config cache
-    // or build a new configuration if the requested one is not available.
-    kiss_fftr_cfg myCfg;
-    if (m_fftCfgs.contains(cfgSig)) {
-#ifdef DEBUG_FFTTOOLS
-        qCDebug(KDENLIVE_LOG) << "Re-using FFT configuration with size " << windowSize;
-#endif
-        myCfg = m_fftCfgs.value(cfgSig);
-    } else {
-#ifdef DEBUG_FFTTOOLS
-        qCDebug(KDENLIVE_LOG) << "Creating FFT configuration with size " << windowSize;
-#endif
-        myCfg = kiss_fftr_alloc((int)windowSize, 0, nullptr, nullptr);
-        m_fftCfgs.insert(cfgSig, myCfg);
+    // Prepare the work buffers. The resulting FFT vector is only half as long,
+    // plus the Nyquist bin that kiss_fftr writes as well.
+    if (m_timeData.size() < (int)windowSize) {
+        m_timeData.resize((int)windowSize);
+        m_freqData.resize((int)windowSize / 2 + 1);
     }
-
-    // Get the window function from the cache
-    // (except for a rectangular window; nothing to do there).
-    QVector<float> window;
-    float windowScaleFactor = 1;
-    if (windowType != FFTTools::Window_Rect) {
-
-        if (m_windowFunctions.contains(winSig)) {
-#ifdef DEBUG_FFTTOOLS
-            qCDebug(KDENLIVE_LOG) << "Re-using window function with signature " << winSig;
-#endif
-            window = m_windowFunctions.value(winSig);
-        } else {
-#ifdef DEBUG_FFTTOOLS
-            qCDebug(KDENLIVE_LOG) << "Building new window function with signature " << winSig;
-#endif
-            window = FFTTools::window(windowType, (int)windowSize, 0);
-            m_windowFunctions.insert(winSig, window);
-        }
-        windowScaleFactor = 1.0 / window[(int)windowSize];
-    }
-
-    // Prepare frequency space vector. The resulting FFT vector is only half as long.
-    auto *freqData = new kiss_fft_cpx[int(windowSize) / 2];
-    auto *data = new float[(int)windowSize];
+    float *data = m_timeData.data();
+    kiss_fft_cpx *freqData = m_freqData.data();
 
     // Copy the first channel's audio into a vector for the FFT display;
     // Fill the data vector indices that cannot be covered with sample data with 0
-    if (numSamples < windowSize) {
-        std::fill(&data[numSamples], &data[windowSize - 1], 0);
+    const uint count = std::min(numSamples, windowSize);
+    if (count < windowSize) {
+        std::fill(data + count, data + windowSize, 0.f);
     }
-    // Normalize signals to [0,1] to get correct dB values later on
-    for (uint i = 0; i < numSamples && i < windowSize; ++i) {
-        // Performance note: Benchmarking has shown that using the if/else inside the loop
-        // does not do noticeable worse than keeping it outside (perhaps the branch predictor
-        // is good enough), so it remains in there for better readability.
-        if (windowType != FFTTools::Window_Rect) {
-            data[i] = (float)audioFrame.data()[i * numChannels + channel] / 32767.0f * window[(int)i];
+    // Normalize signals to [0,1] to get correct dB values later on.
+    // The branch is kept outside of the loops so that they can be vectorized.
+    const short *samples = audioFrame.constData() + channel;
+    const float sampleScale = 1.0f / 32767.0f;
+    float windowScaleFactor = 1;
+    if (windowType != FFTTools::Window_Rect) {
+        const QVector<float> &window = cachedWindow(windowType, (int)windowSize);
+        const float *win = window.constData();
+        windowScaleFactor = 1.0f / win[windowSize];
+        if (numChannels == 1) {
+            for (uint i = 0; i < count; ++i) {
+                data[i] = (float)samples[i] * sampleScale * win[i];
+            }
         } else {
-            data[i] = (float)audioFrame.data()[i * numChannels + channel] / 32767.0f;
+            for (uint i = 0; i < count; ++i) {
+                data[i] = (float)samples[i * numChannels] * sampleScale * win[i];
+            }
+        }
+    } else if (numChannels == 1) {
+        for (uint i = 0; i < count; ++i) {
+            data[i] = (float)samples[i] * sampleScale;
+        }
+    } else {
+        for (uint i = 0; i < count; ++i) {
+            data[i] = (float)samples[i * numChannels] * sampleScale;
         }
     }
 
@@ -189,14 +205,13 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
     kiss_fftr(myCfg, data, freqData);
 
     // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-    // with N = FFT size (after FFT, 1/2 window size)
+    // with N = FFT size (after FFT, 1/2 window size).
+    // This equals 10 * log(r² + i²) + 20 * log(scale / N), which saves the square root
+    // and the pow() calls per bin.
+    const float dbOffset = 20.0f * std::log10(windowScaleFactor / ((float)windowSize / 2.0f));
     for (uint i = 0; i < windowSize / 2; ++i) {
-        // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-        // with N = FFT size (after FFT, 1/2 window size)
-        freqSpectrum[i] =
-            20 * log(pow(pow(fabs(freqData[i].r * windowScaleFactor), 2) + pow(fabs(freqData[i].i * windowScaleFactor), 2), .5) / ((float)windowSize / 2.0f)) /
-            log(10);
-        ;
+        const float power = freqData[i].r * freqData[i].r + freqData[i].i * freqData[i].i;
+        freqSpectrum[i] = 10.0f * std::log10(power) + dbOffset;
     }
 
 #ifdef DEBUG_FFTTOOLS
@@ -226,8 +241,6 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
 #ifdef DEBUG_FFTTOOLS
     qCDebug(KDENLIVE_LOG) << "Calculated FFT in " << start.elapsed() << " ms.";
 #endif
-    delete[] freqData;
-    delete[] data;
 }
 
 const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left, uint right, float fill)
@@ -74,8 +74,16 @@ public:
     static const QVector<float> interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left = 0, uint right = 0, float fill = 0.0);
 
 private:
-    QHash<QString, kiss_fftr_cfg> m_fftCfgs;          // FFT cfg cache
-    QHash<QString, QVector<float>> m_windowFunctions; // Window function cache
+    /** Returns the kiss_fft plan for the given size, building it on first use */
+    kiss_fftr_cfg plan(const int size);
+    /** Returns the cached window function for the given type and size, building it on first use */
+    const QVector<float> &cachedWindow(const WindowType windowType, const int size);
+
+    QHash<int, kiss_fftr_cfg> m_fftCfgs;          // FFT plan cache, keyed by size
+    QHash<int, QVector<float>> m_windowFunctions; // Window function cache, keyed by size and type
+    // Work buffers, re-used between calls to avoid allocating on every frame
+    QVector<float> m_timeData;
+    QVector<kiss_fft_cpx> m_freqData;
 };
 
 #endif // FFTTOOLS_H
@@ -25,10 +25,16 @@
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/model/timelinemodel.hpp"
 #include <QString>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #pragma GCC diagnostic ignored "-Wsign-conversion"
@@ -46,9 +52,111 @@ std::unordered_map<std::string, std::vector<Logger::Constr>> Logger::constr;
 std::unordered_map<std::string, std::string> Logger::translation_table;
 std::unordered_map<std::string, std::string> Logger::back_translation_table;
 int Logger::dump_count = 0;
+const size_t Logger::max_operations;
+bool Logger::truncated = false;
+std::atomic<bool> Logger::recording{false};
+std::atomic<bool> Logger::enabled{true};
 
 thread_local size_t Logger::result_awaiting = INT_MAX;
 
+namespace {
+/** @brief Single producer, single consumer ring buffer holding the binary records of one thread.
+ * The owning thread is the only one to advance head, the writer thread the only one to advance tail.
+ */
+struct RecordBuffer
+{
+    static const size_t capacity = 1 << 20;
+    explicit RecordBuffer(uint32_t idx)
+        : data(new char[capacity])
+        , index(idx)
+    {
+    }
+    bool push(const char *record, size_t size)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_acquire);
+        if (capacity - (h - t) < size) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        const size_t start = h & (capacity - 1);
+        const size_t first = std::min(size, capacity - start);
+        memcpy(data.get() + start, record, first);
+        memcpy(data.get(), record + first, size - first);
+        head.store(h + size, std::memory_order_release);
+        return true;
+    }
+    std::unique_ptr<char[]> data;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    // Set by the owning thread while it pushes, so that stop_recording can wait for the last pushes
+    std::atomic<bool> pushing{false};
+    uint32_t index;
+};
+const size_t RecordBuffer::capacity;
+
+struct RecordWriter
+{
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::vector<std::shared_ptr<RecordBuffer>> buffers;
+    std::thread thread;
+    FILE *file = nullptr;
+    bool stop = false;
+    // Incremented by each start_recording, so that threads register again in a new recording session
+    uint32_t session = 0;
+
+    void drain(RecordBuffer &buffer)
+    {
+        const size_t t = buffer.tail.load(std::memory_order_relaxed);
+        const size_t h = buffer.head.load(std::memory_order_acquire);
+        if (h == t) {
+            return;
+        }
+        // Chunk header: thread index and length, followed by the records
+        const uint32_t header[2] = {buffer.index, uint32_t(h - t)};
+        fwrite(header, sizeof(header), 1, file);
+        const size_t start = t & (RecordBuffer::capacity - 1);
+        const size_t first = std::min(h - t, RecordBuffer::capacity - start);
+        fwrite(buffer.data.get() + start, 1, first, file);
+        fwrite(buffer.data.get(), 1, h - t - first, file);
+        buffer.tail.store(h, std::memory_order_release);
+    }
+    void run()
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (true) {
+            wakeUp.wait_for(lk, std::chrono::milliseconds(50), [this]() { return stop; });
+            // New buffers are only appended under the lock, copy the list to write without holding it
+            auto current = buffers;
+            const bool last = stop;
+            lk.unlock();
+            for (const auto &buffer : current) {
+                drain(*buffer);
+            }
+            fflush(file);
+            lk.lock();
+            if (last) {
+                break;
+            }
+        }
+    }
+};
+
+RecordWriter &recordWriter()
+{
+    static RecordWriter writer;
+    return writer;
+}
+
+thread_local std::shared_ptr<RecordBuffer> threadBuffer;
+thread_local uint32_t threadSession = 0;
+
+const uint32_t recordFileMagic = 0x4b444c52;
+const uint32_t recordFileVersion = 2;
+} // namespace
+
 void Logger::init()
 {
     std::string cur_ind = "a";
@@ -93,8 +201,8 @@ void Logger::init()
 
 bool Logger::start_logging()
 {
-    std::unique_lock<std::mutex> lk(mut);
-    if (is_executing) {
+    // is_executing is thread local, no locking needed
+    if (is_executing || !enabled.load(std::memory_order_relaxed)) {
         return false;
     }
     is_executing = true;
@@ -102,9 +210,141 @@ bool Logger::start_logging()
 }
 void Logger::stop_logging()
 {
-    std::unique_lock<std::mutex> lk(mut);
     is_executing = false;
 }
+
+void Logger::set_enabled(bool value)
+{
+    enabled = value;
+}
+
+bool Logger::has_room()
+{
+    if (operations.size() < max_operations) {
+        return true;
+    }
+    if (!truncated) {
+        truncated = true;
+        std::cerr << "Logger: more than " << max_operations << " operations, further operations are not logged" << std::endl;
+    }
+    return false;
+}
+
+bool Logger::start_recording(const std::string &path)
+{
+    auto &writer = recordWriter();
+    std::unique_lock<std::mutex> lk(writer.mutex);
+    if (writer.file != nullptr) {
+        return false;
+    }
+    writer.file = fopen(path.c_str(), "wb");
+    if (writer.file == nullptr) {
+        std::cerr << "Logger: cannot open record file " << path << std::endl;
+        return false;
+    }
+    const uint32_t header[2] = {recordFileMagic, recordFileVersion};
+    fwrite(header, sizeof(header), 1, writer.file);
+    writer.buffers.clear();
+    writer.stop = false;
+    writer.session++;
+    writer.thread = std::thread(&RecordWriter::run, &writer);
+    static bool atexitRegistered = false;
+    if (!atexitRegistered) {
+        atexitRegistered = true;
+        std::atexit(&Logger::stop_recording);
+    }
+    recording = true;
+    return true;
+}
+
+void Logger::stop_recording()
+{
+    auto &writer = recordWriter();
+    std::unique_lock<std::mutex> lk(writer.mutex);
+    if (writer.file == nullptr || !recording.exchange(false)) {
+        return;
+    }
+    // Threads that saw the recording running may still be pushing, wait for them so that the final drain writes their records
+    const auto buffers = writer.buffers;
+    lk.unlock();
+    for (const auto &buffer : buffers) {
+        while (buffer->pushing.load()) {
+            std::this_thread::yield();
+        }
+    }
+    lk.lock();
+    writer.stop = true;
+    writer.wakeUp.notify_all();
+    lk.unlock();
+    writer.thread.join();
+    lk.lock();
+    uint64_t dropped = 0;
+    for (const auto &buffer : writer.buffers) {
+        dropped += buffer->dropped.load();
+    }
+    if (dropped > 0) {
+        std::cerr << "Logger: " << dropped << " records were dropped because they were too large or the record buffers were full" << std::endl;
+    }
+    fclose(writer.file);
+    writer.file = nullptr;
+}
+
+void Logger::commit_record(const LogRecord &record)
+{
+    auto &writer = recordWriter();
+    if (!threadBuffer || threadSession != writer.session) {
+        // First record of this thread in this session: register its buffer, this is the only locking
+        std::unique_lock<std::mutex> lk(writer.mutex);
+        if (writer.file == nullptr || !recording.load()) {
+            return;
+        }
+        threadBuffer = std::make_shared<RecordBuffer>(uint32_t(writer.buffers.size()));
+        threadSession = writer.session;
+        writer.buffers.push_back(threadBuffer);
+    }
+    const char *data = record.data();
+    if (data == nullptr) {
+        // Too large for a record
+        threadBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    threadBuffer->pushing.store(true);
+    if (recording.load()) {
+        threadBuffer->push(data, record.size());
+    }
+    threadBuffer->pushing.store(false, std::memory_order_release);
+}
+
+void LogRecord::add(const rttr::variant &value)
+{
+    if (value.get_type() == rttr::type::get<int>()) {
+        add(value.convert<int>());
+    } else if (value.get_type() == rttr::type::get<size_t>()) {
+        add(value.convert<size_t>());
+    } else if (value.get_type() == rttr::type::get<double>()) {
+        add(value.convert<double>());
+    } else if (value.get_type() == rttr::type::get<float>()) {
+        add(value.convert<float>());
+    } else if (value.get_type() == rttr::type::get<bool>()) {
+        add(value.convert<bool>());
+    } else if (value.get_type().is_enumeration()) {
+        add(value.convert<int>());
+    } else if (value.can_convert<QString>()) {
+        add(value.convert<QString>());
+    } else if (value.can_convert<std::string>()) {
+        add(value.convert<std::string>());
+    } else if (value.can_convert<std::unordered_set<int>>()) {
+        add(value.convert<std::unordered_set<int>>());
+    } else if (value.can_convert<TimelineModel *>()) {
+        add(value.convert<TimelineModel *>());
+    } else if (value.can_convert<TimelineItemModel *>()) {
+        add(static_cast<TimelineModel *>(value.convert<TimelineItemModel *>()));
+    } else if (value.can_convert<ProjectItemModel *>()) {
+        add(value.convert<ProjectItemModel *>());
+    } else {
+        addUnknown(value.get_type().get_name().to_string());
+    }
+}
 std::string Logger::get_ptr_name(const rttr::variant &ptr)
 {
     if (ptr.can_convert<TimelineModel *>()) {
@@ -122,13 +362,32 @@ std::string Logger::get_ptr_name(const rttr::variant &ptr)
 void Logger::log_res(rttr::variant result)
 {
     std::unique_lock<std::mutex> lk(mut);
-    Q_ASSERT(result_awaiting < invoks.size());
+    if (result_awaiting >= invoks.size()) {
+        // The invocation was not logged because the log is full
+        Q_ASSERT(truncated);
+        return;
+    }
     invoks[result_awaiting].res = std::move(result);
 }
 
 void Logger::log_create_producer(const std::string &type, std::vector<rttr::variant> args)
 {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (is_recording()) {
+        LogRecord record(LogRecord::Producer);
+        record.addName(type.data(), type.size());
+        for (auto &a : args) {
+            record.add(a.get_type().is_wrapper() ? a.extract_wrapped_value() : a);
+        }
+        commit_record(record);
+        return;
+    }
     std::unique_lock<std::mutex> lk(mut);
+    if (!has_room()) {
+        return;
+    }
     for (auto &a : args) {
         // this will rewove shared/weak/unique ptrs
         if (a.get_type().is_wrapper()) {
@@ -286,6 +545,9 @@ void Logger::print_trace()
     fuzz_file.open("fuzz_case_" + std::to_string(dump_count) + ".txt");
     std::ofstream test_file;
     test_file.open("test_case_" + std::to_string(dump_count) + ".cpp");
+    if (truncated) {
+        test_file << "// Warning: the log was truncated after " << max_operations << " operations" << std::endl;
+    }
     test_file << "TEST_CASE(\"Regression\") {" << std::endl;
     test_file << "auto binModel = pCore->projectItemModel();" << std::endl;
     test_file << "binModel->clean();" << std::endl;
@@ -415,9 +677,206 @@ void Logger::print_trace()
     test_file << "pCore->m_projectManager = nullptr;" << std::endl;
     test_file << "}" << std::endl;
 }
+
+namespace {
+/// @brief Sequential reader over the bytes of one binary record, which flags an error instead of reading past its end
+struct RecordReader
+{
+    RecordReader(const char *recordData, size_t recordSize)
+        : data(recordData)
+        , size(recordSize)
+    {
+    }
+    template <typename T> T read()
+    {
+        T value{};
+        readRaw(&value, sizeof(T));
+        return value;
+    }
+    void readRaw(void *out, size_t length)
+    {
+        if (error || pos + length > size) {
+            error = true;
+            return;
+        }
+        memcpy(out, data + pos, length);
+        pos += length;
+    }
+    std::string readName()
+    {
+        std::string name(read<uint16_t>(), '\0');
+        readRaw(&name[0], name.size());
+        return name;
+    }
+    bool atEnd() const { return error || pos >= size; }
+
+    const char *data;
+    size_t size;
+    size_t pos = 0;
+    bool error = false;
+};
+} // namespace
+
+bool Logger::convert_recording(const std::string &path, std::ostream &out)
+{
+    std::ifstream file(path, std::ios::binary);
+    uint32_t header[2] = {0, 0};
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != recordFileMagic || header[1] != recordFileVersion) {
+        std::cerr << "Logger: " << path << " is not a record file" << std::endl;
+        return false;
+    }
+    if (translation_table.empty()) {
+        init();
+    }
+    // Split the chunks in records. A chunk only contains complete records of one thread, in order
+    struct Entry
+    {
+        uint64_t timestamp;
+        std::string data;
+    };
+    std::vector<Entry> records;
+    uint32_t chunk[2];
+    while (file.read(reinterpret_cast<char *>(chunk), sizeof(chunk))) {
+        std::string bytes(chunk[1], '\0');
+        if (!file.read(&bytes[0], std::streamsize(bytes.size()))) {
+            std::cerr << "Logger: " << path << " is truncated, the last records are ignored" << std::endl;
+            break;
+        }
+        size_t pos = 0;
+        while (pos < bytes.size()) {
+            RecordReader reader(bytes.data() + pos, bytes.size() - pos);
+            const uint32_t size = reader.read<uint32_t>();
+            reader.read<uint8_t>();
+            const uint64_t timestamp = reader.read<uint64_t>();
+            if (reader.error || size < reader.pos || size > bytes.size() - pos) {
+                std::cerr << "Logger: corrupted record in " << path << std::endl;
+                return false;
+            }
+            records.push_back({timestamp, bytes.substr(pos, size)});
+            pos += size;
+        }
+    }
+    std::stable_sort(records.begin(), records.end(), [](const Entry &a, const Entry &b) { return a.timestamp < b.timestamp; });
+
+    // Timelines are referred to by their index in construction order, as in print_trace
+    std::unordered_map<uint64_t, size_t> timelines;
+    // Set when an argument cannot be written in the fuzz format, the replay would not be faithful
+    std::string failure;
+    auto process_args_fuzz = [&](RecordReader &reader, const std::unordered_set<size_t> &refs) {
+        std::vector<std::string> args;
+        for (size_t i = 0; !reader.atEnd(); ++i) {
+            std::stringstream ss;
+            const char tag = reader.read<char>();
+            if (tag == 'b') {
+                ss << (reader.read<uint8_t>() != 0 ? "1" : "0");
+            } else if (tag == 'S') {
+                QString value(int(reader.read<uint32_t>()), QChar());
+                reader.readRaw(value.data(), size_t(value.size()) * sizeof(QChar));
+                std::string out = value.toStdString();
+                ss << (out.empty() ? "$$" : out);
+            } else if (tag == 's') {
+                std::string out(reader.read<uint32_t>(), '\0');
+                reader.readRaw(&out[0], out.size());
+                ss << (out.empty() ? "$$" : out);
+            } else if (tag == 'I') {
+                const uint32_t count = reader.read<uint32_t>();
+                ss << count;
+                for (uint32_t j = 0; j < count && !reader.error; ++j) {
+                    ss << " " << reader.read<int32_t>();
+                }
+            } else if (tag == 'p') {
+                const uint64_t ptr = reader.read<uint64_t>();
+                if (timelines.count(ptr) > 0) {
+                    ss << timelines.at(ptr);
+                }
+                // Other pointers are the bin model, we skip the parameter since it's unambiguous
+            } else if (tag == 'i') {
+                ss << reader.read<int64_t>();
+            } else if (tag == 'd') {
+                ss << reader.read<double>();
+            } else if (tag == '?') {
+                failure = "argument of type " + reader.readName() + " has no binary representation";
+                break;
+            } else {
+                failure = "unknown argument tag";
+                break;
+            }
+            if (refs.count(i) == 0 && !ss.str().empty()) {
+                args.push_back(ss.str());
+            }
+        }
+        std::stringstream ss;
+        for (size_t i = 0; i < args.size(); ++i) {
+            ss << (i > 0 ? " " : "") << args[i];
+        }
+        return ss.str();
+    };
+    for (const Entry &entry : records) {
+        RecordReader reader(entry.data.data(), entry.data.size());
+        reader.read<uint32_t>();
+        const auto kind = LogRecord::Kind(reader.read<uint8_t>());
+        reader.read<uint64_t>();
+        const uint64_t instance = reader.read<uint64_t>();
+        if (kind == LogRecord::Undo) {
+            out << "u" << std::endl;
+        } else if (kind == LogRecord::Redo) {
+            out << "r" << std::endl;
+        } else if (kind == LogRecord::Constructor || kind == LogRecord::Producer) {
+            // Producers created by the tests are stored as constructors named after the helper function
+            const std::string type = reader.readName();
+            const std::string constr_name = std::string("constr_") + type;
+            if (translation_table.count(constr_name) == 0) {
+                std::cout << "ERROR: unknown constructor " << constr_name << std::endl;
+                continue;
+            }
+            if (type == "TimelineModel") {
+                const size_t id = timelines.size();
+                timelines[instance] = id;
+            }
+            out << translation_table[constr_name] << " " << process_args_fuzz(reader, {}) << std::endl;
+        } else if (kind == LogRecord::Invocation) {
+            reader.readName();
+            const std::string invok_name = reader.readName();
+            if (translation_table.count(invok_name) == 0) {
+                std::cout << "ERROR: unknown method " << invok_name << std::endl;
+                continue;
+            }
+            bool is_static = false;
+            rttr::method m = rttr::type::get<TimelineModel>().get_method(invok_name);
+            if (!m.is_valid()) {
+                is_static = true;
+                m = rttr::type::get<TimelineFunctions>().get_method(invok_name);
+            }
+            std::unordered_set<size_t> refs;
+            std::string ptr;
+            if (m.is_valid()) {
+                for (const auto &a : m.get_parameter_infos()) {
+                    // The timeline parameter of TimelineFunctions is the record instance, not a recorded argument
+                    if (isIthParamARef(m, a.get_index()) && (!is_static || a.get_index() > 0)) {
+                        refs.insert(is_static ? a.get_index() - 1 : a.get_index());
+                    }
+                }
+                if (timelines.count(instance) == 0) {
+                    std::cout << "ERROR: invocation of " << invok_name << " on an unknown timeline" << std::endl;
+                    continue;
+                }
+                ptr = std::to_string(timelines.at(instance)) + " ";
+            }
+            out << translation_table[invok_name] << " " << ptr << process_args_fuzz(reader, refs) << std::endl;
+        }
+        // Results are not part of the fuzz format
+        if (!failure.empty()) {
+            std::cerr << "Logger: cannot convert " << path << ", " << failure << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 void Logger::clear()
 {
     is_executing = false;
+    truncated = false;
     invoks.clear();
     operations.clear();
     constr.clear();
@@ -440,6 +899,17 @@ bool LogGuard::hasGuard() const
 
 void Logger::log_undo(bool undo)
 {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (is_recording()) {
+        commit_record(LogRecord(undo ? LogRecord::Undo : LogRecord::Redo));
+        return;
+    }
+    std::unique_lock<std::mutex> lk(mut);
+    if (!has_room()) {
+        return;
+    }
     Logger::Undo u;
     u.undo = undo;
     operations.push_back(u);
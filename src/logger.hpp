@@ -20,11 +20,19 @@
  ***************************************************************************/
 
 #pragma once
+#include <QString>
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -35,9 +43,16 @@
 #include <rttr/variant.h>
 #pragma GCC diagnostic pop
 
+class LogRecord;
+
 /** @brief This class is meant to provide an easy way to reproduce bugs involving the model.
  * The idea is to log any modifier function involving a model class, and trace the parameters that were passed, to be able to generate a test-case producing the
  * same behaviour. Note that many modifier functions of the models are nested. We are only interested in the top-most call, and we must ignore bottom calls.
+ *
+ * By default, calls are kept in memory as rttr variants so that print_trace can generate test cases. At most max_operations operations are kept.
+ * For long sessions, start_recording switches to a low overhead mode: each call is serialized as a compact binary record into a lock-free ring buffer owned by
+ * the calling thread, and a background thread appends the buffers to a file. Records that do not fit in a full buffer or exceed the maximal record size are
+ * dropped and counted.
  */
 class Logger
 {
@@ -73,10 +88,34 @@ public:
     /// @brief Resets the current log
     static void clear();
 
+    /** @brief Enable or disable logging, for example to measure the models without the logging overhead. Logging is enabled by default */
+    static void set_enabled(bool enabled);
+
+    /** @brief Switch to binary recording, appending records to the given file until stop_recording is called. Returns false if the file cannot be opened */
+    static bool start_recording(const std::string &path);
+    static void stop_recording();
+    /** @brief Converts a file written by start_recording to the textual format of the fuzz_case files, so that the session can be replayed by the fuzzer or
+     * trace_replay. Records of all threads are merged in timestamp order. Returns false if the file is not a valid record file */
+    static bool convert_recording(const std::string &path, std::ostream &out);
+    /// @brief Returns true if calls are recorded in binary form instead of being kept in memory
+    static bool is_recording() { return recording.load(std::memory_order_relaxed); }
+
+    /// @brief Binary recording of a constructor, a method invocation or a result. In general, it's better to use the TRACE macros
+    template <typename T, typename... Args> static void record_constr(T *inst, const std::tuple<Args...> &args);
+    template <typename T, typename... Args> static void record(T *inst, const char *fctName, const std::tuple<Args...> &args);
+    template <typename T> static void record_res(const T &result);
+
     static std::unordered_map<std::string, std::string> translation_table;
     static std::unordered_map<std::string, std::string> back_translation_table;
 
+    /// @brief Maximum number of operations kept in memory when not recording
+    static const size_t max_operations = 500000;
+
 protected:
+    /// @brief Push a finished record to the ring buffer of the current thread
+    static void commit_record(const LogRecord &record);
+    /// @brief Returns false, and warns once, when the in-memory log is full. mut must be locked
+    static bool has_room();
     /** @brief Look amongst the known instances to get the name of a given pointer */
     static std::string get_ptr_name(const rttr::variant &ptr);
     template <typename T> static size_t get_id_from_ptr(T *ptr);
@@ -109,6 +148,120 @@ protected:
     static std::unordered_map<std::string, std::vector<Constr>> constr;
     static std::vector<Invok> invoks;
     static int dump_count;
+    static bool truncated;
+    static std::atomic<bool> recording;
+    static std::atomic<bool> enabled;
+};
+
+/** @brief A binary log record, built on the stack before being copied to the ring buffer of the thread.
+ * Layout: u32 size, u8 kind, u64 timestamp (ns), u64 instance, class and method names (u16 length + bytes), then for each argument a one byte type tag
+ * followed by its value. Strings are stored as UTF-16, containers as a u32 count followed by the elements. Arguments without a binary representation
+ * are stored as their type name, so that the conversion can report them.
+ */
+class LogRecord
+{
+public:
+    enum Kind : uint8_t { Constructor = 1, Invocation, Result, Undo, Redo, Producer };
+
+    explicit LogRecord(Kind kind, const void *instance = nullptr)
+    {
+        m_size = sizeof(uint32_t);
+        write<uint8_t>(kind);
+        write<uint64_t>(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()));
+        write<uint64_t>(uint64_t(reinterpret_cast<uintptr_t>(instance)));
+    }
+    void addName(const char *name, size_t length)
+    {
+        write<uint16_t>(uint16_t(length));
+        writeRaw(name, length);
+    }
+    void add(bool value)
+    {
+        write<char>('b');
+        write<uint8_t>(value ? 1 : 0);
+    }
+    void add(const QString &value)
+    {
+        write<char>('S');
+        write<uint32_t>(uint32_t(value.size()));
+        writeRaw(value.constData(), size_t(value.size()) * sizeof(QChar));
+    }
+    void add(const std::string &value)
+    {
+        write<char>('s');
+        write<uint32_t>(uint32_t(value.size()));
+        writeRaw(value.data(), value.size());
+    }
+    void add(const std::unordered_set<int> &value)
+    {
+        write<char>('I');
+        write<uint32_t>(uint32_t(value.size()));
+        for (int v : value) {
+            write<int32_t>(v);
+        }
+    }
+    template <typename T> void add(const std::shared_ptr<T> &value) { add(value.get()); }
+    template <typename T> void add(const std::weak_ptr<T> &value) { add(value.lock().get()); }
+    template <typename T> void add(T *value)
+    {
+        write<char>('p');
+        write<uint64_t>(uint64_t(reinterpret_cast<uintptr_t>(value)));
+    }
+    template <typename T> typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type add(T value)
+    {
+        write<char>('i');
+        write<int64_t>(int64_t(value));
+    }
+    template <typename T> typename std::enable_if<std::is_floating_point<T>::value>::type add(T value)
+    {
+        write<char>('d');
+        write<double>(double(value));
+    }
+    /// @brief Adds an argument logged as a variant, as done for producer creations
+    void add(const rttr::variant &value);
+    // Types without a binary representation are tagged with their name
+    template <typename T>
+    typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_enum<T>::value && !std::is_pointer<T>::value>::type add(const T &)
+    {
+        addUnknown(rttr::type::get<T>().get_name().to_string());
+    }
+    void addUnknown(const std::string &typeName)
+    {
+        write<char>('?');
+        addName(typeName.data(), typeName.size());
+    }
+    template <typename... Args> void addAll(const std::tuple<Args...> &args) { addAll(args, std::index_sequence_for<Args...>()); }
+
+    /// @brief Returns the record data, or nullptr if it did not fit in the record
+    const char *data() const
+    {
+        if (m_overflow) {
+            return nullptr;
+        }
+        uint32_t size = uint32_t(m_size);
+        memcpy(const_cast<char *>(m_data), &size, sizeof(size));
+        return m_data;
+    }
+    size_t size() const { return m_size; }
+
+private:
+    template <typename... Args, size_t... I> void addAll(const std::tuple<Args...> &args, std::index_sequence<I...>)
+    {
+        (void)std::initializer_list<int>{(add(std::get<I>(args)), 0)...};
+    }
+    template <typename T> void write(T value) { writeRaw(&value, sizeof(T)); }
+    void writeRaw(const void *data, size_t length)
+    {
+        if (m_size + length > sizeof(m_data)) {
+            m_overflow = true;
+            return;
+        }
+        memcpy(m_data + m_size, data, length);
+        m_size += length;
+    }
+    char m_data[1024];
+    size_t m_size;
+    bool m_overflow = false;
 };
 
 /** @brief This class provides a RAII mechanism to log the execution of a function */
@@ -128,33 +281,52 @@ protected:
 #define TRACE_CONSTR(ptr, ...)                                                                                                                                 \
     LogGuard __guard;                                                                                                                                          \
     if (__guard.hasGuard()) {                                                                                                                                  \
-        Logger::log_constr((ptr), {__VA_ARGS__});                                                                                                              \
+        if (Logger::is_recording()) {                                                                                                                          \
+            Logger::record_constr((ptr), std::forward_as_tuple(__VA_ARGS__));                                                                                  \
+        } else {                                                                                                                                               \
+            Logger::log_constr((ptr), {__VA_ARGS__});                                                                                                          \
+        }                                                                                                                                                      \
     }
 
 /// See Logger::log. Note that the macro fills the ptr instance and the method name for you.
 #define TRACE(...)                                                                                                                                             \
     LogGuard __guard;                                                                                                                                          \
     if (__guard.hasGuard()) {                                                                                                                                  \
-        Logger::log(this, __FUNCTION__, {__VA_ARGS__});                                                                                                        \
+        if (Logger::is_recording()) {                                                                                                                          \
+            Logger::record(this, __FUNCTION__, std::forward_as_tuple(__VA_ARGS__));                                                                            \
+        } else {                                                                                                                                               \
+            Logger::log(this, __FUNCTION__, {__VA_ARGS__});                                                                                                    \
+        }                                                                                                                                                      \
     }
 
 /// Same as TRACE, but called from a static function
 #define TRACE_STATIC(ptr, ...)                                                                                                                                 \
     LogGuard __guard;                                                                                                                                          \
     if (__guard.hasGuard()) {                                                                                                                                  \
-        Logger::log(ptr.get(), __FUNCTION__, {__VA_ARGS__});                                                                                                   \
+        if (Logger::is_recording()) {                                                                                                                          \
+            Logger::record(ptr.get(), __FUNCTION__, std::forward_as_tuple(__VA_ARGS__));                                                                       \
+        } else {                                                                                                                                               \
+            Logger::log(ptr.get(), __FUNCTION__, {__VA_ARGS__});                                                                                               \
+        }                                                                                                                                                      \
     }
 
 /// See Logger::log_res
 #define TRACE_RES(res)                                                                                                                                         \
     if (__guard.hasGuard()) {                                                                                                                                  \
-        Logger::log_res(res);                                                                                                                                  \
+        if (Logger::is_recording()) {                                                                                                                          \
+            Logger::record_res(res);                                                                                                                           \
+        } else {                                                                                                                                               \
+            Logger::log_res(res);                                                                                                                              \
+        }                                                                                                                                                      \
     }
 
 /******* Implementations ***********/
 template <typename T> void Logger::log_constr(T *inst, std::vector<rttr::variant> args)
 {
     std::unique_lock<std::mutex> lk(mut);
+    if (!has_room()) {
+        return;
+    }
     for (auto &a : args) {
         // this will rewove shared/weak/unique ptrs
         if (a.get_type().is_wrapper()) {
@@ -169,6 +341,10 @@ template <typename T> void Logger::log_constr(T *inst, std::vector<rttr::variant
 template <typename T> void Logger::log(T *inst, std::string fctName, std::vector<rttr::variant> args)
 {
     std::unique_lock<std::mutex> lk(mut);
+    if (!has_room()) {
+        result_awaiting = INT_MAX;
+        return;
+    }
     for (auto &a : args) {
         // this will rewove shared/weak/unique ptrs
         if (a.get_type().is_wrapper()) {
@@ -181,6 +357,32 @@ template <typename T> void Logger::log(T *inst, std::string fctName, std::vector
     result_awaiting = invoks.size() - 1;
 }
 
+template <typename T, typename... Args> void Logger::record_constr(T *inst, const std::tuple<Args...> &args)
+{
+    LogRecord record(LogRecord::Constructor, inst);
+    const auto className = rttr::type::get<T>().get_name();
+    record.addName(className.data(), className.size());
+    record.addAll(args);
+    commit_record(record);
+}
+
+template <typename T, typename... Args> void Logger::record(T *inst, const char *fctName, const std::tuple<Args...> &args)
+{
+    LogRecord record(LogRecord::Invocation, inst);
+    const auto className = rttr::type::get<T>().get_name();
+    record.addName(className.data(), className.size());
+    record.addName(fctName, strlen(fctName));
+    record.addAll(args);
+    commit_record(record);
+}
+
+template <typename T> void Logger::record_res(const T &result)
+{
+    LogRecord record(LogRecord::Result);
+    record.add(result);
+    commit_record(record);
+}
+
 template <typename T> size_t Logger::get_id_from_ptr(T *ptr)
 {
     const std::string class_name = rttr::type::get<T>().get_name().to_string();
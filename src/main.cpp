@@ -72,6 +72,11 @@ int main(int argc, char *argv[])
     qSetGlobalQHashSeed(0);
 
     Logger::init();
+    // Record model operations to a file for the whole session, instead of keeping them in memory
+    const QByteArray traceFile = qgetenv("KDENLIVE_TRACE_FILE");
+    if (!traceFile.isEmpty()) {
+        Logger::start_recording(traceFile.toStdString());
+    }
     QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     //TODO: is it a good option ?
     QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts, true);
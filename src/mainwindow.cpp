@@ -63,6 +63,7 @@
 #include "transitions/transitionlist/view/transitionlistwidget.hpp"
 #include "transitions/transitionsrepository.hpp"
 #include "utils/resourcewidget.h"
+#include "utils/memorybudget.hpp"
 #include "utils/thememanager.h"
 #include "utils/otioconvertions.h"
 
@@ -85,6 +86,7 @@
 #include <KDualAction>
 #include <KEditToolBar>
 #include <KIconTheme>
+#include <KIO/Global>
 #include <KMessageBox>
 #include <KNotifyConfigWidget>
 #include <KRecentDirs>
@@ -110,6 +112,7 @@
 #include <QPushButton>
 #include <QScreen>
 #include <QStandardPaths>
+#include <QTreeWidget>
 #include <QVBoxLayout>
 
 static const char version[] = KDENLIVE_VERSION;
@@ -199,6 +202,7 @@ void MainWindow::init()
     // QIcon::setThemeSearchPaths(QStringList() <<QStringLiteral(":/icons/"));
 
     new RenderingAdaptor(this);
+    new MemoryAdaptor(this);
     QString defaultProfile = KdenliveSettings::default_profile();
     pCore->setCurrentProfile(defaultProfile.isEmpty() ? ProjectManager::getDefaultProjectFormat() : defaultProfile);
     m_commandStack = new QUndoGroup();
@@ -1285,6 +1289,8 @@ void MainWindow::setupActions()
         slotRestart(true);
     });
 
+    addAction(QStringLiteral("memory_usage"), i18n("Memory Usage"), this, SLOT(slotShowMemoryUsage()), QIcon::fromTheme(QStringLiteral("view-statistics")));
+
     addAction("project_adjust_profile", i18n("Adjust Profile to Current Clip"), pCore->bin(), SLOT(adjustProjectProfileToItem()));
 
     m_playZone = addAction(QStringLiteral("monitor_play_zone"), i18n("Play Zone"), pCore->monitorManager(), SLOT(slotPlayZone()),
@@ -1369,7 +1375,15 @@ void MainWindow::setupActions()
     addAction(QStringLiteral("scale_16_preview"), scale_16);
     scale_16->setCheckable(true);
     scale_16->setData(16);
+    QAction *scale_auto = new QAction(i18n("Adaptive"), m_scaleGroup);
+    addAction(QStringLiteral("scale_auto_preview"), scale_auto);
+    scale_auto->setCheckable(true);
+    scale_auto->setToolTip(i18n("Lower the preview resolution when frames are dropped during playback"));
+    scale_auto->setData(0);
     switch (KdenliveSettings::previewScaling()) {
+        case 0:
+            scale_auto->setChecked(true);
+            break;
         case 2:
             scale_2->setChecked(true);
             break;
@@ -2016,6 +2030,16 @@ void MainWindow::scriptRender(const QString &url)
     m_renderWidget->slotPrepareExport(true, url);
 }
 
+QString MainWindow::memoryUsage()
+{
+    return MemoryBudget::get()->report();
+}
+
+qlonglong MainWindow::releaseMemory(qlonglong maxBytes)
+{
+    return MemoryBudget::get()->release(maxBytes);
+}
+
 void MainWindow::exitApp()
 {
     QApplication::exit(0);
@@ -3854,6 +3878,48 @@ void MainWindow::slotManageCache()
     d.exec();
 }
 
+void MainWindow::slotShowMemoryUsage()
+{
+    QDialog d(this);
+    d.setWindowTitle(i18n("Memory Usage"));
+    auto *lay = new QVBoxLayout;
+    auto *list = new QTreeWidget(&d);
+    list->setRootIsDecorated(false);
+    list->setHeaderLabels({i18n("Consumer"), i18n("Memory")});
+    auto *total = new QLabel(&d);
+    auto refresh = [list, total]() {
+        list->clear();
+        qint64 bytes = 0;
+        for (const MemoryBudget::Usage &usage : MemoryBudget::get()->usage()) {
+            auto *item = new QTreeWidgetItem(list, {usage.name, KIO::convertSize(KIO::filesize_t(usage.bytes))});
+            if (!usage.releasable) {
+                item->setToolTip(0, i18n("This memory cannot be released automatically"));
+            }
+            bytes += usage.bytes;
+        }
+        qint64 budget = MemoryBudget::budget();
+        total->setText(budget > 0 ? i18n("Total: %1 of %2", KIO::convertSize(KIO::filesize_t(bytes)), KIO::convertSize(KIO::filesize_t(budget)))
+                                  : i18n("Total: %1", KIO::convertSize(KIO::filesize_t(bytes))));
+    };
+    refresh();
+    QTimer timer;
+    timer.setInterval(1000);
+    connect(&timer, &QTimer::timeout, &d, refresh);
+    timer.start();
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+    QPushButton *releaseButton = buttonBox->addButton(i18n("Release Memory"), QDialogButtonBox::ActionRole);
+    connect(releaseButton, &QPushButton::clicked, &d, [refresh]() {
+        MemoryBudget::get()->release(0);
+        refresh();
+    });
+    connect(buttonBox, &QDialogButtonBox::rejected, &d, &QDialog::reject);
+    lay->addWidget(list);
+    lay->addWidget(total);
+    lay->addWidget(buttonBox);
+    d.setLayout(lay);
+    d.exec();
+}
+
 void MainWindow::slotUpdateCompositing(QAction *compose)
 {
     int mode = compose->data().toInt();
@@ -262,6 +262,10 @@ public slots:
     Q_SCRIPTABLE void addTimelineClip(const QString &url);
     Q_SCRIPTABLE void addEffect(const QString &effectId);
     Q_SCRIPTABLE void scriptRender(const QString &url);
+    /** @brief Returns the memory used by the caches, as a json document */
+    Q_SCRIPTABLE QString memoryUsage();
+    /** @brief Release cached data until the caches use less than maxBytes, returns the number of bytes freed */
+    Q_SCRIPTABLE qlonglong releaseMemory(qlonglong maxBytes);
     Q_NOREPLY void exitApp();
 
     void slotSwitchVideoThumbs();
@@ -459,6 +463,8 @@ private slots:
     void showTimelineToolbarMenu(const QPoint &pos);
     /** @brief Open Cached Data management dialog. */
     void slotManageCache();
+    /** @brief Open the memory usage dialog, listing the memory used by each cache. */
+    void slotShowMemoryUsage();
     void showMenuBar(bool show);
     /** @brief Change forced icon theme setting (asks for app restart). */
     void forceIconSet(bool force);
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kdenlivesettings.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "profiles/profilemodel.hpp"
+#include "utils/proxycache.hpp"
 #include "bin/clipcreator.hpp"
 
 #include "core.h"
@@ -74,6 +75,11 @@ ClipController::ClipController(const QString &clipId, const std::shared_ptr<Mlt:
                 path.prepend(pCore->currentDoc()->documentRoot());
             }
             m_usesProxy = true;
+            // Keep the proxy from being evicted from the shared cache
+            if (QFileInfo(proxy).isRelative()) {
+                proxy.prepend(pCore->currentDoc()->documentRoot());
+            }
+            ProxyCache::get()->use(proxy);
         } else if (m_service != QLatin1String("color") && m_service != QLatin1String("colour") && !path.isEmpty() && QFileInfo(path).isRelative() &&
                    path != QLatin1String("<producer>")) {
             path.prepend(pCore->currentDoc()->documentRoot());
@@ -146,6 +152,11 @@ void ClipController::addMasterProducer(const std::shared_ptr<Mlt::Producer> &pro
                 path.prepend(documentRoot);
             }
             m_usesProxy = true;
+            // Keep the proxy from being evicted from the shared cache
+            if (QFileInfo(proxy).isRelative()) {
+                proxy.prepend(documentRoot);
+            }
+            ProxyCache::get()->use(proxy);
         } else if (m_service != QLatin1String("color") && m_service != QLatin1String("colour") && !path.isEmpty() && QFileInfo(path).isRelative()) {
             path.prepend(documentRoot);
         }
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "framecache.h"
+
+#include <QMutexLocker>
+#include <mlt++/MltFrame.h>
+
+FrameCache::FrameCache(qint64 budget)
+    : m_size(0)
+    , m_budget(budget)
+    , m_revision(0)
+{
+}
+
+FrameCache::~FrameCache() = default;
+
+int FrameCache::revision() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_revision;
+}
+
+void FrameCache::insert(Mlt::Frame &frame, int revision)
+{
+    // Estimate the image size from the frame's current format
+    int width = frame.get_int("width");
+    int height = frame.get_int("height");
+    int format = frame.get_int("format");
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    qint64 size = mlt_image_format_size(mlt_image_format(format), width, height, nullptr);
+    QMutexLocker lock(&m_mutex);
+    if (revision != m_revision || size > m_budget) {
+        return;
+    }
+    const int position = frame.get_position();
+    auto existing = m_frames.find(position);
+    if (existing != m_frames.end()) {
+        remove(existing);
+    }
+    m_lru.push_front(position);
+    m_frames[position] = {std::make_shared<Mlt::Frame>(frame), size, m_lru.begin()};
+    m_size += size;
+    while (m_size > m_budget && !m_lru.empty()) {
+        remove(m_frames.find(m_lru.back()));
+    }
+}
+
+std::shared_ptr<Mlt::Frame> FrameCache::frame(int position)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_frames.find(position);
+    if (it == m_frames.end()) {
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    return it->second.frame;
+}
+
+void FrameCache::invalidate(int in, int out)
+{
+    QMutexLocker lock(&m_mutex);
+    m_revision++;
+    for (auto it = m_frames.begin(); it != m_frames.end();) {
+        if (it->first >= in && (out < 0 || it->first <= out)) {
+            auto next = std::next(it);
+            remove(it);
+            it = next;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FrameCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_revision++;
+    m_frames.clear();
+    m_lru.clear();
+    m_size = 0;
+}
+
+void FrameCache::setBudget(qint64 budget)
+{
+    QMutexLocker lock(&m_mutex);
+    m_budget = budget;
+    while (m_size > m_budget && !m_lru.empty()) {
+        remove(m_frames.find(m_lru.back()));
+    }
+}
+
+qint64 FrameCache::size() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_size;
+}
+
+qint64 FrameCache::release(qint64 bytes)
+{
+    QMutexLocker lock(&m_mutex);
+    qint64 initialSize = m_size;
+    while (initialSize - m_size < bytes && !m_lru.empty()) {
+        remove(m_frames.find(m_lru.back()));
+    }
+    return initialSize - m_size;
+}
+
+void FrameCache::remove(std::unordered_map<int, Entry>::iterator it)
+{
+    m_size -= it->second.size;
+    m_lru.erase(it->second.lru);
+    m_frames.erase(it);
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QMutex>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace Mlt {
+class Frame;
+}
+
+/** @class FrameCache
+    @brief A memory bounded cache of the frames displayed by a monitor, indexed by position.
+    Seeking again to a recently displayed position shows the cached frame instead of rendering the whole tractor again.
+    When a range of the timeline changes, the frames in that range are dropped and the revision counter is incremented.
+    A frame is only stored if no invalidation happened since it was requested, so that a render started before a change is never cached.
+    Frames are inserted from the consumer thread, so this class is thread safe.
+ */
+class FrameCache
+{
+public:
+    /** @param budget is the maximum memory used by the cached images, in bytes */
+    explicit FrameCache(qint64 budget);
+    ~FrameCache();
+
+    /** @brief Returns the revision to pass to insert for a frame requested now */
+    int revision() const;
+    /** @brief Store a rendered frame, unless the timeline changed since revision */
+    void insert(Mlt::Frame &frame, int revision);
+    /** @brief Returns the frame cached at position, or nullptr */
+    std::shared_ptr<Mlt::Frame> frame(int position);
+    /** @brief Drop the frames between in and out (included). An out of -1 drops all frames after in */
+    void invalidate(int in, int out);
+    void clear();
+    void setBudget(qint64 budget);
+    /** @brief Returns the memory used by the cached images, in bytes */
+    qint64 size() const;
+    /** @brief Drop the least recently used frames until at least bytes are freed, returns the number of bytes freed */
+    qint64 release(qint64 bytes);
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Mlt::Frame> frame;
+        qint64 size;
+        std::list<int>::iterator lru;
+    };
+    mutable QMutex m_mutex;
+    std::unordered_map<int, Entry> m_frames;
+    // Cached positions, most recently used first
+    std::list<int> m_lru;
+    qint64 m_size;
+    qint64 m_budget;
+    int m_revision;
+
+    /** @brief Remove an entry. m_mutex must be locked */
+    void remove(std::unordered_map<int, Entry>::iterator it);
+};
+
+#endif
@@ -32,11 +32,13 @@
 #include <klocalizedstring.h>
 
 #include "core.h"
+#include "framecache.h"
 #include "glwidget.h"
 #include "kdenlivesettings.h"
 #include "monitorproxy.h"
 #include "profiles/profilemodel.hpp"
 #include "timeline2/view/qml/timelineitems.h"
+#include "utils/memorybudget.hpp"
 #include <mlt++/Mlt.h>
 
 #ifndef GL_UNPACK_ROW_LENGTH
@@ -93,6 +95,7 @@ GLWidget::GLWidget(int id, QObject *parent)
     , m_isLoopMode(false)
     , m_offset(QPoint(0, 0))
     , m_fbo(nullptr)
+    , m_previewScaling(1)
     , m_shareContext(nullptr)
     , m_openGLSync(false)
     , m_ClientWaitSync(nullptr)
@@ -122,6 +125,10 @@ GLWidget::GLWidget(int id, QObject *parent)
     connect(&m_refreshTimer, &QTimer::timeout, this, &GLWidget::refresh);
     m_producer = m_blackClip;
     rootContext()->setContextProperty("markersModel", 0);
+    if (m_id == Kdenlive::ProjectMonitor && KdenliveSettings::monitorcachesize() > 0) {
+        m_frameCache.reset(new FrameCache(qint64(KdenliveSettings::monitorcachesize()) * 1024 * 1024));
+    }
+    registerMemoryUsage();
     if (!initGPUAccel()) {
         disableGPUAccel();
     }
@@ -137,6 +144,9 @@ GLWidget::GLWidget(int id, QObject *parent)
 
 GLWidget::~GLWidget()
 {
+    for (int id : m_memoryConsumers) {
+        MemoryBudget::get()->unregisterConsumer(id);
+    }
     // C & D
     delete m_glslManager;
     delete m_threadStartEvent;
@@ -160,6 +170,23 @@ GLWidget::~GLWidget()
     // delete pCore->getCurrentProfile();
 }
 
+void GLWidget::registerMemoryUsage()
+{
+    if (m_frameCache) {
+        m_memoryConsumers << MemoryBudget::get()->registerConsumer(
+            i18n("Monitor frames"), [this]() { return m_frameCache->size(); }, [this](qint64 bytes) { return m_frameCache->release(bytes); });
+    }
+    m_memoryConsumers << MemoryBudget::get()->registerConsumer(i18n("Monitor textures"), [this]() {
+        // Estimated from the profile size: the yuv420p textures and the rgba framebuffer used for frame analysis
+        qint64 pixels = qint64(m_profileSize.width()) * m_profileSize.height();
+        qint64 bytes = m_texture[0] != 0u ? pixels * 3 / 2 : 0;
+        if (m_fbo != nullptr) {
+            bytes += pixels * 4;
+        }
+        return bytes;
+    });
+}
+
 void GLWidget::updateAudioForAnalysis()
 {
     if (m_frameRenderer) {
@@ -646,6 +673,10 @@ void GLWidget::wheelEvent(QWheelEvent *event)
 
 void GLWidget::requestSeek(int position)
 {
+    if (showCachedFrame(position)) {
+        return;
+    }
+    addRenderRequest(position);
     m_consumer->set("scrub_audio", 1);
     m_producer->seek(position);
     if (!qFuzzyIsNull(m_producer->get_speed())) {
@@ -677,9 +708,84 @@ void GLWidget::refresh()
     if (m_consumer->is_stopped()) {
         m_consumer->start();
     }
+    if (m_producer) {
+        addRenderRequest(m_producer->position());
+    }
     m_consumer->set("refresh", 1);
 }
 
+bool GLWidget::showCachedFrame(int position)
+{
+    // Cached frames are only displayed through the CPU pipeline, while paused, and when no rendered frame is on its way
+    if (!m_frameCache || m_glslManager || m_frameRenderer == nullptr || !qFuzzyIsNull(m_producer->get_speed())) {
+        return false;
+    }
+    {
+        QMutexLocker lock(&m_renderMutex);
+        if (!m_pendingRenders.isEmpty()) {
+            return false;
+        }
+    }
+    std::shared_ptr<Mlt::Frame> frame = m_frameCache->frame(position);
+    if (!frame || !m_frameRenderer->semaphore()->tryAcquire(1, 0)) {
+        return false;
+    }
+    // Keep the producer in sync so that playback and the next refresh start from there
+    m_producer->seek(position);
+    QMetaObject::invokeMethod(m_frameRenderer, "showFrame", Qt::QueuedConnection, Q_ARG(Mlt::Frame, *frame));
+    return true;
+}
+
+void GLWidget::addRenderRequest(int position)
+{
+    if (m_glslManager) {
+        // Frames rendered through movit are not shown by on_frame_show and never cached, nothing would take the request
+        return;
+    }
+    QMutexLocker lock(&m_renderMutex);
+    m_pendingRenders.append({position, m_frameCache ? m_frameCache->revision() : 0});
+}
+
+int GLWidget::takeRenderRequest(int position)
+{
+    QMutexLocker lock(&m_renderMutex);
+    int last = -1;
+    for (int i = m_pendingRenders.size() - 1; i >= 0; --i) {
+        if (m_pendingRenders.at(i).position == position) {
+            last = i;
+            break;
+        }
+    }
+    if (last == -1) {
+        return -1;
+    }
+    // The consumer may render one frame for several requests at the same position, so use the oldest revision.
+    // Requests before it were skipped by the consumer
+    int revision = m_pendingRenders.at(last).revision;
+    for (int i = 0; i <= last; ++i) {
+        const RenderRequest &request = m_pendingRenders.at(i);
+        if (request.position == position) {
+            revision = qMin(revision, request.revision);
+        }
+    }
+    m_pendingRenders.erase(m_pendingRenders.begin(), m_pendingRenders.begin() + last + 1);
+    return revision;
+}
+
+void GLWidget::invalidateFrameCache(int in, int out)
+{
+    if (m_frameCache) {
+        m_frameCache->invalidate(in, out);
+    }
+}
+
+void GLWidget::clearFrameCache()
+{
+    if (m_frameCache) {
+        m_frameCache->clear();
+    }
+}
+
 bool GLWidget::checkFrameNumber(int pos, int offset, bool isPlaying)
 {
     const double speed = m_producer->get_speed();
@@ -927,10 +1033,16 @@ int GLWidget::droppedFrames() const
 void GLWidget::resetDrops()
 {
     if (m_consumer) {
+        m_adaptive.droppedBeforeReset += droppedFrames();
         m_consumer->set("drop_count", 0);
     }
 }
 
+int GLWidget::previewScaling() const
+{
+    return m_previewScaling;
+}
+
 void GLWidget::stopCapture()
 {
     if (strcmp(m_consumer->get("mlt_service"), "multi") == 0) {
@@ -1037,6 +1149,7 @@ int GLWidget::reconfigureMulti(const QString &params, const QString &path, Mlt::
 
 int GLWidget::reconfigure()
 {
+    clearFrameCache();
     int error = 0;
     // use SDL for audio, OpenGL for video
     QString serviceName = property("mlt_service").toString();
@@ -1113,8 +1226,8 @@ int GLWidget::reconfigure()
             dropFrames = -dropFrames;
         }
         m_consumer->set("real_time", dropFrames);
-        if (KdenliveSettings::previewScaling() > 1) {
-            m_consumer->set("scale", 1.0 / KdenliveSettings::previewScaling());
+        if (m_previewScaling > 1) {
+            m_consumer->set("scale", 1.0 / m_previewScaling);
         }
         // C & D
         if (m_glslManager) {
@@ -1247,6 +1360,7 @@ void GLWidget::onFrameDisplayed(const SharedFrame &frame)
     m_sendFrame = sendFrameForAnalysis;
     m_contextSharedAccess.unlock();
     update();
+    checkAdaptiveScaling();
 }
 
 void GLWidget::mouseReleaseEvent(QMouseEvent *event)
@@ -1365,8 +1479,13 @@ void GLWidget::updateTexture(GLuint yName, GLuint uName, GLuint vName)
 void GLWidget::on_frame_show(mlt_consumer, void *self, mlt_frame frame_ptr)
 {
     Mlt::Frame frame(frame_ptr);
+    auto *widget = static_cast<GLWidget *>(self);
+    const int revision = widget->takeRenderRequest(frame.get_position());
     if (frame.get_int("rendered") != 0) {
-        auto *widget = static_cast<GLWidget *>(self);
+        if (widget->m_frameCache && revision >= 0 && qFuzzyIsNull(frame.get_double("_speed"))) {
+            widget->m_frameCache->insert(frame, revision);
+            MemoryBudget::get()->requestCheck();
+        }
         int timeout = (widget->consumer()->get_int("real_time") > 0) ? 0 : 1000;
         if ((widget->m_frameRenderer != nullptr) && widget->m_frameRenderer->semaphore()->tryAcquire(1, timeout)) {
             QMetaObject::invokeMethod(widget->m_frameRenderer, "showFrame", Qt::QueuedConnection, Q_ARG(Mlt::Frame, frame));
@@ -1802,9 +1921,22 @@ void GLWidget::setConsumerProperty(const QString &name, const QString &value)
 
 void GLWidget::updateScaling()
 {
+    int scaling = KdenliveSettings::previewScaling();
+    if (scaling == 0) {
+        // Adaptive mode starts at full resolution, then follows playback performance
+        scaling = 1;
+        m_adaptive = AdaptiveScaling();
+    }
+    applyScaling(scaling);
+}
+
+void GLWidget::applyScaling(int scaling)
+{
+    m_previewScaling = scaling;
+    clearFrameCache();
 #if LIBMLT_VERSION_INT >= MLT_VERSION_PREVIEW_SCALE
     int previewHeight = pCore->getCurrentFrameSize().height();
-    switch (KdenliveSettings::previewScaling()) {
+    switch (scaling) {
         case 2:
             previewHeight = qMin(previewHeight, 720);
             break;
@@ -1841,4 +1973,52 @@ void GLWidget::updateScaling()
         resizeGL(width(), height());
     }
 #endif
+    emit previewScalingChanged(m_previewScaling);
+}
+
+void GLWidget::checkAdaptiveScaling()
+{
+    if (KdenliveSettings::previewScaling() != 0 || !m_producer || qFuzzyIsNull(m_producer->get_speed())) {
+        // Only measure during playback in adaptive mode
+        m_adaptive.window.invalidate();
+        return;
+    }
+    if (!m_adaptive.window.isValid()) {
+        m_adaptive.window.start();
+        m_adaptive.frames = 0;
+        m_adaptive.dropsAtStart = m_adaptive.droppedBeforeReset + droppedFrames();
+        return;
+    }
+    m_adaptive.frames++;
+    const qint64 elapsed = m_adaptive.window.elapsed();
+    if (elapsed < 1000) {
+        return;
+    }
+    // Frames that were not rendered in time, either dropped by the consumer or displayed late
+    const double expected = pCore->getCurrentFps() * elapsed / 1000.;
+    const int drops = m_adaptive.droppedBeforeReset + droppedFrames() - m_adaptive.dropsAtStart;
+    const double missed = qMax(double(drops), expected - m_adaptive.frames) / expected;
+    m_adaptive.window.invalidate();
+    if (missed > 0.1) {
+        m_adaptive.goodWindows = 0;
+        m_adaptive.badWindows++;
+    } else if (missed < 0.02) {
+        m_adaptive.badWindows = 0;
+        m_adaptive.goodWindows++;
+    }
+    // Hysteresis: step down after 2 bad seconds, up after several good ones
+    if (m_adaptive.badWindows >= 2 && m_previewScaling < 16) {
+        if (m_adaptive.lastStepUp.isValid() && !m_adaptive.lastStepUp.hasExpired(10000)) {
+            // The higher resolution could not be sustained, wait longer before trying again
+            m_adaptive.requiredGoodWindows = qMin(2 * m_adaptive.requiredGoodWindows, 60);
+        }
+        m_adaptive.badWindows = 0;
+        m_adaptive.goodWindows = 0;
+        applyScaling(2 * m_previewScaling);
+    } else if (m_adaptive.goodWindows >= m_adaptive.requiredGoodWindows && m_previewScaling > 1) {
+        m_adaptive.badWindows = 0;
+        m_adaptive.goodWindows = 0;
+        m_adaptive.lastStepUp.start();
+        applyScaling(m_previewScaling / 2);
+    }
 }
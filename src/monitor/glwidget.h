@@ -19,6 +19,7 @@
 #ifndef GLWIDGET_H
 #define GLWIDGET_H
 
+#include <QElapsedTimer>
 #include <QFont>
 #include <QMutex>
 #include <QOffscreenSurface>
@@ -47,6 +48,7 @@ class Producer;
 class Consumer;
 } // namespace Mlt
 
+class FrameCache;
 class RenderThread;
 class FrameRenderer;
 class MonitorProxy;
@@ -115,6 +117,8 @@ public:
     int realTime() const;
     int droppedFrames() const;
     void resetDrops();
+    /** @brief Returns the preview scaling factor in use. In adaptive mode (previewScaling setting is 0), it follows playback performance */
+    int previewScaling() const;
     bool checkFrameNumber(int pos, int offset, bool isPlaying);
     /** @brief Return current timeline position */
     int getCurrentPos() const;
@@ -141,6 +145,8 @@ public:
     void setConsumerProperty(const QString &name, const QString &value);
     /** @brief Clear consumer cache */
     void purgeCache();
+    /** @brief Drop the frames kept for scrubbing between in and out. An out of -1 drops all frames after in */
+    void invalidateFrameCache(int in, int out);
 
 protected:
     void mouseReleaseEvent(QMouseEvent *event) override;
@@ -185,6 +191,7 @@ signals:
     void passKeyEvent(QKeyEvent *);
     void panView(const QPoint &diff);
     void activateMonitor();
+    void previewScalingChanged(int scaling);
 
 protected:
     Mlt::Filter *m_glslManager;
@@ -239,6 +246,51 @@ private:
     void refreshSceneLayout();
     void resetZoneMode();
 
+    /** @brief Measures of the adaptive preview scaling, taken over windows of about one second of playback */
+    struct AdaptiveScaling
+    {
+        QElapsedTimer window;
+        QElapsedTimer lastStepUp;
+        int frames = 0;
+        int dropsAtStart = 0;
+        // dropped frames counted before the consumer drop count was reset
+        int droppedBeforeReset = 0;
+        int badWindows = 0;
+        int goodWindows = 0;
+        // number of consecutive good windows needed to step up, grows when a step up had to be reverted
+        int requiredGoodWindows = 5;
+    };
+    AdaptiveScaling m_adaptive;
+    int m_previewScaling;
+    /** @brief Set the preview scaling factor on the consumer */
+    void applyScaling(int scaling);
+    /** @brief Step the adaptive preview scaling down when frames are dropped or late, up when playback is smooth */
+    void checkAdaptiveScaling();
+
+    /** @brief Recently displayed frames of the project monitor, reused when seeking back to them */
+    std::unique_ptr<FrameCache> m_frameCache;
+    /** @brief A render request sent to the consumer, with the frame cache revision at the time of the request */
+    struct RenderRequest
+    {
+        int position;
+        int revision;
+    };
+    /** @brief Render requests that were not displayed yet, oldest first */
+    QList<RenderRequest> m_pendingRenders;
+    QMutex m_renderMutex;
+    /** @brief Register a render request for position, tagged with the current frame cache revision */
+    void addRenderRequest(int position);
+    /** @brief Mark the requests up to the last one for position as done.
+        Returns the oldest revision requested for position, or -1 if the frame was not requested and must not be cached */
+    int takeRenderRequest(int position);
+    /** @brief Display the cached frame at position instead of rendering it, returns false if not possible */
+    bool showCachedFrame(int position);
+    void clearFrameCache();
+    /** @brief Ids of the frame cache and textures in the MemoryBudget */
+    QList<int> m_memoryConsumers;
+    /** @brief Register the memory used by this monitor in the MemoryBudget */
+    void registerMemoryUsage();
+
     /* OpenGL context management. Interfaces to MLT according to the configured render pipeline.
      */
 private slots:
@@ -164,26 +164,9 @@ Monitor::Monitor(Kdenlive::MonitorId id, MonitorManager *manager, QWidget *paren
     connect(m_glMonitor, &GLWidget::activateMonitor, this, &AbstractMonitor::slotActivateMonitor, Qt::DirectConnection);
     connect(manager, &MonitorManager::updatePreviewScaling, [this]() {
         m_glMonitor->updateScaling();
-        switch (KdenliveSettings::previewScaling()) {
-            case 2:
-                m_scalingLabel->setText(i18n("720p"));
-                break;
-            case 4:
-                m_scalingLabel->setText(i18n("540p"));
-                break;
-            case 8:
-                m_scalingLabel->setText(i18n("360p"));
-                break;
-            case 16:
-                m_scalingLabel->setText(i18n("270p"));
-                break;
-            default:
-                m_scalingLabel->setText(QString());
-                break;
-        }
-        m_scalingLabel->setFixedWidth(m_scalingLabel->text().isEmpty() ? 0 : QWIDGETSIZE_MAX);
         refreshMonitorIfActive();
     });
+    connect(m_glMonitor, &GLWidget::previewScalingChanged, this, &Monitor::updateScalingInfo);
     m_videoWidget = QWidget::createWindowContainer(qobject_cast<QWindow *>(m_glMonitor));
     m_videoWidget->setAcceptDrops(true);
     auto *leventEater = new QuickEventEater(this);
@@ -1705,6 +1688,35 @@ void Monitor::onFrameDisplayed(const SharedFrame &frame)
     checkDrops(m_glMonitor->droppedFrames());
 }
 
+void Monitor::updateScalingInfo(int scaling)
+{
+    QString resolution;
+    switch (scaling) {
+        case 2:
+            resolution = i18n("720p");
+            break;
+        case 4:
+            resolution = i18n("540p");
+            break;
+        case 8:
+            resolution = i18n("360p");
+            break;
+        case 16:
+            resolution = i18n("270p");
+            break;
+        default:
+            break;
+    }
+    if (KdenliveSettings::previewScaling() == 0) {
+        // Adaptive scaling, always show the resolution in use
+        m_scalingLabel->setText(resolution.isEmpty() ? i18n("Auto") : i18n("Auto %1", resolution));
+    } else {
+        m_scalingLabel->setText(resolution);
+    }
+    m_scalingLabel->setFixedWidth(m_scalingLabel->text().isEmpty() ? 0 : QWIDGETSIZE_MAX);
+    m_qmlManager->setProperty(QStringLiteral("previewScale"), resolution);
+}
+
 void Monitor::checkDrops(int dropped)
 {
     if (m_droppedTimer.isValid()) {
@@ -1962,6 +1974,7 @@ void Monitor::loadQmlScene(MonitorSceneType type)
         break;
     }
     m_qmlManager->setProperty(QStringLiteral("fps"), QString::number(pCore->getCurrentFps(), 'g', 2));
+    updateScalingInfo(m_glMonitor->previewScaling());
 }
 
 void Monitor::setQmlProperty(const QString &name, const QVariant &value)
@@ -2180,6 +2193,11 @@ void Monitor::purgeCache()
     m_glMonitor->purgeCache();
 }
 
+void Monitor::invalidateFrameCache(int in, int out)
+{
+    m_glMonitor->invalidateFrameCache(in, out);
+}
+
 void Monitor::updateBgColor()
 {
     m_glMonitor->m_bgColor = KdenliveSettings::window_background();
@@ -228,6 +228,8 @@ private:
     void updateQmlDisplay(int currentOverlay);
     /** @brief Check and display dropped frames */
     void checkDrops(int dropped);
+    /** @brief Display the preview resolution in use in the toolbar and the monitor overlay */
+    void updateScalingInfo(int scaling);
     /** @brief Create temporary Mlt::Tractor holding a clip and it's effectless clone */
     void buildSplitEffect(Mlt::Producer *original);
     /** @brief Reset and hide speed info label */
@@ -327,6 +329,8 @@ public slots:
     void forceMonitorRefresh();
     /** @brief Clear read ahead cache, to ensure up to date audio */
     void purgeCache();
+    /** @brief Drop the frames kept for scrubbing between in and out. An out of -1 drops all frames after in */
+    void invalidateFrameCache(int in, int out);
 
 signals:
     void screenChanged(int screenIndex);
@@ -18,6 +18,7 @@ Item {
     property double scaley
     property bool dropped: false
     property string fps: '-'
+    property string previewScale
     property bool showMarkers: false
     property bool showTimecode: false
     property bool showFps: false
@@ -138,7 +139,7 @@ Item {
                 color: root.dropped ? "red" : "white"
                 style: Text.Outline;
                 styleColor: "black"
-                text: i18n("%1 fps", root.fps)
+                text: root.previewScale == '' ? i18n("%1 fps", root.fps) : i18n("%1 fps (%2)", root.fps, root.previewScale)
                 visible: root.showFps
                 anchors {
                     right: timecode.visible ? timecode.left : parent.right
@@ -11,6 +11,7 @@
 #include "abstractscopewidget.h"
 
 #include "monitor/monitor.h"
+#include "utils/memorybudget.hpp"
 
 #include <QColor>
 #include <QMenu>
@@ -92,10 +93,16 @@ AbstractScopeWidget::AbstractScopeWidget(bool trackMouse, QWidget *parent)
     // Causes the mouseMoved signal to be emitted when the mouse moves inside the
     // widget, even when no mouse button is pressed.
     this->setMouseTracking(trackMouse);
+
+    // Images are only assigned in the main thread, where the usage is queried
+    m_memoryConsumer = MemoryBudget::get()->registerConsumer(i18n("Scopes"), [this]() {
+        return (qint64)(m_imgHUD.sizeInBytes() + m_imgScope.sizeInBytes() + m_imgBackground.sizeInBytes() + m_scopeImage.sizeInBytes());
+    });
 }
 
 AbstractScopeWidget::~AbstractScopeWidget()
 {
+    MemoryBudget::get()->unregisterConsumer(m_memoryConsumer);
     writeConfig();
 
     delete m_menu;
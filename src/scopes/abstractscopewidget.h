@@ -267,6 +267,9 @@ private:
 
     QString m_widgetName;
 
+    /** Id of this scope's images in the MemoryBudget */
+    int m_memoryConsumer;
+
     void prodHUDThread();
     void prodScopeThread();
     void prodBackgroundThread();
@@ -73,6 +73,8 @@ AudioSpectrum::AudioSpectrum(QWidget *parent)
     m_ui->windowSize->addItem(QStringLiteral("512"), QVariant(512));
     m_ui->windowSize->addItem(QStringLiteral("1024"), QVariant(1024));
     m_ui->windowSize->addItem(QStringLiteral("2048"), QVariant(2048));
+    m_ui->windowSize->addItem(QStringLiteral("4096"), QVariant(4096));
+    m_ui->windowSize->addItem(QStringLiteral("8192"), QVariant(8192));
 
     m_ui->windowFunction->addItem(i18n("Rectangular window"), FFTTools::Window_Rect);
     m_ui->windowFunction->addItem(i18n("Triangular window"), FFTTools::Window_Triangle);
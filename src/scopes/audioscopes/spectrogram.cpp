@@ -63,6 +63,8 @@ Spectrogram::Spectrogram(QWidget *parent)
     m_ui->windowSize->addItem(QStringLiteral("512"), QVariant(512));
     m_ui->windowSize->addItem(QStringLiteral("1024"), QVariant(1024));
     m_ui->windowSize->addItem(QStringLiteral("2048"), QVariant(2048));
+    m_ui->windowSize->addItem(QStringLiteral("4096"), QVariant(4096));
+    m_ui->windowSize->addItem(QStringLiteral("8192"), QVariant(8192));
 
     m_ui->windowFunction->addItem(i18n("Rectangular window"), FFTTools::Window_Rect);
     m_ui->windowFunction->addItem(i18n("Triangular window"), FFTTools::Window_Triangle);
@@ -319,20 +321,14 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
         m_ui->labelFFTSizeNumber->setText(QVariant(fftWindow).toString());
 
         if (newDataAvailable) {
-
-            auto *freqSpectrum = new float[(uint)fftWindow / 2];
-
             // Get the spectral power distribution of the input samples,
-            // using the given window size and function
-            FFTTools::WindowType windowType = (FFTTools::WindowType)m_ui->windowFunction->itemData(m_ui->windowFunction->currentIndex()).toInt();
-            m_fftTools.fftNormalized(audioFrame, 0, (uint)num_channels, freqSpectrum, windowType, (uint)fftWindow, 0);
-
+            // using the given window size and function.
             // This method might be called also when a simple refresh is required.
             // In this case there is no data to append to the history. Only append new data.
             QVector<float> spectrumVector(fftWindow / 2);
-            memcpy(spectrumVector.data(), &freqSpectrum[0], (uint)fftWindow / 2 * sizeof(float));
+            FFTTools::WindowType windowType = (FFTTools::WindowType)m_ui->windowFunction->itemData(m_ui->windowFunction->currentIndex()).toInt();
+            m_fftTools.fftNormalized(audioFrame, 0, (uint)num_channels, spectrumVector.data(), windowType, (uint)fftWindow, 0);
             m_fftHistory.prepend(spectrumVector);
-            delete[] freqSpectrum;
         }
 #ifdef DEBUG_SPECTROGRAM
         else {
@@ -345,38 +341,37 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
             m_fftHistory.removeLast();
         }
 
-        // Draw the spectrum
-        QImage spectrum(m_scopeRect.size(), QImage::Format_ARGB32);
-        spectrum.fill(qRgba(0, 0, 0, 0));
-        QPainter davinci(&spectrum);
         const int h = m_innerScopeRect.height();
         const int leftDist = m_innerScopeRect.left() - m_scopeRect.left();
         const int topDist = m_innerScopeRect.top() - m_scopeRect.top();
+        const int lastLine = topDist + h - 1;
         int windowSize;
         int y;
         bool completeRedraw = true;
 
-        if (m_fftHistoryImg.size() == m_scopeRect.size() && !m_parameterChanged) {
+        if (m_fftHistoryImg.size() == m_scopeRect.size() && m_fftHistoryImg.format() == QImage::Format_ARGB32 && !m_parameterChanged) {
             // The size of the widget and the parameters (like min/max dB) have not changed since last time,
-            // so we can re-use it, shift it by one pixel, and render the single remaining line. Usually about
-            // 10 times faster for a widget height of around 400 px.
+            // so we can re-use it, scroll it up by one line in place, and render the single remaining line.
             if (newDataAvailable) {
-                davinci.drawImage(0, -1, m_fftHistoryImg);
-            } else {
-                // spectrum = m_fftHistoryImg does NOT work, leads to segfaults (anyone knows why, please tell me)
-                davinci.drawImage(0, 0, m_fftHistoryImg);
+                const int bytesPerLine = m_fftHistoryImg.bytesPerLine();
+                uchar *bits = m_fftHistoryImg.bits();
+                memmove(bits, bits + bytesPerLine, size_t(bytesPerLine) * size_t(lastLine));
             }
             completeRedraw = false;
+        } else {
+            m_fftHistoryImg = QImage(m_scopeRect.size(), QImage::Format_ARGB32);
+            m_fftHistoryImg.fill(qRgba(0, 0, 0, 0));
         }
 
         y = 0;
         if ((newData != 0) || m_parameterChanged) {
             m_parameterChanged = false;
             bool peak = false;
+            const bool highlightPeaks = m_aHighlightPeaks->isChecked();
+            const QRgb highlightColor = AbstractScopeWidget::colHighlightDark.rgba();
 
             QVector<float> dbMap;
             uint right;
-            ////////////////FIXME
             for (auto &it : m_fftHistory) {
 
                 windowSize = it.size();
@@ -385,6 +380,8 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
                 right = uint(((float)m_freqMax) / ((float)m_freq / 2.) * float(windowSize - 1));
                 dbMap = FFTTools::interpolatePeakPreserving(it, (uint)m_innerScopeRect.width(), 0, right, -180);
 
+                // Write the line directly into the image buffer instead of going through setPixel()
+                auto *line = reinterpret_cast<QRgb *>(m_fftHistoryImg.scanLine(lastLine - y)) + leftDist;
                 for (int i = 0; i < dbMap.size(); ++i) {
                     float val;
                     val = dbMap[i];
@@ -397,10 +394,10 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
                     } else if (val > 1) {
                         val = 1;
                     }
-                    if (!peak || !m_aHighlightPeaks->isChecked()) {
-                        spectrum.setPixel(leftDist + i, topDist + h - 1 - y, m_colorMap[(int)(val * 255)]);
+                    if (!peak || !highlightPeaks) {
+                        line[i] = m_colorMap[(int)(val * 255)];
                     } else {
-                        spectrum.setPixel(leftDist + i, topDist + h - 1 - y, AbstractScopeWidget::colHighlightDark.rgba());
+                        line[i] = highlightColor;
                     }
                 }
 
@@ -424,10 +421,8 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
         qCDebug(KDENLIVE_LOG) << QString("Total storage used: %1 kB").arg((double)storedBytes / 1000, 0, 'f', 2);
 #endif
 
-        m_fftHistoryImg = spectrum;
-
         emit signalScopeRenderingFinished((uint)timer.elapsed(), 1);
-        return spectrum;
+        return m_fftHistoryImg;
     }
     emit signalScopeRenderingFinished(0, 1);
     return QImage();
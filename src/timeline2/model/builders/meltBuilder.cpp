@@ -35,6 +35,8 @@
 #include <QDebug>
 #include <QProgressDialog>
 #include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <mlt++/MltPlaylist.h>
 #include <mlt++/MltProducer.h>
 #include <mlt++/MltProfile.h>
@@ -44,10 +46,209 @@
 
 static QStringList m_errorMessage;
 
-bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, Mlt::Tractor &track,
-                            const std::unordered_map<QString, QString> &binIdCorresp, Fun &undo, Fun &redo, bool audioTrack, QProgressDialog *progressDialog = nullptr);
-bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, Mlt::Playlist &track,
-                            const std::unordered_map<QString, QString> &binIdCorresp, Fun &undo, Fun &redo, bool audioTrack, QProgressDialog *progressDialog = nullptr);
+namespace {
+
+// This function tries to recover the state of the producer (audio or video or both)
+PlaylistState::ClipState inferState(const std::shared_ptr<Mlt::Producer> &prod, bool audioTrack)
+{
+    auto getProperty = [prod](const QString &name) {
+        if (prod->parent().is_valid()) {
+            return QString::fromUtf8(prod->parent().get(name.toUtf8().constData()));
+        }
+        return QString::fromUtf8(prod->get(name.toUtf8().constData()));
+    };
+    auto getIntProperty = [prod](const QString &name) {
+        if (prod->parent().is_valid()) {
+            return prod->parent().get_int(name.toUtf8().constData());
+        }
+        return prod->get_int(name.toUtf8().constData());
+    };
+    QString service = getProperty("mlt_service");
+    std::pair<bool, bool> VidAud{true, true};
+    VidAud.first = getIntProperty("set.test_image") == 0;
+    VidAud.second = getIntProperty("set.test_audio") == 0;
+    if (audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("video_index")) == -1))) {
+        VidAud.first = false;
+    }
+    if (!audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("audio_index")) == -1))) {
+        VidAud.second = false;
+    }
+    return stateFromBool(VidAud);
+}
+
+/* @brief A clip found while scanning a playlist, ready to be turned into a ClipModel */
+struct ClipLoadPlan
+{
+    std::shared_ptr<Mlt::Producer> clip;
+    int position;
+    QString binId;
+    PlaylistState::ClipState state;
+    // True if the resolved bin id still has to be written back to the parent producer
+    bool assignId;
+};
+
+/* @brief Result of the scan of one MLT playlist of a track */
+struct PlaylistLoadPlan
+{
+    std::shared_ptr<Mlt::Playlist> playlist;
+    std::vector<ClipLoadPlan> clips;
+    QStringList errors;
+    bool valid = true;
+};
+
+/* @brief Everything needed to fill a track that was already inserted in the timeline */
+struct TrackLoadPlan
+{
+    int tid;
+    bool audioTrack;
+    // Tractor of a double track, whose effects are imported after its playlists
+    std::shared_ptr<Mlt::Service> trackService;
+    std::vector<PlaylistLoadPlan> playlists;
+};
+
+/* @brief Scans a playlist: resolves the bin id and state of each clip.
+   This only reads the MLT objects of the track and the bin id correspondence, so the playlists of different tracks can be scanned in parallel.
+   Nothing is written to the producers here, this is done when the plan is applied.
+*/
+void scanPlaylist(PlaylistLoadPlan &plan, const std::unordered_map<QString, QString> &binIdCorresp, bool audioTrack)
+{
+    Mlt::Playlist &track = *plan.playlist.get();
+    for (int i = 0; i < track.count(); i++) {
+        if (track.is_blank(i)) {
+            continue;
+        }
+        std::shared_ptr<Mlt::Producer> clip(track.get_clip(i));
+        int position = track.clip_start(i);
+        switch (clip->type()) {
+        case tractor_type:
+            if (QString(clip->parent().get("kdenlive:id")).isEmpty() && QString(clip->get("kdenlive:id")).isEmpty()) {
+                // A nested timeline that does not come from a bin clip, we cannot edit it
+                qDebug() << "ERROR : nested timeline without bin clip on track" << track.get("id") << "position" << position;
+                plan.errors << i18n("Nested timeline %1 found on track %2 at %3 is not in the project bin, skipped.", clip->parent().get("id"), track.get("id"), position);
+                break;
+            }
+            // Nested timelines loaded from a playlist clip are handled as any other bin clip
+            Q_FALLTHROUGH();
+        case unknown_type:
+        case producer_type: {
+            QString binId;
+            bool assignId = false;
+            if (clip->parent().get_int("_kdenlive_processed") == 1) {
+                // This is a bin clip, already processed no need to change id
+                binId = QString(clip->parent().get("kdenlive:id"));
+            } else {
+                QString clipId = clip->parent().get("kdenlive:id");
+                if (clipId.startsWith(QStringLiteral("slowmotion"))) {
+                    clipId = clipId.section(QLatin1Char(':'), 1, 1);
+                }
+                if (clipId.isEmpty()) {
+                    clipId = clip->get("kdenlive:id");
+                }
+                if (binIdCorresp.count(clipId) == 0) {
+                    // Project was somehow corrupted
+                    qDebug()<<"=== WARNING, CANNOT FIND CLIP WITH ID: "<<clipId<<" IN BIN PLAYLIST";
+                    QStringList fixedId = pCore->projectItemModel()->getClipByUrl(QFileInfo(clip->parent().get("resource")));
+                    if (!fixedId.isEmpty()) {
+                        binId = fixedId.first();
+                        plan.errors << i18n("Invalid clip %1 (%2) not found in project bin, recovered.", clip->parent().get("id"), clipId);
+                    } else {
+                        qWarning()<<"Warning, clip in timeline has no parent in bin: "<<clip->parent().get("id");
+                        plan.errors << i18n("Project corrupted. Clip %1 (%2) not found in project bin.", clip->parent().get("id"), clipId);
+                    }
+                } else {
+                    binId = binIdCorresp.at(clipId);
+                }
+                Q_ASSERT(!clipId.isEmpty() && !binId.isEmpty());
+                assignId = true;
+            }
+            plan.clips.push_back({clip, position, binId, inferState(clip, audioTrack), assignId});
+            break;
+        }
+        default:
+            qDebug() << "ERROR : unexpected object found on playlist";
+            plan.valid = false;
+            return;
+        }
+    }
+}
+
+/* @brief Creates the clips of a scanned playlist and inserts them in their track.
+   This registers models in the timeline and bin, so it must run on the main thread.
+*/
+void applyPlaylistPlan(const std::shared_ptr<TimelineItemModel> &timeline, int tid, const PlaylistLoadPlan &plan, QProgressDialog *progressDialog)
+{
+    m_errorMessage << plan.errors;
+    for (const ClipLoadPlan &entry : plan.clips) {
+        if (progressDialog) {
+            progressDialog->setValue(progressDialog->value() + 1);
+        }
+        if (entry.assignId) {
+            entry.clip->parent().set("kdenlive:id", entry.binId.toUtf8().constData());
+            entry.clip->parent().set("_kdenlive_processed", 1);
+        }
+        bool ok = false;
+        int cid = -1;
+        if (pCore->bin()->getBinClip(entry.binId)) {
+            cid = ClipModel::construct(timeline, entry.binId, entry.clip, entry.state);
+            ok = timeline->insertClipOnLoad(cid, tid, entry.position);
+        } else {
+            qDebug() << "// Cannot find bin clip: " << entry.binId << " - " << entry.clip->get("id");
+        }
+        if (!ok && cid > -1) {
+            qDebug() << "ERROR : failed to insert clip in track" << tid << "position" << entry.position;
+            timeline->requestItemDeletion(cid, false);
+            m_errorMessage << i18n("Invalid clip %1 found on track %2 at %3.", entry.clip->parent().get("id"), plan.playlist->get("id"), entry.position);
+        }
+    }
+    std::shared_ptr<Mlt::Service> serv = std::make_shared<Mlt::Service>(plan.playlist->get_service());
+    timeline->importTrackEffects(tid, serv);
+}
+
+/* @brief Prepares the plan of a double track (a tractor with two playlists), and passes its properties to the timeline track */
+bool prepareTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, TrackLoadPlan &plan, Mlt::Tractor &track)
+{
+    if (track.count() != 2) {
+        // we expect a tractor with two tracks (a "fake" track)
+        qDebug() << "ERROR : wrong number of subtracks";
+        return false;
+    }
+    int tid = plan.tid;
+    for (int i = 0; i < track.count(); i++) {
+        std::unique_ptr<Mlt::Producer> sub_track(track.track(i));
+        if (sub_track->type() != playlist_type) {
+            qDebug() << "ERROR : SubTracks must be MLT::Playlist";
+            return false;
+        }
+        PlaylistLoadPlan playlistPlan;
+        playlistPlan.playlist = std::make_shared<Mlt::Playlist>(*sub_track);
+        if (i == 0) {
+            // Pass track properties
+            int height = track.get_int("kdenlive:trackheight");
+            timeline->setTrackProperty(tid, "kdenlive:trackheight", height == 0 ? "100" : QString::number(height));
+            timeline->setTrackProperty(tid, "kdenlive:collapsed", QString::number(track.get_int("kdenlive:collapsed")));
+            QString trackName = track.get("kdenlive:track_name");
+            if (!trackName.isEmpty()) {
+                timeline->setTrackProperty(tid, QStringLiteral("kdenlive:track_name"), trackName.toUtf8().constData());
+            }
+            if (plan.audioTrack) {
+                // This is an audio track
+                timeline->setTrackProperty(tid, QStringLiteral("kdenlive:audio_track"), QStringLiteral("1"));
+                timeline->setTrackProperty(tid, QStringLiteral("hide"), QStringLiteral("1"));
+            } else {
+                // video track, hide audio
+                timeline->setTrackProperty(tid, QStringLiteral("hide"), QStringLiteral("2"));
+            }
+            int muteState = playlistPlan.playlist->get_int("hide");
+            if (muteState > 0 && (!plan.audioTrack || (plan.audioTrack && muteState != 1))) {
+                timeline->setTrackProperty(tid, QStringLiteral("hide"), QString::number(muteState));
+            }
+        }
+        plan.playlists.push_back(playlistPlan);
+    }
+    plan.trackService = std::make_shared<Mlt::Service>(track.get_service());
+    return true;
+}
+} // namespace
 
 bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, Mlt::Tractor tractor, QProgressDialog *progressDialog)
 {
@@ -72,6 +273,8 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
     QList <int> lockedTracksIndexes;
     // Black track index
     videoTracksIndexes << 0;
+    // First pass: create the tracks, in timeline order
+    std::vector<TrackLoadPlan> trackPlans;
     for (int i = 0; i < tractor.count() && ok; i++) {
         std::unique_ptr<Mlt::Producer> track(tractor.track(i));
         QString playlist_name = track->get("id");
@@ -94,20 +297,24 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
             if (track->get_int("kdenlive:locked_track") > 0) {
                 lockedTracksIndexes << tid;
             }
+            TrackLoadPlan plan;
+            plan.tid = tid;
+            plan.audioTrack = audioTrack;
             Mlt::Tractor local_tractor(*track);
-            ok = ok && constructTrackFromMelt(timeline, tid, local_tractor, binIdCorresp, undo, redo, audioTrack, progressDialog);
+            ok = ok && prepareTrackFromMelt(timeline, plan, local_tractor);
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:thumbs_format"), track->get("kdenlive:thumbs_format"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:audio_rec"), track->get("kdenlive:audio_rec"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:timeline_active"), track->get("kdenlive:timeline_active"));
+            trackPlans.push_back(plan);
             break;
         }
         case playlist_type: {
             // that is a single track
             qDebug() << "Adding track: " << track->get("id");
             int tid;
-            Mlt::Playlist local_playlist(*track);
-            const QString trackName = local_playlist.get("kdenlive:track_name");
-            bool audioTrack = local_playlist.get_int("kdenlive:audio_track") == 1;
+            auto local_playlist = std::make_shared<Mlt::Playlist>(*track);
+            const QString trackName = local_playlist->get("kdenlive:track_name");
+            bool audioTrack = local_playlist->get_int("kdenlive:audio_track") == 1;
             if (!audioTrack) {
                 videoTracksIndexes << i;
             }
@@ -116,20 +323,64 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
             if (muteState > 0 && (!audioTrack || (audioTrack && muteState != 1))) {
                 timeline->setTrackProperty(tid, QStringLiteral("hide"), QString::number(muteState));
             }
-
-            ok = ok && constructTrackFromMelt(timeline, tid, local_playlist, binIdCorresp, undo, redo, audioTrack, progressDialog);
-            if (local_playlist.get_int("kdenlive:locked_track") > 0) {
+            if (local_playlist->get_int("kdenlive:locked_track") > 0) {
                 lockedTracksIndexes << tid;
             }
-            timeline->setTrackProperty(tid, QStringLiteral("kdenlive:thumbs_format"), local_playlist.get("kdenlive:thumbs_format"));
+            timeline->setTrackProperty(tid, QStringLiteral("kdenlive:thumbs_format"), local_playlist->get("kdenlive:thumbs_format"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:audio_rec"), track->get("kdenlive:audio_rec"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:timeline_active"), track->get("kdenlive:timeline_active"));
+            TrackLoadPlan plan;
+            plan.tid = tid;
+            plan.audioTrack = audioTrack;
+            PlaylistLoadPlan playlistPlan;
+            playlistPlan.playlist = local_playlist;
+            plan.playlists.push_back(playlistPlan);
+            trackPlans.push_back(plan);
             break;
         }
         default:
             qDebug() << "ERROR: Unexpected item in the timeline";
         }
     }
+
+    // Second pass: scan the playlists of all tracks in parallel, tracks are independent until compositions are planted.
+    // Only this read-only scan runs in parallel, the clip models are still built one by one in the next pass
+    if (ok) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+        QList<QFuture<void>> scans;
+        for (TrackLoadPlan &plan : trackPlans) {
+            for (PlaylistLoadPlan &playlistPlan : plan.playlists) {
+                scans << QtConcurrent::run(&pool, [&playlistPlan, &binIdCorresp, audioTrack = plan.audioTrack]() {
+                    scanPlaylist(playlistPlan, binIdCorresp, audioTrack);
+                });
+            }
+        }
+        for (QFuture<void> &scan : scans) {
+            scan.waitForFinished();
+        }
+    }
+
+    // Third pass: create the clip models and fill the tracks, in timeline order.
+    // This stays serial since clip models use the bin clips, effect stacks and the timeline snaps, which are not thread safe
+    for (const TrackLoadPlan &plan : trackPlans) {
+        if (!ok) {
+            break;
+        }
+        for (const PlaylistLoadPlan &playlistPlan : plan.playlists) {
+            applyPlaylistPlan(timeline, plan.tid, playlistPlan, progressDialog);
+            if (!playlistPlan.valid && !plan.trackService) {
+                // An unexpected object in a single track playlist is fatal
+                ok = false;
+                break;
+            }
+        }
+        if (plan.trackService) {
+            timeline->importTrackEffects(plan.tid, plan.trackService);
+        }
+    }
+    // Clips were inserted without notifying the view, update it once
+    timeline->updateDuration();
     timeline->_resetView();
 
     // Loading compositions
@@ -186,174 +437,33 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
     // build internal track compositing
     timeline->buildTrackCompositing();
 
-    // load locked state as last step
-    for (int tid : lockedTracksIndexes) {
-        timeline->setTrackLockedState(tid, true);
-    }
-
     if (!ok) {
         // TODO log error
         // Don't abort loading because of failed composition
-        undo();
-        return false;
-    }
-    if (!m_errorMessage.isEmpty()) {
-        KMessageBox::sorry(qApp->activeWindow(), m_errorMessage.join("\n"), i18n("Problems found in your project file"));
-    }
-    return true;
-}
-
-bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, Mlt::Tractor &track,
-                            const std::unordered_map<QString, QString> &binIdCorresp, Fun &undo, Fun &redo, bool audioTrack, QProgressDialog *progressDialog)
-{
-    if (track.count() != 2) {
-        // we expect a tractor with two tracks (a "fake" track)
-        qDebug() << "ERROR : wrong number of subtracks";
-        return false;
-    }
-    for (int i = 0; i < track.count(); i++) {
-        std::unique_ptr<Mlt::Producer> sub_track(track.track(i));
-        if (sub_track->type() != playlist_type) {
-            qDebug() << "ERROR : SubTracks must be MLT::Playlist";
-            return false;
-        }
-        Mlt::Playlist playlist(*sub_track);
-        constructTrackFromMelt(timeline, tid, playlist, binIdCorresp, undo, redo, audioTrack, progressDialog);
-        if (i == 0) {
-            // Pass track properties
-            int height = track.get_int("kdenlive:trackheight");
-            timeline->setTrackProperty(tid, "kdenlive:trackheight", height == 0 ? "100" : QString::number(height));
-            timeline->setTrackProperty(tid, "kdenlive:collapsed", QString::number(track.get_int("kdenlive:collapsed")));
-            QString trackName = track.get("kdenlive:track_name");
-            if (!trackName.isEmpty()) {
-                timeline->setTrackProperty(tid, QStringLiteral("kdenlive:track_name"), trackName.toUtf8().constData());
+        // Clips inserted on load are not part of the undo history, remove them before the tracks are deleted.
+        // This is done before the tracks are locked, since items of a locked track cannot be deleted
+        for (const TrackLoadPlan &plan : trackPlans) {
+            if (!timeline->isTrack(plan.tid)) {
+                continue;
             }
-            if (audioTrack) {
-                // This is an audio track
-                timeline->setTrackProperty(tid, QStringLiteral("kdenlive:audio_track"), QStringLiteral("1"));
-                timeline->setTrackProperty(tid, QStringLiteral("hide"), QStringLiteral("1"));
-            } else {
-                // video track, hide audio
-                timeline->setTrackProperty(tid, QStringLiteral("hide"), QStringLiteral("2"));
-            }
-            int muteState = playlist.get_int("hide");
-            if (muteState > 0 && (!audioTrack || (audioTrack && muteState != 1))) {
-                timeline->setTrackProperty(tid, QStringLiteral("hide"), QString::number(muteState));
+            for (int cid : timeline->getItemsInRange(plan.tid, 0, -1, false)) {
+                // A grouped clip may already have been deleted with its group
+                if (timeline->isClip(cid)) {
+                    timeline->requestItemDeletion(cid, false);
+                }
             }
         }
+        undo();
+        return false;
     }
-    std::shared_ptr<Mlt::Service> serv = std::make_shared<Mlt::Service>(track.get_service());
-    timeline->importTrackEffects(tid, serv);
-    return true;
-}
-
-namespace {
 
-// This function tries to recover the state of the producer (audio or video or both)
-PlaylistState::ClipState inferState(const std::shared_ptr<Mlt::Producer> &prod, bool audioTrack)
-{
-    auto getProperty = [prod](const QString &name) {
-        if (prod->parent().is_valid()) {
-            return QString::fromUtf8(prod->parent().get(name.toUtf8().constData()));
-        }
-        return QString::fromUtf8(prod->get(name.toUtf8().constData()));
-    };
-    auto getIntProperty = [prod](const QString &name) {
-        if (prod->parent().is_valid()) {
-            return prod->parent().get_int(name.toUtf8().constData());
-        }
-        return prod->get_int(name.toUtf8().constData());
-    };
-    QString service = getProperty("mlt_service");
-    std::pair<bool, bool> VidAud{true, true};
-    VidAud.first = getIntProperty("set.test_image") == 0;
-    VidAud.second = getIntProperty("set.test_audio") == 0;
-    if (audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("video_index")) == -1))) {
-        VidAud.first = false;
-    }
-    if (!audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("audio_index")) == -1))) {
-        VidAud.second = false;
+    // load locked state as last step
+    for (int tid : lockedTracksIndexes) {
+        timeline->setTrackLockedState(tid, true);
     }
-    return stateFromBool(VidAud);
-}
-} // namespace
 
-bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, Mlt::Playlist &track,
-                            const std::unordered_map<QString, QString> &binIdCorresp, Fun &undo, Fun &redo, bool audioTrack, QProgressDialog *progressDialog)
-{
-    for (int i = 0; i < track.count(); i++) {
-        if (track.is_blank(i)) {
-            continue;
-        }
-        if (progressDialog) {
-            progressDialog->setValue(progressDialog->value() + 1);
-        }
-        std::shared_ptr<Mlt::Producer> clip(track.get_clip(i));
-        int position = track.clip_start(i);
-        switch (clip->type()) {
-        case unknown_type:
-        case producer_type: {
-            qDebug() << "Looking for clip clip " << clip->parent().get("kdenlive:id") << " = " << clip->parent().get("kdenlive:clipname");
-            QString binId;
-            if (clip->parent().get_int("_kdenlive_processed") == 1) {
-                // This is a bin clip, already processed no need to change id
-                binId = QString(clip->parent().get("kdenlive:id"));
-            } else {
-                QString clipId = clip->parent().get("kdenlive:id");
-                if (clipId.startsWith(QStringLiteral("slowmotion"))) {
-                    clipId = clipId.section(QLatin1Char(':'), 1, 1);
-                }
-                if (clipId.isEmpty()) {
-                    clipId = clip->get("kdenlive:id");
-                }
-                if (binIdCorresp.count(clipId) == 0) {
-                    // Project was somehow corrupted
-                    qDebug()<<"=== WARNING, CANNOT FIND CLIP WITH ID: "<<clipId<<" IN BIN PLAYLIST";
-                    QStringList fixedId = pCore->projectItemModel()->getClipByUrl(QFileInfo(clip->parent().get("resource")));
-                    if (!fixedId.isEmpty()) {
-                        binId = fixedId.first();
-                        m_errorMessage << i18n("Invalid clip %1 (%2) not found in project bin, recovered.", clip->parent().get("id"), clipId);
-                    } else {
-                        qWarning()<<"Warning, clip in timeline has no parent in bin: "<<clip->parent().get("id");
-                        m_errorMessage << i18n("Project corrupted. Clip %1 (%2) not found in project bin.", clip->parent().get("id"), clipId);
-                    }
-                } else {
-                    binId = binIdCorresp.at(clipId);
-                }
-                Q_ASSERT(!clipId.isEmpty() && !binId.isEmpty());
-                clip->parent().set("kdenlive:id", binId.toUtf8().constData());
-                clip->parent().set("_kdenlive_processed", 1);
-            }
-            bool ok = false;
-            int cid = -1;
-            if (pCore->bin()->getBinClip(binId)) {
-                PlaylistState::ClipState st = inferState(clip, audioTrack);
-                cid = ClipModel::construct(timeline, binId, clip, st);
-                ok = timeline->requestClipMove(cid, tid, position, true, true, false, true, undo, redo);
-            } else {
-                qDebug() << "// Cannot find bin clip: " << binId << " - " << clip->get("id");
-            }
-            if (!ok && cid > -1) {
-                qDebug() << "ERROR : failed to insert clip in track" << tid << "position" << position;
-                timeline->requestItemDeletion(cid, false);
-                m_errorMessage << i18n("Invalid clip %1 found on track %2 at %3.", clip->parent().get("id"), track.get("id"), position);
-                break;
-            }
-            qDebug() << "Inserted clip in track" << tid << "at " << position;
-            break;
-        }
-        case tractor_type: {
-            // TODO This is a nested timeline
-            qDebug() << "NOT_IMPLEMENTED: code for parsing nested timeline is not there yet.";
-            break;
-        }
-        default:
-            qDebug() << "ERROR : unexpected object found on playlist";
-            return false;
-            break;
-        }
+    if (!m_errorMessage.isEmpty()) {
+        KMessageBox::sorry(qApp->activeWindow(), m_errorMessage.join("\n"), i18n("Problems found in your project file"));
     }
-    std::shared_ptr<Mlt::Service> serv = std::make_shared<Mlt::Service>(track.get_service());
-    timeline->importTrackEffects(tid, serv);
     return true;
 }
@@ -442,6 +442,7 @@ void TimelineItemModel::setTrackProperty(int trackId, const QString &name, const
     } else if (name == QLatin1String("hide")) {
         roles.push_back(IsDisabledRole);
         if (!track->isAudioTrack()) {
+            pCore->invalidateItem({ObjectType::TimelineTrack, trackId});
             pCore->requestMonitorRefresh();
         }
     } else if (name == QLatin1String("kdenlive:timeline_active")) {
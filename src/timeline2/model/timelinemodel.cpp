@@ -605,6 +605,26 @@ bool TimelineModel::requestClipMove(int clipId, int trackId, int position, bool
     return true;
 }
 
+bool TimelineModel::insertClipOnLoad(int clipId, int trackId, int position)
+{
+    Q_ASSERT(isClip(clipId));
+    if (!isTrack(trackId)) {
+        return false;
+    }
+    PlaylistState::ClipState state = m_allClips[clipId]->clipState();
+    if (state == PlaylistState::Disabled) {
+        if (getTrackById_const(trackId)->trackType() == PlaylistState::AudioOnly && !m_allClips[clipId]->canBeAudio()) {
+            return false;
+        }
+        if (getTrackById_const(trackId)->trackType() == PlaylistState::VideoOnly && !m_allClips[clipId]->canBeVideo()) {
+            return false;
+        }
+    } else if (getTrackById_const(trackId)->trackType() != state) {
+        return false;
+    }
+    return getTrackById(trackId)->insertClipOnLoad(clipId, position);
+}
+
 bool TimelineModel::requestFakeClipMove(int clipId, int trackId, int position, bool updateView, bool logUndo, bool invalidateTimeline)
 {
     QWriteLocker locker(&m_lock);
@@ -2583,6 +2603,90 @@ bool TimelineModel::copyClipEffect(int clipId, const QString &sourceId)
     return m_allClips.at(clipId)->copyEffect(effectStack, itemRow);
 }
 
+bool TimelineModel::requestClipsEffect(const std::unordered_set<int> &clipIds, const QString &effectId)
+{
+    QWriteLocker locker(&m_lock);
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    auto operation = [effectId](const std::shared_ptr<EffectStackModel> &stack, Fun &local_undo, Fun &local_redo) {
+        return stack->appendEffect(effectId, true, local_undo, local_redo, false);
+    };
+    int applied = applyClipsEffectOperation(clipIds, operation, undo, redo);
+    if (applied > 0) {
+        PUSH_UNDO(undo, redo, i18n("Add effect %1", EffectsRepository::get()->getName(effectId)));
+    }
+    return applied > 0;
+}
+
+bool TimelineModel::requestClipsEffectsFromXml(const std::unordered_set<int> &clipIds, const QDomElement &effects)
+{
+    QWriteLocker locker(&m_lock);
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    // Parse the stack once, the same description is then planted in every clip
+    const std::vector<EffectStackModel::XmlEffect> parsed = EffectStackModel::parseXml(effects);
+    auto operation = [&parsed](const std::shared_ptr<EffectStackModel> &stack, Fun &local_undo, Fun &local_redo) {
+        return stack->appendEffects(parsed, local_undo, local_redo, false);
+    };
+    int applied = applyClipsEffectOperation(clipIds, operation, undo, redo);
+    if (applied < int(clipIds.size())) {
+        bool undone = undo();
+        Q_ASSERT(undone);
+        return false;
+    }
+    PUSH_UNDO(undo, redo, i18n("Paste effects"));
+    return true;
+}
+
+int TimelineModel::applyClipsEffectOperation(const std::unordered_set<int> &clipIds,
+                                             const std::function<bool(const std::shared_ptr<EffectStackModel> &, Fun &, Fun &)> &operation, Fun &undo,
+                                             Fun &redo)
+{
+    // Sort clips by track and position, so that each track is processed in one go
+    std::map<int, std::map<int, int>> clipsPerTrack;
+    for (int cid : clipIds) {
+        if (!isClip(cid)) {
+            continue;
+        }
+        int tid = getClipTrackId(cid);
+        if (tid == -1) {
+            continue;
+        }
+        clipsPerTrack[tid][getClipPosition(cid)] = cid;
+    }
+    int applied = 0;
+    std::vector<int> modifiedClips;
+    Fun local_undo = []() { return true; };
+    Fun local_redo = []() { return true; };
+    for (const auto &track : clipsPerTrack) {
+        for (const auto &clip : track.second) {
+            if (operation(m_allClips.at(clip.second)->m_effectStack, local_undo, local_redo)) {
+                modifiedClips.push_back(clip.second);
+                applied++;
+            }
+        }
+    }
+    if (applied == 0) {
+        return 0;
+    }
+    // The stacks were modified without notification, send one per clip now that the whole batch is applied.
+    // The clip relays it to the timeline, and it refreshes the effect stack view and asset panel of the selected clip
+    Fun update = [this, modifiedClips]() {
+        QVector<int> roles = {EffectNamesRole, FadeInRole, FadeOutRole, KeyframesRole};
+        for (int cid : modifiedClips) {
+            if (isClip(cid)) {
+                emit m_allClips.at(cid)->m_effectStack->dataChanged(QModelIndex(), QModelIndex(), roles);
+            }
+        }
+        return true;
+    };
+    update();
+    PUSH_LAMBDA(update, local_redo);
+    PUSH_LAMBDA(update, local_undo);
+    UPDATE_UNDO_REDO(local_redo, local_undo, undo, redo);
+    return applied;
+}
+
 bool TimelineModel::adjustEffectLength(int clipId, const QString &effectId, int duration, int initialDuration)
 {
     Q_ASSERT(m_allClips.count(clipId));
@@ -2988,6 +3092,100 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int composi
 }
 
 bool TimelineModel::replantCompositions(int currentCompo, bool updateView)
+{
+    // Most of the time, only the composition that was just moved needs to be planted, so we try to insert it at its place first
+    if (!plantComposition(currentCompo)) {
+        if (!replantAllCompositions(currentCompo)) {
+            return false;
+        }
+    }
+    if (updateView) {
+        QModelIndex modelIndex = makeCompositionIndexFromID(currentCompo);
+        notifyChange(modelIndex, modelIndex, ItemATrack);
+    }
+    return true;
+}
+
+bool TimelineModel::compositionPlantedBefore(int a, int b) const
+{
+    // compositions are planted in a decreasing order of a_track, and increasing order of b_track
+    const auto &compoA = m_allCompositions.at(a);
+    const auto &compoB = m_allCompositions.at(b);
+    if (compoA->getATrack() == compoB->getATrack()) {
+        return getTrackMltIndex(compoA->getCurrentTrackId()) < getTrackMltIndex(compoB->getCurrentTrackId());
+    }
+    return compoA->getATrack() > compoB->getATrack();
+}
+
+bool TimelineModel::plantComposition(int compoId)
+{
+    if (compoId == -1 || m_plantedCompositions.empty() || !isComposition(compoId)) {
+        return false;
+    }
+    const auto &compo = m_allCompositions.at(compoId);
+    int trackId = compo->getCurrentTrackId();
+    int aTrack = compo->getATrack();
+    if (trackId == -1 || aTrack == -1 || mlt_service_consumer(compo->get_service()) != nullptr) {
+        return false;
+    }
+    // Make sure the stored order still matches the model. Track insertions or deletions can change the a_track of some compositions, in which case we have
+    // to replant everything
+    for (size_t i = 0; i < m_plantedCompositions.size(); ++i) {
+        int id = m_plantedCompositions[i];
+        if (id == compoId || !isComposition(id)) {
+            return false;
+        }
+        const auto &planted = m_allCompositions.at(id);
+        if (planted->getCurrentTrackId() == -1 || planted->getATrack() == -1 || mlt_service_consumer(planted->get_service()) == nullptr) {
+            return false;
+        }
+        if (i > 0 && compositionPlantedBefore(id, m_plantedCompositions[i - 1])) {
+            return false;
+        }
+    }
+    auto slot = std::upper_bound(m_plantedCompositions.begin(), m_plantedCompositions.end(), compoId,
+                                 [this](int a, int b) { return compositionPlantedBefore(a, b); });
+    int bTrack = getTrackMltIndex(trackId);
+    Q_ASSERT(aTrack < m_tractor->count());
+
+    QScopedPointer<Mlt::Field> field(m_tractor->field());
+    field->lock();
+    mlt_service below;
+    mlt_service above;
+    if (slot != m_plantedCompositions.end()) {
+        above = m_allCompositions.at(*slot)->get_service();
+        below = mlt_service_producer(above);
+    } else {
+        below = m_allCompositions.at(m_plantedCompositions.back())->get_service();
+        above = mlt_service_consumer(below);
+    }
+    Mlt::Transition &transition = *compo.get();
+    int ret;
+    if (above == nullptr || mlt_service_identify(above) != transition_type) {
+        // The composition goes on top of the field
+        ret = field->plant_transition(transition, aTrack, bTrack);
+    } else {
+        // Insert the composition between its neighbours
+        ret = mlt_transition_connect(transition.get_transition(), below, aTrack, bTrack);
+        if (ret == 0) {
+            auto aboveTransition = (mlt_transition)above;
+            ret = mlt_transition_connect(aboveTransition, transition.get_service(), mlt_transition_get_a_track(aboveTransition),
+                                         mlt_transition_get_b_track(aboveTransition));
+            if (ret != 0) {
+                transition.disconnect_all_producers();
+            }
+        }
+    }
+    field->unlock();
+    qDebug() << "Planting composition " << compoId << "in " << aTrack << "/" << bTrack << "ret=" << ret;
+    if (ret != 0) {
+        return false;
+    }
+    m_plantedCompositions.insert(slot, compoId);
+    return true;
+}
+
+bool TimelineModel::replantAllCompositions(int currentCompo)
 {
     // We ensure that the compositions are planted in a decreasing order of a_track, and increasing order of b_track.
     // For that, there is no better option than to disconnect every composition and then reinsert everything in the correct order.
@@ -3012,6 +3210,7 @@ bool TimelineModel::replantCompositions(int currentCompo, bool updateView)
         return m_allCompositions[a.second]->getATrack() > m_allCompositions[b.second]->getATrack();
     });
     // replant
+    m_plantedCompositions.clear();
     QScopedPointer<Mlt::Field> field(m_tractor->field());
     field->lock();
 
@@ -3058,6 +3257,7 @@ bool TimelineModel::replantCompositions(int currentCompo, bool updateView)
             field->unlock();
             return false;
         }
+        m_plantedCompositions.push_back(compo.second);
     }
     // Replant last tracks compositing
     while (!trackCompositions.isEmpty()) {
@@ -3065,10 +3265,6 @@ bool TimelineModel::replantCompositions(int currentCompo, bool updateView)
         field->plant_transition(*firstTr, firstTr->get_a_track(), firstTr->get_b_track());
     }
     field->unlock();
-    if (updateView) {
-        QModelIndex modelIndex = makeCompositionIndexFromID(currentCompo);
-        notifyChange(modelIndex, modelIndex, ItemATrack);
-    }
     return true;
 }
 
@@ -3088,6 +3284,7 @@ bool TimelineModel::unplantComposition(int compoId)
     Q_ASSERT(nextservice == nullptr);
     // Q_ASSERT(consumer == nullptr);
     field->unlock();
+    m_plantedCompositions.erase(std::remove(m_plantedCompositions.begin(), m_plantedCompositions.end(), compoId), m_plantedCompositions.end());
     return ret != 0;
 }
 
@@ -35,6 +35,7 @@
 
 class AssetParameterModel;
 class EffectStackModel;
+class QDomElement;
 class ClipModel;
 class CompositionModel;
 class DocUndoStack;
@@ -248,6 +249,15 @@ public:
     Q_INVOKABLE bool addTrackEffect(int trackId, const QString &effectId);
     bool removeFade(int clipId, bool fromStart);
     Q_INVOKABLE bool copyClipEffect(int clipId, const QString &sourceId);
+    /* @brief Add an effect to several clips at once, as a single undo operation.
+       Clips are processed track by track and one data change is emitted per track instead of one per clip.
+       Returns true if the effect could be added to at least one clip
+    */
+    bool requestClipsEffect(const std::unordered_set<int> &clipIds, const QString &effectId);
+    /* @brief Append an effect stack (as produced by EffectStackModel::toXml) to several clips at once, as a single undo operation.
+       The xml is only parsed once for all clips.
+    */
+    bool requestClipsEffectsFromXml(const std::unordered_set<int> &clipIds, const QDomElement &effects);
     Q_INVOKABLE bool copyTrackEffect(int trackId, const QString &sourceId);
     bool adjustEffectLength(int clipId, const QString &effectId, int duration, int initialDuration);
 
@@ -358,6 +368,12 @@ public:
     /* Same function, but accumulates undo and redo, and doesn't check
        for group*/
     bool requestClipMove(int clipId, int trackId, int position, bool moveMirrorTracks, bool updateView, bool invalidateTimeline, bool finalMove, Fun &undo, Fun &redo, bool groupMove = false);
+
+    /* @brief Places a newly constructed clip on a track while a project is loaded.
+       Nothing is stored in the undo history and the view is not notified: call _resetView and updateDuration once the tracks are built.
+       Returns false if the clip doesn't match the track type or the position is not free.
+    */
+    bool insertClipOnLoad(int clipId, int trackId, int position);
     bool requestCompositionMove(int transid, int trackId, int compositionTrack, int position, bool updateView, bool finalMove, Fun &undo, Fun &redo);
 
     /* When timeline edit mode is insert or overwrite, we fake the move (as it will overlap existing clips, and only process the real move on drop */
@@ -726,11 +742,25 @@ protected:
      */
     static int getNextId();
 
-    /* @brief unplant and the replant all the compositions in the correct order
+    /* @brief Plant a composition at its correct place among the other compositions
+       When the stored planting order is not usable anymore, all the compositions are unplanted and replanted in the correct order
        @param currentCompo is the id of a compo that have not yet been planted, if any. Otherwise send -1
      */
     bool replantCompositions(int currentCompo, bool updateView);
 
+    /* @brief unplant and the replant all the compositions in the correct order
+       @param currentCompo is the id of a compo that have not yet been planted, if any. Otherwise send -1
+     */
+    bool replantAllCompositions(int currentCompo);
+
+    /* @brief Plant the given composition between its neighbours in the planting order, without touching the other compositions
+       Returns false if the stored planting order doesn't match the model anymore, in which case nothing was planted
+     */
+    bool plantComposition(int compoId);
+
+    /* @brief Returns true if composition @param a must be planted below composition @param b */
+    bool compositionPlantedBefore(int a, int b) const;
+
     /* @brief Unplant the composition with given Id */
     bool unplantComposition(int compoId);
 
@@ -746,6 +776,12 @@ protected:
     /** @brief Attempt to make a clip move without ever updating the view */
     bool requestClipMoveAttempt(int clipId, int trackId, int position);
 
+    /** @brief Apply an effect operation to each clip of the list, track by track, storing the result in the undo/redo lambdas.
+        The operation must not notify the views: a single data change covering the modified clips of each track is emitted instead.
+        Returns the number of clips on which the operation succeeded */
+    int applyClipsEffectOperation(const std::unordered_set<int> &clipIds, const std::function<bool(const std::shared_ptr<EffectStackModel> &, Fun &, Fun &)> &operation,
+                                  Fun &undo, Fun &redo);
+
 public:
     /* @brief Debugging function that checks consistency with Mlt objects */
     bool checkConsistency();
@@ -789,6 +825,8 @@ protected:
     std::unordered_map<int, std::shared_ptr<CompositionModel>>
         m_allCompositions; // the keys are the composition id, and the values are the corresponding pointers
 
+    std::vector<int> m_plantedCompositions; // ids of the planted compositions, in the order they are connected in the tractor's field (bottom first)
+
     static int next_id; // next valid id to assign
 
     std::unique_ptr<GroupsModel> m_groups;
@@ -261,6 +261,50 @@ bool TrackModel::requestClipInsertion(int clipId, int position, bool updateView,
     return false;
 }
 
+bool TrackModel::insertClipOnLoad(int clipId, int position)
+{
+    QWriteLocker locker(&m_lock);
+    auto ptr = m_parent.lock();
+    if (!ptr) {
+        qDebug() << "Error : Clip Insertion failed because timeline is not available anymore";
+        return false;
+    }
+    std::shared_ptr<ClipModel> clip = ptr->getClipPtr(clipId);
+    Q_ASSERT(clip->getCurrentTrackId() == -1);
+    const int playtime = m_playlists[0].get_playtime();
+    const bool append = position >= playtime && m_playlists[1].is_blank_at(position);
+    if (!append && (!isBlankAt(position) || getBlankEnd(position) < position + clip->getPlaytime())) {
+        return false;
+    }
+    // Set the position first so that the clip snaps are registered at their final place
+    clip->setPosition(position);
+    clip->setSubPlaylistIndex(0);
+    clip->setCurrentTrackId(m_id, true);
+    m_playlists[0].lock();
+    bool ok;
+    if (append) {
+        if (position > playtime) {
+            m_playlists[0].blank(position - playtime - 1);
+        }
+        ok = m_playlists[0].append(*clip) == 0;
+        if (!ok && position > playtime) {
+            m_playlists[0].remove(m_playlists[0].count() - 1);
+        }
+    } else {
+        ok = m_playlists[0].insert_at(position, *clip, 1) != -1;
+        m_playlists[0].consolidate_blanks();
+    }
+    m_playlists[0].unlock();
+    if (!ok) {
+        clip->setCurrentTrackId(-1, false);
+        return false;
+    }
+    m_allClips[clipId] = clip;
+    ptr->m_snaps->addPoint(position);
+    ptr->m_snaps->addPoint(position + clip->getPlaytime());
+    return true;
+}
+
 void TrackModel::replugClip(int clipId)
 {
     QWriteLocker locker(&m_lock);
@@ -142,6 +142,15 @@ protected:
     /* @brief This function returns a lambda that performs the requested operation */
     Fun requestClipInsertion_lambda(int clipId, int position, bool updateView, bool finalMove, bool groupMove = false);
 
+    /* @brief Inserts a clip while a project is being loaded.
+       No undo history is recorded and the view is not notified, the caller is expected to reset the view once all clips are in place.
+       Clips loaded in increasing position order are appended to the playlist, which avoids a search in the existing layout.
+       Returns true if the operation succeeded, and otherwise, the track is not modified.
+       @param clipId is the id of the clip
+       @param position is the position where to insert the clip
+    */
+    bool insertClipOnLoad(int clipId, int position);
+
     /* @brief Performs an deletion of the given clip.
        Returns true if the operation succeeded, and otherwise, the track is not modified.
        This method is protected because it shouldn't be called directly. Call the function in the timeline instead.
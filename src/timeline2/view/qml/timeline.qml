@@ -271,6 +271,10 @@ Rectangle {
         playhead.opacity = seekingFinished ? 1 : 0.5
     }
 
+    // Keep the thumbnail prefetcher informed of the visible area
+    onScrollMinChanged: timeline.updateVisibleRange(scrollMin, scrollMax, root.dar)
+    onScrollMaxChanged: timeline.updateVisibleRange(scrollMin, scrollMax, root.dar)
+
     //onCurrentTrackChanged: timeline.selection = []
     onTimeScaleChanged: {
         if (root.zoomOnMouse >= 0) {
@@ -290,6 +294,7 @@ Rectangle {
 
     onConsumerPositionChanged: {
         if (autoScrolling) Logic.scrollIfNeeded()
+        timeline.updatePlayheadPosition(consumerPosition)
     }
 
     onViewActiveTrackChanged: {
@@ -0,0 +1,304 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#include "thumbnailprefetcher.h"
+#include "bin/projectclip.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "doc/kthumb.h"
+#include "kdenlivesettings.h"
+#include "timeline2/model/timelineitemmodel.hpp"
+#include "utils/thumbnailcache.hpp"
+
+#include <QHash>
+#include <QScopedPointer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+
+// Minimum delay between two rebuilds of the request queue, in milliseconds
+static const int PREFETCH_UPDATE_DELAY = 40;
+// How far ahead of the view we prefetch, in seconds of the current scroll / playback velocity
+static const double PREFETCH_LOOKAHEAD = 1.5;
+// Frames behind the direction of motion are this much less urgent than frames ahead of it
+static const int PREFETCH_BEHIND_PENALTY = 4;
+
+ThumbnailPrefetcher::ThumbnailPrefetcher(QObject *parent)
+    : QObject(parent)
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(PREFETCH_UPDATE_DELAY);
+    connect(&m_updateTimer, &QTimer::timeout, this, &ThumbnailPrefetcher::rebuildQueue);
+}
+
+ThumbnailPrefetcher::~ThumbnailPrefetcher()
+{
+    abort();
+}
+
+void ThumbnailPrefetcher::setModel(std::shared_ptr<TimelineItemModel> model)
+{
+    abort();
+    m_model = std::move(model);
+    m_scrollVelocity = 0.;
+    m_playheadVelocity = 0.;
+    m_scrollTimer.invalidate();
+    m_playheadTimer.invalidate();
+}
+
+void ThumbnailPrefetcher::abort()
+{
+    m_updateTimer.stop();
+    m_abort = true;
+    {
+        QMutexLocker lk(&m_queueMutex);
+        m_queue.clear();
+    }
+    m_worker.waitForFinished();
+    m_abort = false;
+}
+
+double ThumbnailPrefetcher::updateVelocity(double previous, int delta, qint64 elapsedMs)
+{
+    if (elapsedMs <= 0) {
+        return previous;
+    }
+    if (elapsedMs > 500) {
+        // The view was idle, restart the estimation
+        return 0.;
+    }
+    double measure = delta * 1000. / elapsedMs;
+    return 0.7 * measure + 0.3 * previous;
+}
+
+void ThumbnailPrefetcher::setVisibleRange(int startFrame, int endFrame, double scale, double dar)
+{
+    if (m_scrollTimer.isValid()) {
+        m_scrollVelocity = updateVelocity(m_scrollVelocity, startFrame - m_startFrame, m_scrollTimer.restart());
+    } else {
+        m_scrollTimer.start();
+    }
+    if (!qFuzzyCompare(scale, m_scale)) {
+        // A zoom change invalidates the whole thumbnail grid, don't extrapolate from the previous range
+        m_scrollVelocity = 0.;
+    }
+    m_startFrame = startFrame;
+    m_endFrame = qMax(startFrame, endFrame);
+    m_scale = scale;
+    m_dar = dar;
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void ThumbnailPrefetcher::setPlayheadPosition(int position)
+{
+    if (m_playheadTimer.isValid()) {
+        m_playheadVelocity = updateVelocity(m_playheadVelocity, position - m_playhead, m_playheadTimer.restart());
+    } else {
+        m_playheadTimer.start();
+    }
+    m_playhead = position;
+    // Only playback moving the playhead towards the edge of the view requires anticipation
+    if (qAbs(m_playheadVelocity) > 1. && !m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+std::vector<int> ThumbnailPrefetcher::clipThumbFrames(int clipId, int thumbsFormat, int thumbWidth) const
+{
+    std::vector<int> frames;
+    int in = m_model->getClipIn(clipId);
+    int playtime = m_model->getClipPlaytime(clipId);
+    double speed = m_model->getClipSpeed(clipId);
+    switch (thumbsFormat) {
+    case 1: {
+        // All frames: one thumbnail every thumbWidth pixels
+        int containerWidth = int(playtime * m_scale) - 4;
+        int count = int(std::ceil(double(containerWidth) / thumbWidth));
+        frames.reserve(size_t(qMax(0, count)));
+        for (int i = 0; i < count; ++i) {
+            frames.push_back(int(std::floor(in + std::round(i * thumbWidth / m_scale) * speed)));
+        }
+        break;
+    }
+    case 0:
+    case 2: {
+        // In / out thumbnails, or in only
+        int out = in + playtime - 1;
+        if (speed >= 0) {
+            frames.push_back(int(std::round(in * speed)));
+            if (thumbsFormat == 0) {
+                frames.push_back(int(std::round(out * speed)));
+            }
+        } else {
+            int maxDuration = m_model->data(m_model->makeClipIndexFromID(clipId), TimelineModel::MaxDurationRole).toInt();
+            frames.push_back(int(std::round((maxDuration - in) * -speed - 1)));
+            if (thumbsFormat == 0) {
+                frames.push_back(int(std::round((maxDuration - out) * -speed - 1)));
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return frames;
+}
+
+void ThumbnailPrefetcher::rebuildQueue()
+{
+    if (!m_model || !KdenliveSettings::videothumbnails()) {
+        return;
+    }
+    int visibleLength = m_endFrame - m_startFrame;
+    // During playback, the view follows the playhead
+    double velocity = qAbs(m_playheadVelocity) > qAbs(m_scrollVelocity) ? m_playheadVelocity : m_scrollVelocity;
+    int lookAhead = int(qAbs(velocity) * PREFETCH_LOOKAHEAD);
+    int windowStart = m_startFrame - visibleLength / 4;
+    int windowEnd = m_endFrame + visibleLength / 4;
+    if (velocity > 0) {
+        windowEnd += lookAhead;
+    } else {
+        windowStart -= lookAhead;
+    }
+    windowStart = qMax(0, windowStart);
+
+    std::vector<Request> requests;
+    QHash<QString, bool> thumbnailClips;
+    for (int i = 0; i < m_model->getTracksCount(); ++i) {
+        int tid = m_model->getTrackIndexFromPosition(i);
+        if (m_model->isAudioTrack(tid)) {
+            continue;
+        }
+        QModelIndex trackIndex = m_model->makeTrackIndexFromID(tid);
+        if (m_model->data(trackIndex, TimelineModel::IsDisabledRole).toBool()) {
+            continue;
+        }
+        int thumbsFormat = m_model->data(trackIndex, TimelineModel::ThumbsFormatRole).toInt();
+        // Same as ClipThumbs.qml: thumbnail width is the clip height (track height minus borders) times the display ratio
+        int thumbWidth = int((m_model->data(trackIndex, TimelineModel::HeightRole).toInt() - 4) * m_dar);
+        if (thumbWidth <= 0) {
+            continue;
+        }
+        const std::unordered_set<int> clips = m_model->getItemsInRange(tid, windowStart, windowEnd, false);
+        for (int cid : clips) {
+            const QString binId = m_model->getClipBinId(cid);
+            if (!thumbnailClips.contains(binId)) {
+                std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
+                ClipType::ProducerType type = binClip ? binClip->clipType() : ClipType::Unknown;
+                thumbnailClips.insert(binId, type == ClipType::Video || type == ClipType::AV || type == ClipType::Playlist);
+            }
+            if (!thumbnailClips.value(binId)) {
+                continue;
+            }
+            int position = m_model->getClipPosition(cid);
+            int in = m_model->getClipIn(cid);
+            int index = 0;
+            const std::vector<int> frames = clipThumbFrames(cid, thumbsFormat, thumbWidth);
+            for (int frame : frames) {
+                // Timeline position of the thumbnail, used for the priority
+                int timelinePos = thumbsFormat == 1 ? position + int(index * thumbWidth / m_scale) : position + frame - in;
+                index++;
+                if (timelinePos < windowStart || timelinePos > windowEnd) {
+                    continue;
+                }
+                if (ThumbnailCache::get()->hasThumbnail(binId, frame, true)) {
+                    continue;
+                }
+                int priority = 0;
+                if (timelinePos < m_startFrame) {
+                    priority = m_startFrame - timelinePos;
+                    if (velocity >= 0) {
+                        priority *= PREFETCH_BEHIND_PENALTY;
+                    }
+                } else if (timelinePos > m_endFrame) {
+                    priority = timelinePos - m_endFrame;
+                    if (velocity <= 0) {
+                        priority *= PREFETCH_BEHIND_PENALTY;
+                    }
+                }
+                requests.push_back({binId, frame, priority});
+            }
+        }
+    }
+    // Most urgent requests last, so that the worker pops them from the back.
+    // Requests of equal urgency are grouped by clip in ascending frame order,
+    // so that the decoder can continue from its previous position instead of seeking back.
+    std::sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        if (a.binId != b.binId) {
+            return a.binId > b.binId;
+        }
+        return a.frame > b.frame;
+    });
+    QMutexLocker lk(&m_queueMutex);
+    // Replacing the queue cancels the requests that are not needed anymore
+    m_queue = std::move(requests);
+    if (!m_queue.empty() && !m_worker.isRunning()) {
+        m_worker = QtConcurrent::run(this, &ThumbnailPrefetcher::processQueue);
+    }
+}
+
+void ThumbnailPrefetcher::processQueue()
+{
+    int imageHeight = pCore->thumbProfile()->height();
+    int imageWidth = pCore->thumbProfile()->width();
+    int fullWidth = int(imageHeight * pCore->getCurrentDar() + 0.5);
+    while (!m_abort) {
+        Request request;
+        {
+            QMutexLocker lk(&m_queueMutex);
+            if (m_queue.empty()) {
+                return;
+            }
+            request = m_queue.back();
+            m_queue.pop_back();
+        }
+        if (ThumbnailCache::get()->hasThumbnail(request.binId, request.frame, true)) {
+            continue;
+        }
+        std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(request.binId);
+        if (!binClip) {
+            continue;
+        }
+        std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
+        if (!prod || !prod->is_valid()) {
+            continue;
+        }
+        prod->seek(request.frame);
+        QScopedPointer<Mlt::Frame> frame(prod->get_frame());
+        if (frame == nullptr || !frame->is_valid()) {
+            continue;
+        }
+        frame->set("deinterlace_method", "onefield");
+        frame->set("top_field_first", -1);
+        frame->set("rescale.interp", "nearest");
+        QImage result = KThumb::getFrame(frame.data(), imageWidth, imageHeight, fullWidth);
+        if (!result.isNull()) {
+            ThumbnailCache::get()->storeThumbnail(request.binId, request.frame, result, false);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#ifndef THUMBNAILPREFETCHER_H
+#define THUMBNAILPREFETCHER_H
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class TimelineItemModel;
+
+/** @brief This class decodes timeline clip thumbnails ahead of the QML view.
+    It receives the visible timeline range, the zoom level and the playhead position,
+    estimates the scroll / playback velocity and queues the thumbnail frames of the clips
+    that are visible or about to become visible, the most urgent ones first.
+    Decoded thumbnails are stored in the volatile ThumbnailCache, where the ThumbnailProvider finds them.
+    Requests that leave the prefetch window are dropped before being decoded.
+ */
+class ThumbnailPrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailPrefetcher(QObject *parent = nullptr);
+    ~ThumbnailPrefetcher() override;
+
+    void setModel(std::shared_ptr<TimelineItemModel> model);
+    /** @brief Update the visible timeline range (in frames), zoom level (pixels per frame) and display aspect ratio of the thumbnails */
+    void setVisibleRange(int startFrame, int endFrame, double scale, double dar);
+    /** @brief Update the playhead position, used to anticipate where the view will scroll during playback */
+    void setPlayheadPosition(int position);
+    /** @brief Drop all pending requests and wait until the frame currently being decoded is done */
+    void abort();
+
+private:
+    struct Request
+    {
+        QString binId;
+        int frame;
+        // Lower values are more urgent
+        int priority;
+    };
+    /** @brief Compute the list of needed thumbnails and replace the pending queue with it */
+    void rebuildQueue();
+    /** @brief Worker thread loop, decoding the queued requests until the queue is empty */
+    void processQueue();
+    /** @brief Return the thumbnail frames displayed by the timeline for a clip, mirroring ClipThumbs.qml */
+    std::vector<int> clipThumbFrames(int clipId, int thumbsFormat, int thumbWidth) const;
+    /** @brief Smooth a velocity (frames per second) estimate with a new measure */
+    static double updateVelocity(double previous, int delta, qint64 elapsedMs);
+
+    std::shared_ptr<TimelineItemModel> m_model;
+    QTimer m_updateTimer;
+    int m_startFrame{0};
+    int m_endFrame{0};
+    double m_scale{1.};
+    double m_dar{16. / 9.};
+    int m_playhead{0};
+    double m_scrollVelocity{0.};
+    double m_playheadVelocity{0.};
+    QElapsedTimer m_scrollTimer;
+    QElapsedTimer m_playheadTimer;
+
+    QMutex m_queueMutex;
+    // Pending requests, sorted so that the most urgent request is at the back
+    std::vector<Request> m_queue;
+    QFuture<void> m_worker;
+    std::atomic_bool m_abort{false};
+};
+
+#endif
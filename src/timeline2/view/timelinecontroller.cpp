@@ -37,8 +37,10 @@
 #include "kdenlivesettings.h"
 #include "lib/audio/audioEnvelope.h"
 #include "mainwindow.h"
+#include "monitor/monitor.h"
 #include "monitor/monitormanager.h"
 #include "previewmanager.h"
+#include "thumbnailprefetcher.h"
 #include "project/projectmanager.h"
 #include "timeline2/model/clipmodel.hpp"
 #include "timeline2/model/compositionmodel.hpp"
@@ -68,6 +70,7 @@ TimelineController::TimelineController(QObject *parent)
     , m_zone(-1, -1)
     , m_scale(QFontMetrics(QApplication::font()).maxWidth() / 250)
     , m_timelinePreview(nullptr)
+    , m_thumbPrefetcher(new ThumbnailPrefetcher(this))
 {
     m_disablePreview = pCore->currentDoc()->getAction(QStringLiteral("disable_preview"));
     connect(m_disablePreview, &QAction::triggered, this, &TimelineController::disablePreview);
@@ -90,6 +93,7 @@ void TimelineController::prepareClose()
     // Delete timeline preview before resetting model so that removing clips from timeline doesn't invalidate
     delete m_timelinePreview;
     m_timelinePreview = nullptr;
+    m_thumbPrefetcher->abort();
     // Clear roor so we don't call its methods anymore
     m_root = nullptr;
 }
@@ -100,6 +104,7 @@ void TimelineController::setModel(std::shared_ptr<TimelineItemModel> model)
     m_zone = QPoint(-1, -1);
     m_timelinePreview = nullptr;
     m_model = std::move(model);
+    m_thumbPrefetcher->setModel(m_model);
     connect(m_model.get(), &TimelineItemModel::requestClearAssetView, pCore.get(), &Core::clearAssetPanel);
     connect(m_model.get(), &TimelineItemModel::checkItemDeletion, [this] (int id) {
         if (m_root) {
@@ -934,19 +939,13 @@ void TimelineController::addAsset(const QVariantMap &data)
     QString effect = data.value(QStringLiteral("kdenlive/effect")).toString();
     const auto selection = m_model->getCurrentSelection();
     if (!selection.empty()) {
-        QList<int> effectSelection;
+        std::unordered_set<int> effectSelection;
         for (int id : selection) {
             if (m_model->isClip(id)) {
-                effectSelection << id;
+                effectSelection.insert(id);
             }
         }
-        bool foundMatch = false;
-        for (int id : effectSelection) {
-            if (m_model->addClipEffect(id, effect, false)) {
-                foundMatch = true;
-            }
-        }
-        if (!foundMatch) {
+        if (!m_model->requestClipsEffect(effectSelection, effect)) {
             QString effectName = EffectsRepository::get()->getName(effect);
             pCore->displayMessage(i18n("Cannot add effect %1 to selected clip", effectName), InformationMessage, 500);
         }
@@ -1001,6 +1000,16 @@ void TimelineController::setPosition(int position)
     emit seeked(position);
 }
 
+void TimelineController::updateVisibleRange(int startFrame, int endFrame, double dar)
+{
+    m_thumbPrefetcher->setVisibleRange(startFrame, endFrame, m_scale, dar);
+}
+
+void TimelineController::updatePlayheadPosition(int position)
+{
+    m_thumbPrefetcher->setPlayheadPosition(position);
+}
+
 void TimelineController::setAudioTarget(int track)
 {
     if ((track > -1 && !m_model->isTrack(track)) || !m_hasAudioTarget) {
@@ -1348,6 +1357,7 @@ bool TimelineController::createSplitOverlay(int clipId, std::shared_ptr<Mlt::Fil
     }
     m_timelinePreview->setOverlayTrack(overlay);
     m_model->m_overlayTrackCount = m_timelinePreview->addedTracks();
+    invalidateProjectMonitor(0, -1);
     return true;
 }
 
@@ -1359,6 +1369,7 @@ void TimelineController::removeSplitOverlay()
     // disconnect
     m_timelinePreview->removeOverlayTrack();
     m_model->m_overlayTrackCount = m_timelinePreview->addedTracks();
+    invalidateProjectMonitor(0, -1);
 }
 
 void TimelineController::addPreviewRange(bool add)
@@ -1607,7 +1618,7 @@ void TimelineController::removeSpace(int trackId, int frame, bool affectAllTrack
 
 void TimelineController::invalidateItem(int cid)
 {
-    if (!m_timelinePreview || !m_model->isItem(cid)) {
+    if (!m_model->isItem(cid)) {
         return;
     }
     const int tid = m_model->getItemTrackId(cid);
@@ -1616,12 +1627,15 @@ void TimelineController::invalidateItem(int cid)
     }
     int start = m_model->getItemPosition(cid);
     int end = start + m_model->getItemPlaytime(cid);
-    m_timelinePreview->invalidatePreview(start, end);
+    invalidateProjectMonitor(start, end);
+    if (m_timelinePreview) {
+        m_timelinePreview->invalidatePreview(start, end);
+    }
 }
 
 void TimelineController::invalidateTrack(int tid)
 {
-    if (!m_timelinePreview || !m_model->isTrack(tid) || m_model->getTrackById_const(tid)->isAudioTrack()) {
+    if (!m_model->isTrack(tid) || m_model->getTrackById_const(tid)->isAudioTrack()) {
         return;
     }
     for (auto clp : m_model->getTrackById_const(tid)->m_allClips) {
@@ -1631,12 +1645,20 @@ void TimelineController::invalidateTrack(int tid)
 
 void TimelineController::invalidateZone(int in, int out)
 {
+    invalidateProjectMonitor(in, out);
     if (!m_timelinePreview) {
         return;
     }
     m_timelinePreview->invalidatePreview(in, out == -1 ? m_duration : out);
 }
 
+void TimelineController::invalidateProjectMonitor(int in, int out)
+{
+    if (pCore->monitorManager() && pCore->monitorManager()->projectMonitor()) {
+        pCore->monitorManager()->projectMonitor()->invalidateFrameCache(in, out);
+    }
+}
+
 void TimelineController::changeItemSpeed(int clipId, double speed)
 {
     /*if (clipId == -1) {
@@ -2169,6 +2191,7 @@ void TimelineController::pasteEffects(int targetId)
     }
     if (targetIds.empty()) {
         pCore->displayMessage(i18n("No clip selected"), InformationMessage, 500);
+        return;
     }
 
     QClipboard *clipboard = QApplication::clipboard();
@@ -2188,8 +2211,6 @@ void TimelineController::pasteEffects(int targetId)
         pCore->displayMessage(i18n("No information in clipboard"), InformationMessage, 500);
         return;
     }
-    std::function<bool(void)> undo = []() { return true; };
-    std::function<bool(void)> redo = []() { return true; };
     QDomElement effects = clips.at(0).firstChildElement(QStringLiteral("effects"));
     effects.setAttribute(QStringLiteral("parentIn"), clips.at(0).toElement().attribute(QStringLiteral("in")));
     for (int i = 1; i < clips.size(); i++) {
@@ -2200,19 +2221,8 @@ void TimelineController::pasteEffects(int targetId)
             effects.appendChild(subs.at(0));
         }
     }
-    bool result = true;
-    for (int target : targetIds) {
-        std::shared_ptr<EffectStackModel> destStack = m_model->getClipEffectStackModel(target);
-        result = result && destStack->fromXml(effects, undo, redo);
-        if (!result) {
-            break;
-        }
-    }
-    if (result) {
-        pCore->pushUndo(undo, redo, i18n("Paste effects"));
-    } else {
+    if (!m_model->requestClipsEffectsFromXml(targetIds, effects)) {
         pCore->displayMessage(i18n("Cannot paste effect on selected clip"), InformationMessage, 500);
-        undo();
     }
 }
 
@@ -2627,6 +2637,8 @@ bool TimelineController::exists(int itemId)
 void TimelineController::slotMultitrackView(bool enable, bool refresh)
 {
     TimelineFunctions::enableMultitrackView(m_model, enable, refresh);
+    // The tractor was rewired, cached monitor frames don't match it anymore
+    invalidateProjectMonitor(0, -1);
 }
 
 void TimelineController::saveTimelineSelection(const QDir &targetDir)
@@ -30,6 +30,7 @@
 #include <QDir>
 
 class PreviewManager;
+class ThumbnailPrefetcher;
 class QAction;
 class QQuickItem;
 
@@ -178,6 +179,13 @@ public:
        @param position is the desired new timeline position
      */
     Q_INVOKABLE void setPosition(int position);
+    /* @brief Inform the thumbnail prefetcher of the visible timeline area
+       @param startFrame / endFrame is the visible range
+       @param dar is the display aspect ratio of the thumbnails
+     */
+    Q_INVOKABLE void updateVisibleRange(int startFrame, int endFrame, double dar);
+    /* @brief Inform the thumbnail prefetcher of the playhead position, so that it can anticipate playback scrolling */
+    Q_INVOKABLE void updatePlayheadPosition(int position);
     Q_INVOKABLE bool snap();
     Q_INVOKABLE bool ripple();
     Q_INVOKABLE bool scrub();
@@ -552,6 +560,7 @@ private:
     double m_scale;
     static int m_duration;
     PreviewManager *m_timelinePreview;
+    ThumbnailPrefetcher *m_thumbPrefetcher;
     QAction *m_disablePreview;
     std::shared_ptr<AudioCorrelation> m_audioCorrelator;
     QMutex m_metaMutex;
@@ -559,6 +568,8 @@ private:
     void initializePreview();
     bool darkBackground() const;
     int getMenuOrTimelinePos() const;
+    /** @brief Drop the frames cached by the project monitor between in and out */
+    void invalidateProjectMonitor(int in, int out);
 
 signals:
     void selected(Mlt::Producer *producer);
@@ -0,0 +1,178 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "memorybudget.hpp"
+#include "kdenlivesettings.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QTimer>
+#include <algorithm>
+
+std::unique_ptr<MemoryBudget> MemoryBudget::instance;
+std::once_flag MemoryBudget::m_onceFlag;
+
+namespace {
+// Minimum delay between two budget checks, in ms
+const int checkInterval = 200;
+// Part of the budget the releasable consumers can always keep, even if the other consumers use more than the budget
+const int releasableFloorDivisor = 4;
+} // namespace
+
+MemoryBudget::MemoryBudget() = default;
+
+std::unique_ptr<MemoryBudget> &MemoryBudget::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new MemoryBudget()); });
+    return instance;
+}
+
+int MemoryBudget::registerConsumer(const QString &name, UsageFunction usage, ReleaseFunction release)
+{
+    QMutexLocker locker(&m_mutex);
+    int id = m_nextId++;
+    m_consumers[id] = {name, std::move(usage), std::move(release)};
+    return id;
+}
+
+void MemoryBudget::unregisterConsumer(int id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_consumers.erase(id);
+}
+
+std::map<int, MemoryBudget::Consumer> MemoryBudget::consumers() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_consumers;
+}
+
+std::vector<MemoryBudget::Usage> MemoryBudget::usage() const
+{
+    std::vector<Usage> result;
+    for (const auto &consumer : consumers()) {
+        const Consumer &c = consumer.second;
+        auto it = std::find_if(result.begin(), result.end(), [&c](const Usage &u) { return u.name == c.name; });
+        if (it == result.end()) {
+            result.push_back({c.name, c.usage(), bool(c.release)});
+        } else {
+            it->bytes += c.usage();
+            it->releasable = it->releasable || bool(c.release);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Usage &a, const Usage &b) { return a.bytes > b.bytes; });
+    return result;
+}
+
+qint64 MemoryBudget::totalUsage() const
+{
+    qint64 total = 0;
+    for (const auto &consumer : consumers()) {
+        total += consumer.second.usage();
+    }
+    return total;
+}
+
+qint64 MemoryBudget::budget()
+{
+    return qMax(0, KdenliveSettings::memorybudget()) * qint64(1024 * 1024);
+}
+
+QString MemoryBudget::report() const
+{
+    QJsonArray list;
+    qint64 total = 0;
+    for (const Usage &u : usage()) {
+        QJsonObject item;
+        item.insert(QStringLiteral("name"), u.name);
+        item.insert(QStringLiteral("bytes"), u.bytes);
+        item.insert(QStringLiteral("releasable"), u.releasable);
+        list.append(item);
+        total += u.bytes;
+    }
+    QJsonObject result;
+    result.insert(QStringLiteral("budget"), budget());
+    result.insert(QStringLiteral("total"), total);
+    result.insert(QStringLiteral("consumers"), list);
+    return QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+}
+
+qint64 MemoryBudget::release(qint64 maxBytes)
+{
+    std::vector<std::pair<qint64, ReleaseFunction>> releasable;
+    qint64 fixedTotal = 0;
+    qint64 releasableTotal = 0;
+    for (const auto &consumer : consumers()) {
+        qint64 bytes = consumer.second.usage();
+        if (!consumer.second.release) {
+            fixedTotal += bytes;
+        } else if (bytes > 0) {
+            releasable.emplace_back(bytes, consumer.second.release);
+            releasableTotal += bytes;
+        }
+    }
+    // Only the releasable consumers can free memory, they are not emptied because the others are over budget
+    maxBytes = qMax(qint64(0), maxBytes);
+    const qint64 target = qMax(maxBytes - fixedTotal, maxBytes / releasableFloorDivisor);
+    qint64 excess = releasableTotal - target;
+    if (excess <= 0 || releasableTotal == 0) {
+        return 0;
+    }
+    // Each consumer frees its share of the excess, so that recently used data is kept in all caches
+    qint64 freed = 0;
+    for (const auto &consumer : releasable) {
+        qint64 share = qMin(consumer.first, (qint64)((double)excess * consumer.first / releasableTotal) + 1);
+        freed += consumer.second(share);
+    }
+    // Some consumers may free less than asked (data in use), ask the largest ones for the remainder
+    std::sort(releasable.begin(), releasable.end(), [](const std::pair<qint64, ReleaseFunction> &a, const std::pair<qint64, ReleaseFunction> &b) {
+        return a.first > b.first;
+    });
+    for (const auto &consumer : releasable) {
+        if (freed >= excess) {
+            break;
+        }
+        freed += consumer.second(excess - freed);
+    }
+    return freed;
+}
+
+void MemoryBudget::requestCheck()
+{
+    if (budget() <= 0 || QCoreApplication::instance() == nullptr || m_checkPending.exchange(true)) {
+        return;
+    }
+    // Consumers request a check each time they store data, so checks are delayed to run at most once per checkInterval
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [this]() { QTimer::singleShot(checkInterval, QCoreApplication::instance(), [this]() { check(); }); },
+                              Qt::QueuedConnection);
+}
+
+void MemoryBudget::check()
+{
+    m_checkPending = false;
+    qint64 maxBytes = budget();
+    if (maxBytes > 0) {
+        release(maxBytes);
+    }
+}
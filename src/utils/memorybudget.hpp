@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** @brief This class keeps track of the memory used by the caches of the application, and enforces a global budget.
+    Each memory consumer (thumbnail cache, monitor frame cache, scopes, ...) registers a function returning its usage in bytes, and
+    optionally a function freeing memory. Consumers call requestCheck() when their usage grows. When the total usage exceeds the
+    memorybudget setting, the releasable consumers are asked to free the excess, in proportion of their usage, so that no cache is
+    emptied to make room for another one.
+    The usage and release functions are always called from the main thread.
+ * Note that this class is a Singleton
+ */
+class MemoryBudget
+{
+
+public:
+    /** @brief Returns the number of bytes used by a consumer */
+    using UsageFunction = std::function<qint64()>;
+    /** @brief Asks a consumer to free at least the given number of bytes, returns the number of bytes actually freed */
+    using ReleaseFunction = std::function<qint64(qint64)>;
+
+    /** @brief Usage of the consumers registered with a given name */
+    struct Usage
+    {
+        QString name;
+        qint64 bytes;
+        bool releasable;
+    };
+
+    // Returns the instance of the Singleton
+    static std::unique_ptr<MemoryBudget> &get();
+
+    /** @brief Register a memory consumer, returns its id. Several consumers can share a name, their usage is then added */
+    int registerConsumer(const QString &name, UsageFunction usage, ReleaseFunction release = nullptr);
+    void unregisterConsumer(int id);
+
+    /** @brief Returns the usage of the consumers, grouped by name */
+    std::vector<Usage> usage() const;
+    /** @brief Returns the total number of bytes used by the consumers */
+    qint64 totalUsage() const;
+    /** @brief Returns the global budget in bytes, 0 if there is no limit */
+    static qint64 budget();
+    /** @brief Returns the usage as a json document */
+    QString report() const;
+
+    /** @brief Ask the releasable consumers to free memory until the total usage is below maxBytes. If the other consumers alone use most of
+        maxBytes, the releasable ones are still allowed a quarter of it. Returns the number of bytes freed */
+    qint64 release(qint64 maxBytes);
+    /** @brief Check the budget later in the main thread. Can be called from any thread, requests are coalesced */
+    void requestCheck();
+
+protected:
+    // Constructor is protected because class is a Singleton
+    MemoryBudget();
+    /** @brief Release memory if the budget is exceeded */
+    void check();
+
+    static std::unique_ptr<MemoryBudget> instance;
+    static std::once_flag m_onceFlag; // flag to create the repository only once;
+
+    struct Consumer
+    {
+        QString name;
+        UsageFunction usage;
+        ReleaseFunction release;
+    };
+    /** @brief Returns a copy of the registered consumers, so that their functions are called outside of the lock */
+    std::map<int, Consumer> consumers() const;
+
+    mutable QMutex m_mutex;
+    std::map<int, Consumer> m_consumers;
+    int m_nextId{0};
+    // true if a check is already queued in the main thread
+    std::atomic<bool> m_checkPending{false};
+};
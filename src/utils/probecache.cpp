@@ -0,0 +1,224 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "probecache.hpp"
+#include "bin/bin.h"
+#include "bin/projectclip.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "profiles/profilemodel.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+
+std::unique_ptr<ProbeCache> ProbeCache::instance;
+std::once_flag ProbeCache::m_onceFlag;
+
+namespace {
+const quint32 entryMagic = 0x4b50524f;
+const qint32 entryVersion = 2;
+// Properties set by the avformat producer when opening a file, besides the meta ones
+const char *probedNames[] = {"length", "out", "seekable", "audio_index", "video_index", "creation_time"};
+// Number of entries kept in the cache folder, an entry is a few KB
+const int maxCachedEntries = 10000;
+} // namespace
+
+ProbeCache::ProbeCache()
+    : m_dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/probe"))
+{
+    if (!m_dir.exists()) {
+        m_dir.mkpath(QStringLiteral("."));
+    }
+    m_pool.setMaxThreadCount(1);
+    QtConcurrent::run(&m_pool, [this]() { evict(maxCachedEntries); });
+}
+
+ProbeCache::~ProbeCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+std::unique_ptr<ProbeCache> &ProbeCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ProbeCache()); });
+    return instance;
+}
+
+QString ProbeCache::entryPath(const QString &path) const
+{
+    return m_dir.absoluteFilePath(QString::fromLatin1(QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex()));
+}
+
+bool ProbeCache::readEntry(const QString &path, double fps, QMap<QByteArray, QByteArray> &properties) const
+{
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return false;
+    }
+    QFile file(entryPath(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 magic;
+    qint32 version;
+    QString entryPath;
+    qint64 size;
+    qint64 modified;
+    double entryFps;
+    stream >> magic >> version;
+    if (magic != entryMagic || version != entryVersion) {
+        return false;
+    }
+    stream >> entryPath >> size >> modified >> entryFps >> properties;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    return entryPath == path && size == info.size() && modified == info.lastModified().toMSecsSinceEpoch() && qFuzzyCompare(entryFps, fps) &&
+           !properties.isEmpty();
+}
+
+bool ProbeCache::updateEntry(const QString &path, double fps, Mlt::Producer &producer)
+{
+    QMap<QByteArray, QByteArray> cached;
+    if (!readEntry(path, fps, cached)) {
+        // Changed on disk, the file watcher takes care of reloading
+        return false;
+    }
+    const QMap<QByteArray, QByteArray> probed = probedProperties(producer);
+    if (probed == cached) {
+        return false;
+    }
+    writeEntry(path, fps, probed);
+    return true;
+}
+
+void ProbeCache::evict(int maxEntries)
+{
+    // Entries are touched when used, oldest first
+    const QFileInfoList entries = m_dir.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    for (int i = 0; i < entries.count() - maxEntries; ++i) {
+        QFile::remove(entries.at(i).absoluteFilePath());
+    }
+}
+
+void ProbeCache::writeEntry(const QString &path, double fps, const QMap<QByteArray, QByteArray> &properties)
+{
+    QFileInfo info(path);
+    // Written to a temporary file then renamed, so that another instance never reads a partial entry
+    QSaveFile file(entryPath(path));
+    if (!info.exists() || !file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << entryMagic << entryVersion << path << info.size() << info.lastModified().toMSecsSinceEpoch() << fps << properties;
+    file.commit();
+}
+
+QMap<QByteArray, QByteArray> ProbeCache::probedProperties(Mlt::Producer &producer)
+{
+    QMap<QByteArray, QByteArray> properties;
+    for (const char *name : probedNames) {
+        const char *value = producer.get(name);
+        if (value != nullptr) {
+            properties.insert(name, value);
+        }
+    }
+    for (int i = 0; i < producer.count(); ++i) {
+        const char *name = producer.get_name(i);
+        if (name != nullptr && strncmp(name, "meta.", 5) == 0) {
+            const char *value = producer.get(i);
+            if (value != nullptr) {
+                properties.insert(name, value);
+            }
+        }
+    }
+    return properties;
+}
+
+void ProbeCache::applyProperties(Mlt::Producer &producer, const QMap<QByteArray, QByteArray> &properties)
+{
+    QMapIterator<QByteArray, QByteArray> i(properties);
+    while (i.hasNext()) {
+        i.next();
+        producer.set(i.key().constData(), i.value().constData());
+    }
+}
+
+std::shared_ptr<Mlt::Producer> ProbeCache::restore(Mlt::Profile &profile, const QString &path)
+{
+    QMap<QByteArray, QByteArray> properties;
+    if (!readEntry(path, profile.fps(), properties)) {
+        return nullptr;
+    }
+    auto producer = std::make_shared<Mlt::Producer>(profile, "avformat-novalidate", path.toUtf8().constData());
+    if (!producer->is_valid()) {
+        return nullptr;
+    }
+    // Mark the entry as recently used, so that it is not evicted
+    QFile entry(entryPath(path));
+    if (entry.open(QIODevice::Append)) {
+        entry.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    applyProperties(*producer.get(), properties);
+    // The file will be opened on first use, handle the producer as one that was probed
+    producer->set("mlt_service", "avformat");
+    return producer;
+}
+
+void ProbeCache::store(const QString &path, Mlt::Producer &producer)
+{
+    writeEntry(path, producer.get_fps(), probedProperties(producer));
+}
+
+void ProbeCache::revalidate(const QString &path, const QString &binId)
+{
+    QtConcurrent::run(&m_pool, [this, path, binId]() {
+        Mlt::Profile &profile = pCore->getCurrentProfile()->profile();
+        const double fps = profile.fps();
+        QMap<QByteArray, QByteArray> cached;
+        if (!readEntry(path, fps, cached)) {
+            // Changed on disk, the file watcher takes care of reloading
+            return;
+        }
+        Mlt::Producer producer(profile, "avformat", path.toUtf8().constData());
+        if (!producer.is_valid() || !updateEntry(path, fps, producer)) {
+            return;
+        }
+        QMetaObject::invokeMethod(pCore.get(),
+                                  [binId, path]() {
+                                      std::shared_ptr<ProjectClip> clip = pCore->projectItemModel()->getClipByBinID(binId);
+                                      if (clip && (clip->url() == path || clip->getProducerProperty(QStringLiteral("kdenlive:proxy")) == path)) {
+                                          pCore->bin()->reloadClip(binId);
+                                      }
+                                  },
+                                  Qt::QueuedConnection);
+    });
+}
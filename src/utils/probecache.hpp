@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QMap>
+#include <QString>
+#include <QThreadPool>
+#include <memory>
+#include <mutex>
+
+namespace Mlt {
+class Producer;
+class Profile;
+} // namespace Mlt
+
+/** @brief This class stores the result of probing media files, so that reopening a project doesn't open and probe every clip again.
+    When a clip is loaded by avformat, the stream layout, length and meta.media properties that MLT found are written to an entry of the
+    persistent cache, identified by the file path, size and modification time, and by the project frame rate (lengths are expressed in frames).
+    Next time the file is loaded, a producer is created with the avformat-novalidate service, which delays opening the file until a frame
+    is requested, and receives the cached properties.
+    Each clip restored from the cache is probed again by a single low priority background thread. If the result differs, the entry is
+    updated and the clip reloaded.
+    The cache keeps the most recently used entries only: the oldest entries beyond 10000 are removed in the background when a session starts.
+ * Note that this class is a Singleton
+ */
+class ProbeCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ProbeCache> &get();
+    ~ProbeCache();
+
+    /** @brief Returns a producer for the file at path built from the cache, or nullptr if the file was not probed or changed since */
+    std::shared_ptr<Mlt::Producer> restore(Mlt::Profile &profile, const QString &path);
+    /** @brief Store the properties found by MLT when opening the file at path with the avformat producer */
+    void store(const QString &path, Mlt::Producer &producer);
+    /** @brief Probe the file at path in the background and reload the bin clip if it doesn't match the cache anymore */
+    void revalidate(const QString &path, const QString &binId);
+    /** @brief Remove the least recently used entries until at most maxEntries are left */
+    void evict(int maxEntries);
+
+protected:
+    // Constructor is protected because class is a Singleton
+    ProbeCache();
+    // Returns the cache entry file of a media file
+    QString entryPath(const QString &path) const;
+    /** @brief Read the cached properties of path, returns false if there is no valid entry */
+    bool readEntry(const QString &path, double fps, QMap<QByteArray, QByteArray> &properties) const;
+    void writeEntry(const QString &path, double fps, const QMap<QByteArray, QByteArray> &properties);
+    /** @brief Compare the properties of a producer probing path with its entry, and rewrite the entry if they differ.
+        Returns true if the entry was outdated */
+    bool updateEntry(const QString &path, double fps, Mlt::Producer &producer);
+    // Returns the properties of a producer that are stored in the cache
+    static QMap<QByteArray, QByteArray> probedProperties(Mlt::Producer &producer);
+    // Set the cached properties on a producer created without probing
+    static void applyProperties(Mlt::Producer &producer, const QMap<QByteArray, QByteArray> &properties);
+
+    static std::unique_ptr<ProbeCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the repository only once;
+
+    QDir m_dir;
+    // Runs the background probes, one at a time
+    QThreadPool m_pool;
+};
@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "producercache.hpp"
+#include "bin/projectclip.h"
+#include "kdenlivesettings.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <vector>
+
+std::unique_ptr<ProducerCache> ProducerCache::instance;
+std::once_flag ProducerCache::m_onceFlag;
+
+ProducerCache::ProducerCache() = default;
+
+std::unique_ptr<ProducerCache> &ProducerCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ProducerCache()); });
+    return instance;
+}
+
+void ProducerCache::touch(const std::shared_ptr<ProjectClip> &clip)
+{
+    const QString binId = clip->clipId();
+    QMutexLocker locker(&m_mutex);
+    auto it = m_clips.find(binId);
+    if (it != m_clips.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.first);
+        it->second.second = clip;
+    } else {
+        m_lru.push_front(binId);
+        m_clips[binId] = {m_lru.begin(), clip};
+    }
+    int budget = KdenliveSettings::openproducerbudget();
+    if (budget <= 0 || (int)m_clips.size() <= budget || m_releasePending) {
+        return;
+    }
+    // Producers are released in the main thread, since clips may be used by the timeline and effect stacks
+    m_releasePending = true;
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [this]() { enforceBudget(KdenliveSettings::openproducerbudget()); }, Qt::QueuedConnection);
+}
+
+void ProducerCache::remove(const QString &binId)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_clips.find(binId);
+    if (it != m_clips.end()) {
+        m_lru.erase(it->second.first);
+        m_clips.erase(it);
+    }
+}
+
+void ProducerCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_lru.clear();
+    m_clips.clear();
+}
+
+int ProducerCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return (int)m_clips.size();
+}
+
+void ProducerCache::enforceBudget(int maxClips)
+{
+    std::vector<std::shared_ptr<ProjectClip>> released;
+    QMutexLocker locker(&m_mutex);
+    m_releasePending = false;
+    while (maxClips > 0 && (int)m_lru.size() > maxClips) {
+        auto it = m_clips.find(m_lru.back());
+        if (auto clip = it->second.second.lock()) {
+            released.push_back(clip);
+        }
+        m_clips.erase(it);
+        m_lru.pop_back();
+    }
+    locker.unlock();
+    // Clips are released outside of the lock, because closing producers can take time
+    for (const auto &clip : released) {
+        clip->releaseProducers();
+    }
+}
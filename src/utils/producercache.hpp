@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "definitions.h"
+
+class ProjectClip;
+
+/** @brief This class bounds the number of bin clips keeping extra producers open.
+    Besides its master producer, which holds the clip metadata displayed in the bin, a bin clip opens producers on demand: a pool of
+    thumbnail producers, a disabled producer and one producer per timeline track. They each hold decoder state and filters, and they
+    are kept after use so that the next request is fast. In projects with thousands of clips this exhausts file handles and memory.
+    Clips are registered here each time they open such a producer. When more than openproducerbudget clips are registered, the least
+    recently used ones close their extra producers. Those are reopened on demand by the clip the next time they are needed.
+ * Note that this class is a Singleton
+ */
+class ProducerCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ProducerCache> &get();
+
+    /** @brief Mark the clip as recently used, to be called each time it opens a producer. Can be called from any thread.
+        If the budget is exceeded, the least recently used clips are released later in the main thread */
+    void touch(const std::shared_ptr<ProjectClip> &clip);
+    /** @brief Stop tracking a clip, for example when it is removed from the bin */
+    void remove(const QString &binId);
+    /** @brief Stop tracking all clips */
+    void clear();
+    /** @brief Returns the number of clips currently keeping extra producers open */
+    int count() const;
+    /** @brief Release the producers of the least recently used clips until at most maxClips clips keep producers open.
+        Must be called from the main thread. 0 means no limit */
+    void enforceBudget(int maxClips);
+
+protected:
+    // Constructor is protected because class is a Singleton
+    ProducerCache();
+
+    static std::unique_ptr<ProducerCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the repository only once;
+
+    mutable QMutex m_mutex;
+    // bin ids of the tracked clips, most recently used first
+    std::list<QString> m_lru;
+    std::unordered_map<QString, std::pair<std::list<QString>::iterator, std::weak_ptr<ProjectClip>>> m_clips;
+    // true if an enforceBudget call is already queued in the main thread
+    bool m_releasePending{false};
+};
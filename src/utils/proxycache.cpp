@@ -0,0 +1,230 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "proxycache.hpp"
+#include "kdenlivesettings.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+std::unique_ptr<ProxyCache> ProxyCache::instance;
+std::once_flag ProxyCache::m_onceFlag;
+
+namespace {
+// Infix of the files being encoded
+const QString partialInfix = QStringLiteral(".part");
+// Partial files older than this (in seconds) are left over by a crash and can be removed
+const qint64 partialTimeout = 24 * 3600;
+// Hidden files listing the proxies used by each running instance, named .session-<pid>.used and guarded by .session-<pid>.lock
+const QString sessionPrefix = QStringLiteral(".session-");
+const QString sessionSuffix = QStringLiteral(".used");
+const QString lockSuffix = QStringLiteral(".lock");
+} // namespace
+
+ProxyCache::ProxyCache() = default;
+
+ProxyCache::~ProxyCache()
+{
+    if (m_sessionLock) {
+        QFile::remove(m_sessionFile);
+    }
+}
+
+std::unique_ptr<ProxyCache> &ProxyCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ProxyCache()); });
+    return instance;
+}
+
+QDir ProxyCache::sharedDir()
+{
+    // Same folder as KdenliveDoc::getCacheDir(CacheProxy) when the project has no custom folder
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/proxy"));
+    if (!dir.exists()) {
+        dir.mkpath(QStringLiteral("."));
+    }
+    return dir;
+}
+
+QString ProxyCache::proxyName(const QString &clipHash, const QString &params, const QString &extension)
+{
+    const QByteArray paramsHash = QCryptographicHash::hash((params.simplified() + extension).toUtf8(), QCryptographicHash::Md5).toHex();
+    return clipHash + QLatin1Char('-') + QString::fromLatin1(paramsHash.left(12)) + extension;
+}
+
+QString ProxyCache::proxyPath(const QDir &dir, const QString &clipHash, const QString &params, const QString &extension)
+{
+    // Older versions did not record the parameters of a proxy. Projects using the default profile most likely created it with the same one
+    const QString defaultParams = extension == QLatin1String(".png") ? QString::number(KdenliveSettings::proxyimagesize()) : KdenliveSettings::proxyparams();
+    const QString legacyName = clipHash + extension;
+    if (params.simplified() == defaultParams.simplified() && dir.exists(legacyName) && QFileInfo(dir.absoluteFilePath(legacyName)).size() > 0) {
+        return dir.absoluteFilePath(legacyName);
+    }
+    return dir.absoluteFilePath(proxyName(clipHash, params, extension));
+}
+
+QString ProxyCache::partialPath(const QString &path)
+{
+    QFileInfo info(path);
+    const QString suffix = info.suffix();
+    if (suffix.isEmpty()) {
+        return path + partialInfix;
+    }
+    return info.absoluteDir().absoluteFilePath(info.completeBaseName() + partialInfix + QLatin1Char('.') + suffix);
+}
+
+bool ProxyCache::isShared(const QString &path)
+{
+    return QFileInfo(path).absolutePath() == sharedDir().absolutePath();
+}
+
+bool ProxyCache::use(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.exists() || info.size() == 0) {
+        return false;
+    }
+    if (isShared(path)) {
+        markUsed(info.fileName());
+        QFile file(path);
+        if (file.open(QIODevice::Append)) {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+    }
+    return true;
+}
+
+void ProxyCache::markUsed(const QString &fileName)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_usedFiles.contains(fileName)) {
+        return;
+    }
+    m_usedFiles.insert(fileName);
+    if (!m_sessionLock) {
+        const QDir dir = sharedDir();
+        const QString session = sessionPrefix + QString::number(QCoreApplication::applicationPid());
+        m_sessionFile = dir.absoluteFilePath(session + sessionSuffix);
+        m_sessionLock.reset(new QLockFile(dir.absoluteFilePath(session + lockSuffix)));
+        // Only consider the lock stale if this process is not running anymore
+        m_sessionLock->setStaleLockTime(0);
+        m_sessionLock->tryLock(0);
+        QFile::remove(m_sessionFile);
+    }
+    const QString sessionFile = m_sessionFile;
+    lock.unlock();
+    // Appending a line is atomic, no need to serialize the writes
+    QFile file(sessionFile);
+    if (file.open(QIODevice::Append)) {
+        file.write(fileName.toUtf8() + '\n');
+    }
+}
+
+QSet<QString> ProxyCache::usedByOtherInstances(const QDir &dir)
+{
+    QSet<QString> result;
+    const QString own = sessionPrefix + QString::number(QCoreApplication::applicationPid()) + sessionSuffix;
+    for (const QString &name : dir.entryList({sessionPrefix + QLatin1Char('*') + sessionSuffix}, QDir::Files | QDir::Hidden)) {
+        if (name == own) {
+            continue;
+        }
+        QLockFile lock(dir.absoluteFilePath(name.chopped(sessionSuffix.size()) + lockSuffix));
+        lock.setStaleLockTime(0);
+        if (lock.tryLock(0)) {
+            // The instance is not running anymore, its lock is removed when going out of scope
+            dir.remove(name);
+            continue;
+        }
+        QFile file(dir.absoluteFilePath(name));
+        if (file.open(QIODevice::ReadOnly)) {
+            for (const QByteArray &line : file.readAll().split('\n')) {
+                if (!line.isEmpty()) {
+                    result.insert(QString::fromUtf8(line));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool ProxyCache::commit(const QString &partial, const QString &path)
+{
+    if (QFileInfo(partial).size() == 0) {
+        QFile::remove(partial);
+        return false;
+    }
+    QFile::remove(path);
+    if (!QFile::rename(partial, path)) {
+        QFile::remove(partial);
+        return false;
+    }
+    if (isShared(path)) {
+        markUsed(QFileInfo(path).fileName());
+        evict(qint64(KdenliveSettings::proxycachesize()) * 1024 * 1024 * 1024);
+    }
+    return true;
+}
+
+void ProxyCache::evict(qint64 maxSize)
+{
+    if (maxSize <= 0) {
+        // No limit
+        return;
+    }
+    QMutexLocker lock(&m_mutex);
+    QSet<QString> used = m_usedFiles;
+    lock.unlock();
+    // Listing and removing files is slow on large folders, it is done without holding the lock
+    QDir dir = sharedDir();
+    used += usedByOtherInstances(dir);
+    // Oldest first. The hidden session files are not listed
+    QFileInfoList files = dir.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    const QDateTime now = QDateTime::currentDateTime();
+    qint64 total = 0;
+    for (const QFileInfo &info : files) {
+        total += info.size();
+    }
+    for (const QFileInfo &info : files) {
+        if (total <= maxSize) {
+            break;
+        }
+        const QString fileName = info.fileName();
+        if (used.contains(fileName)) {
+            continue;
+        }
+        if (fileName.contains(partialInfix) && info.lastModified().secsTo(now) < partialTimeout) {
+            // Probably being encoded by another instance
+            continue;
+        }
+        // The proxy may have been linked since the list was copied
+        lock.relock();
+        const bool usedNow = m_usedFiles.contains(fileName);
+        lock.unlock();
+        if (!usedNow && dir.remove(fileName)) {
+            total -= info.size();
+        }
+    }
+}
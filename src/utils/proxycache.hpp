@@ -0,0 +1,92 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <QDir>
+#include <QLockFile>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <memory>
+#include <mutex>
+
+/** @brief This class manages the proxy clips stored in the shared cache folder.
+    Projects using the default cache location all store their proxies in the same folder. A proxy is named after the hash of its source
+    file and a hash of the encoding parameters, so that a project using the same rushes with the same proxy profile finds the proxy
+    created by another project instead of encoding it again.
+    Proxies are written to a partial file and renamed once complete, so that an interrupted encode is never mistaken for a valid proxy.
+    The shared folder is bounded by the proxycachesize setting. When it grows beyond, the least recently used proxies are removed.
+    A proxy is marked as used (its modification time is updated) each time a project links it. Proxies used during the current session are never evicted.
+    Each running instance lists the proxies it uses in a hidden session file of the shared folder, guarded by a lock file, so that proxies
+    used by the projects opened in another instance are not evicted either.
+    Proxies named after the source hash only, as created by older versions, are reused by projects using the default proxy profile.
+ * Note that this class is a Singleton
+ */
+class ProxyCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ProxyCache> &get();
+    ~ProxyCache();
+
+    /** @brief Returns the proxy folder shared by the projects using the default cache location */
+    static QDir sharedDir();
+    /** @brief Returns the file name of the proxy of a source clip
+        @param clipHash is the hash of the source file, as returned by ProjectClip::hash()
+        @param params is the proxy encoding profile
+        @param extension is the proxy file extension, including the dot */
+    static QString proxyName(const QString &clipHash, const QString &params, const QString &extension);
+    /** @brief Returns the path of the proxy of a source clip in dir, see proxyName. If params is the default proxy profile, an existing proxy
+        named clipHash + extension is returned instead */
+    static QString proxyPath(const QDir &dir, const QString &clipHash, const QString &params, const QString &extension);
+    /** @brief Returns the path where a proxy is written until it is complete. The extension is kept so that encoders can guess the format */
+    static QString partialPath(const QString &path);
+
+    /** @brief Returns true if a complete proxy exists at path. If it is in the shared folder, it is marked as recently used */
+    bool use(const QString &path);
+    /** @brief Move a finished proxy from its partial path to its final path, then enforce the size limit of the shared folder */
+    bool commit(const QString &partial, const QString &path);
+    /** @brief Remove the least recently used proxies from the shared folder until it is smaller than maxSize bytes */
+    void evict(qint64 maxSize);
+
+protected:
+    // Constructor is protected because class is a Singleton
+    ProxyCache();
+    // Returns true if the file is in the shared proxy folder
+    static bool isShared(const QString &path);
+    // Protect a shared proxy from eviction by this instance and the other ones
+    void markUsed(const QString &fileName);
+    // Returns the file names of the shared proxies used by the other running instances, and removes the session files of the stopped ones
+    static QSet<QString> usedByOtherInstances(const QDir &dir);
+
+    static std::unique_ptr<ProxyCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the repository only once;
+
+    QMutex m_mutex;
+    // file names of the shared proxies used during this session, which must not be evicted
+    QSet<QString> m_usedFiles;
+    // held while this instance runs, so that the other instances know that its session file is current
+    std::unique_ptr<QLockFile> m_sessionLock;
+    // file listing m_usedFiles for the other instances
+    QString m_sessionFile;
+};
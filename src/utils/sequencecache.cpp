@@ -0,0 +1,427 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "sequencecache.hpp"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QStandardPaths>
+#include <mlt++/MltConsumer.h>
+#include <mlt++/MltPlaylist.h>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+#include <memory>
+#include <vector>
+
+namespace {
+// Guard against services referencing each other
+const int maxDepth = 16;
+
+bool isSequence(const QDomElement &service)
+{
+    return service.tagName() == QLatin1String("playlist") || service.tagName() == QLatin1String("tractor");
+}
+
+/** @brief Walks the xml description of a sequence and feeds each chunk's hash with the items overlapping it */
+class Fingerprinter
+{
+public:
+    Fingerprinter(const QDomDocument &doc, const QString &path, int length, int chunkSize, double fps)
+        : m_chunkSize(chunkSize)
+        , m_fps(fps)
+    {
+        QDomElement mlt = doc.documentElement();
+        m_root = mlt.hasAttribute(QStringLiteral("root")) ? QDir(mlt.attribute(QStringLiteral("root"))) : QFileInfo(path).absoluteDir();
+        QDomElement profile = mlt.firstChildElement(QStringLiteral("profile"));
+        if (!profile.isNull() && profile.attribute(QStringLiteral("frame_rate_den")).toInt() > 0) {
+            m_fps = profile.attribute(QStringLiteral("frame_rate_num")).toDouble() / profile.attribute(QStringLiteral("frame_rate_den")).toDouble();
+        }
+        for (const QString &tag : {QStringLiteral("producer"), QStringLiteral("chain"), QStringLiteral("playlist"), QStringLiteral("tractor")}) {
+            QDomNodeList services = doc.elementsByTagName(tag);
+            for (int i = 0; i < services.count(); ++i) {
+                QDomElement service = services.at(i).toElement();
+                if (service.hasAttribute(QStringLiteral("id"))) {
+                    m_services.insert(service.attribute(QStringLiteral("id")), service);
+                }
+            }
+        }
+        int count = (length + chunkSize - 1) / chunkSize;
+        for (int i = 0; i < count; ++i) {
+            m_hashes.push_back(std::make_unique<QCryptographicHash>(QCryptographicHash::Md5));
+        }
+    }
+
+    /** @brief Describe the frames [from, to] of service, which appear at offset + frame in the sequence */
+    void collect(const QDomElement &service, int offset, int from, int to, const QByteArray &context, int depth)
+    {
+        if (depth > maxDepth || to < from) {
+            return;
+        }
+        const QString tag = service.tagName();
+        if (tag == QLatin1String("playlist")) {
+            add(offset + from, offset + to, offset + from, offset + to, context + describe(service));
+            int position = 0;
+            for (QDomElement child = service.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+                if (child.tagName() == QLatin1String("blank")) {
+                    position += toFrames(child.attribute(QStringLiteral("length")));
+                    continue;
+                }
+                if (child.tagName() != QLatin1String("entry")) {
+                    continue;
+                }
+                const QDomElement producer = m_services.value(child.attribute(QStringLiteral("producer")));
+                int in = toFrames(child.attribute(QStringLiteral("in"), producer.attribute(QStringLiteral("in"))));
+                int length = entryLength(child, producer, in, depth);
+                if (length <= 0) {
+                    continue;
+                }
+                int start = position;
+                int end = position + length - 1;
+                position += length;
+                if (end < from || start > to) {
+                    continue;
+                }
+                const QByteArray entryContext = context + "/e";
+                int visibleStart = qMax(from, start);
+                int visibleEnd = qMin(to, end);
+                add(offset + start, offset + end, offset + visibleStart, offset + visibleEnd, entryContext + describe(child));
+                if (isSequence(producer)) {
+                    // Nested sequence, map its frames to ours
+                    collect(producer, offset + start - in, visibleStart - start + in, visibleEnd - start + in, entryContext, depth + 1);
+                } else if (!producer.isNull()) {
+                    add(offset + start, offset + end, offset + visibleStart, offset + visibleEnd, entryContext + describe(producer));
+                }
+            }
+        } else if (tag == QLatin1String("tractor") || tag == QLatin1String("multitrack")) {
+            add(offset + from, offset + to, offset + from, offset + to, context + describe(service));
+            int index = 0;
+            for (QDomElement child = service.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+                const QString childTag = child.tagName();
+                if (childTag == QLatin1String("multitrack")) {
+                    collect(child, offset, from, to, context + "/m", depth + 1);
+                } else if (childTag == QLatin1String("track")) {
+                    const QDomElement track = m_services.value(child.attribute(QStringLiteral("producer")));
+                    const QByteArray trackContext = context + "/t" + QByteArray::number(index++) + describe(child);
+                    if (isSequence(track)) {
+                        collect(track, offset, from, to, trackContext, depth + 1);
+                    } else if (!track.isNull()) {
+                        add(offset + from, offset + to, offset + from, offset + to, trackContext + describe(track));
+                    }
+                } else if (childTag == QLatin1String("transition")) {
+                    int in = child.hasAttribute(QStringLiteral("in")) ? toFrames(child.attribute(QStringLiteral("in"))) : from;
+                    int out = child.hasAttribute(QStringLiteral("out")) ? toFrames(child.attribute(QStringLiteral("out"))) : to;
+                    if (out < from || in > to) {
+                        continue;
+                    }
+                    add(offset + in, offset + out, offset + qMax(in, from), offset + qMin(out, to), context + "/c" + describe(child));
+                }
+            }
+        } else {
+            add(offset + from, offset + to, offset + from, offset + to, context + describe(service));
+        }
+    }
+
+    QStringList result(const QString &salt, int length) const
+    {
+        QStringList fingerprints;
+        for (size_t i = 0; i < m_hashes.size(); ++i) {
+            QCryptographicHash hash(QCryptographicHash::Md5);
+            hash.addData(salt.toUtf8());
+            hash.addData(QByteArray::number(qMin(m_chunkSize, length - int(i) * m_chunkSize)));
+            hash.addData(m_hashes[i]->result());
+            fingerprints << QString::fromLatin1(hash.result().toHex());
+        }
+        return fingerprints;
+    }
+
+private:
+    /** @brief Add an item spanning [start, end] of the sequence to the chunks overlapping its visible part */
+    void add(int start, int end, int visibleStart, int visibleEnd, const QByteArray &description)
+    {
+        if (visibleEnd < visibleStart || m_hashes.empty()) {
+            return;
+        }
+        int first = qMax(0, visibleStart / m_chunkSize);
+        int last = qMin(int(m_hashes.size()) - 1, visibleEnd / m_chunkSize);
+        for (int i = first; i <= last; ++i) {
+            // Positions are relative to the chunk, so that moving items elsewhere doesn't change it
+            QCryptographicHash &hash = *m_hashes[size_t(i)];
+            hash.addData(QByteArray::number(start - i * m_chunkSize) + ':' + QByteArray::number(end - start) + ' ');
+            hash.addData(description);
+            hash.addData("\n", 1);
+        }
+    }
+
+    int entryLength(const QDomElement &entry, const QDomElement &producer, int in, int depth) const
+    {
+        QString out = entry.attribute(QStringLiteral("out"), producer.attribute(QStringLiteral("out")));
+        if (!out.isEmpty()) {
+            return toFrames(out) - in + 1;
+        }
+        return serviceLength(producer, depth) - in;
+    }
+
+    int serviceLength(const QDomElement &service, int depth) const
+    {
+        if (service.isNull() || depth > maxDepth) {
+            return 0;
+        }
+        if (service.hasAttribute(QStringLiteral("out"))) {
+            return toFrames(service.attribute(QStringLiteral("out"))) - toFrames(service.attribute(QStringLiteral("in"))) + 1;
+        }
+        int length = 0;
+        if (service.tagName() == QLatin1String("playlist")) {
+            for (QDomElement child = service.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+                if (child.tagName() == QLatin1String("blank")) {
+                    length += toFrames(child.attribute(QStringLiteral("length")));
+                } else if (child.tagName() == QLatin1String("entry")) {
+                    const QDomElement producer = m_services.value(child.attribute(QStringLiteral("producer")));
+                    int in = toFrames(child.attribute(QStringLiteral("in"), producer.attribute(QStringLiteral("in"))));
+                    length += qMax(0, entryLength(child, producer, in, depth + 1));
+                }
+            }
+        } else if (service.tagName() == QLatin1String("tractor")) {
+            QDomNodeList tracks = service.elementsByTagName(QStringLiteral("track"));
+            for (int i = 0; i < tracks.count(); ++i) {
+                const QDomElement track = m_services.value(tracks.at(i).toElement().attribute(QStringLiteral("producer")));
+                length = qMax(length, serviceLength(track, depth + 1));
+            }
+        } else {
+            for (QDomElement child = service.firstChildElement(QStringLiteral("property")); !child.isNull();
+                 child = child.nextSiblingElement(QStringLiteral("property"))) {
+                if (child.attribute(QStringLiteral("name")) == QLatin1String("length")) {
+                    length = toFrames(child.text());
+                    break;
+                }
+            }
+        }
+        return length;
+    }
+
+    /** @brief Returns the attributes, properties and filters of an element, ignoring ids and properties that don't change the output */
+    QByteArray describe(const QDomElement &element) const
+    {
+        QStringList values;
+        QDomNamedNodeMap attributes = element.attributes();
+        for (int i = 0; i < attributes.count(); ++i) {
+            QDomAttr attribute = attributes.item(i).toAttr();
+            const QString name = attribute.name();
+            if (name == QLatin1String("id") || name == QLatin1String("producer")) {
+                continue;
+            }
+            values << name + QLatin1Char('=') + normalize(name, attribute.value());
+        }
+        QString service;
+        QString resource;
+        for (QDomElement child = element.firstChildElement(QStringLiteral("property")); !child.isNull();
+             child = child.nextSiblingElement(QStringLiteral("property"))) {
+            const QString name = child.attribute(QStringLiteral("name"));
+            if (name.startsWith(QLatin1Char('_')) || name.startsWith(QLatin1String("kdenlive:")) || name.startsWith(QLatin1String("meta."))) {
+                continue;
+            }
+            if (name == QLatin1String("mlt_service")) {
+                service = child.text();
+            } else if (name == QLatin1String("resource")) {
+                resource = child.text();
+            }
+            values << name + QLatin1Char('=') + normalize(name, child.text());
+        }
+        // Attribute order is not preserved by QDom
+        values.sort();
+        QByteArray result = element.tagName().toUtf8() + '(' + values.join(QLatin1Char(' ')).toUtf8() + ')';
+        if (service == QLatin1String("xml") || service == QLatin1String("consumer") || resource.endsWith(QLatin1String(".mlt")) ||
+            resource.endsWith(QLatin1String(".kdenlive"))) {
+            // A sequence loaded from another file changes when the file is edited
+            result += fileHash(resource);
+        }
+        for (QDomElement child = element.firstChildElement(QStringLiteral("filter")); !child.isNull(); child = child.nextSiblingElement(QStringLiteral("filter"))) {
+            result += '{' + describe(child) + '}';
+        }
+        return result;
+    }
+
+    QString normalize(const QString &name, const QString &value) const
+    {
+        if (name == QLatin1String("in") || name == QLatin1String("out") || name == QLatin1String("length")) {
+            return QString::number(toFrames(value));
+        }
+        return value;
+    }
+
+    QByteArray fileHash(QString path) const
+    {
+        int separator = path.indexOf(QLatin1Char(':'));
+        if (separator > 1) {
+            // Remove the service prefix, like in consumer:file.mlt
+            path = path.mid(separator + 1);
+        }
+        QFile file(m_root.absoluteFilePath(path));
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QByteArray();
+        }
+        return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5).toHex();
+    }
+
+    /** @brief Convert an MLT time value (frames, clock or smpte) to frames */
+    int toFrames(QString value) const
+    {
+        if (!value.contains(QLatin1Char(':'))) {
+            return value.toInt();
+        }
+        value.replace(QLatin1Char(';'), QLatin1Char(':'));
+        value.replace(QLatin1Char(','), QLatin1Char('.'));
+        const QStringList parts = value.split(QLatin1Char(':'));
+        if (parts.count() == 4 && !parts.last().contains(QLatin1Char('.'))) {
+            int fps = qRound(m_fps);
+            return ((parts.at(0).toInt() * 60 + parts.at(1).toInt()) * 60 + parts.at(2).toInt()) * fps + parts.at(3).toInt();
+        }
+        double seconds = 0;
+        for (const QString &part : parts) {
+            seconds = seconds * 60 + part.toDouble();
+        }
+        return qRound(seconds * m_fps);
+    }
+
+    QHash<QString, QDomElement> m_services;
+    QDir m_root;
+    int m_chunkSize;
+    double m_fps;
+    std::vector<std::unique_ptr<QCryptographicHash>> m_hashes;
+};
+} // namespace
+
+QStringList SequenceCache::chunkFingerprints(const QString &path, int length, int chunkSize, double fps, const QString &salt)
+{
+    if (length <= 0 || chunkSize <= 0) {
+        return QStringList();
+    }
+    QFile file(path);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        return QStringList();
+    }
+    file.close();
+    // MLT uses the last service of the document as the root
+    QDomElement root;
+    for (QDomElement child = doc.documentElement().lastChildElement(); !child.isNull(); child = child.previousSiblingElement()) {
+        const QString tag = child.tagName();
+        if (isSequence(child) || tag == QLatin1String("producer") || tag == QLatin1String("chain")) {
+            root = child;
+            break;
+        }
+    }
+    if (root.isNull()) {
+        return QStringList();
+    }
+    Fingerprinter fingerprinter(doc, path, length, chunkSize, fps);
+    fingerprinter.collect(root, 0, 0, length - 1, QByteArray(), 0);
+    return fingerprinter.result(salt, length);
+}
+
+bool SequenceCache::writePlaylist(Mlt::Profile &profile, const QStringList &chunks, int chunkSize, int length, const QString &path)
+{
+    Mlt::Playlist playlist(profile);
+    for (int i = 0; i < chunks.count(); ++i) {
+        Mlt::Producer chunk(profile, "avformat", chunks.at(i).toUtf8().constData());
+        if (!chunk.is_valid()) {
+            return false;
+        }
+        int frames = qMin(chunkSize, length - i * chunkSize);
+        playlist.append(chunk, 0, frames - 1);
+    }
+    Mlt::Consumer xmlConsumer(profile, "xml", path.toUtf8().constData());
+    if (!xmlConsumer.is_valid()) {
+        return false;
+    }
+    xmlConsumer.set("store", "kdenlive");
+    xmlConsumer.connect(playlist);
+    xmlConsumer.run();
+    return QFileInfo(path).size() > 0;
+}
+
+QStringList SequenceCache::playlistChunks(const QString &path)
+{
+    QStringList chunks;
+    QFile file(path);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        return chunks;
+    }
+    const QDomNodeList properties = doc.elementsByTagName(QStringLiteral("property"));
+    for (int i = 0; i < properties.count(); ++i) {
+        const QDomElement property = properties.item(i).toElement();
+        if (property.attribute(QStringLiteral("name")) == QLatin1String("resource")) {
+            const QString fileName = QFileInfo(property.text()).fileName();
+            if (!fileName.isEmpty()) {
+                chunks << fileName;
+            }
+        }
+    }
+    return chunks;
+}
+
+void SequenceCache::removePlaylist(const QString &path, const QStringList &keep)
+{
+    const QFileInfo info(path);
+    QDir dir = info.absoluteDir();
+    QSet<QString> used;
+    for (const QString &chunk : keep) {
+        used.insert(QFileInfo(chunk).fileName());
+    }
+    // Identical chunks are shared by the sequences that have the same content
+    const QStringList playlists = dir.entryList({QStringLiteral("*.mlt")}, QDir::Files);
+    for (const QString &playlist : playlists) {
+        if (playlist != info.fileName()) {
+            for (const QString &chunk : playlistChunks(dir.absoluteFilePath(playlist))) {
+                used.insert(chunk);
+            }
+        }
+    }
+    const QStringList chunks = playlistChunks(path);
+    QFile::remove(path);
+    for (const QString &chunk : chunks) {
+        if (!used.contains(chunk)) {
+            dir.remove(chunk);
+        }
+    }
+}
+
+QString SequenceCache::rendererPath()
+{
+#ifdef Q_OS_WIN
+    QString renderer = QCoreApplication::applicationDirPath() + QStringLiteral("/kdenlive_render.exe");
+#else
+    QString renderer = QCoreApplication::applicationDirPath() + QStringLiteral("/kdenlive_render");
+#endif
+    if (!QFile::exists(renderer)) {
+        renderer = QStandardPaths::findExecutable(QStringLiteral("kdenlive_render"));
+        if (renderer.isEmpty()) {
+            renderer = QStringLiteral("kdenlive_render");
+        }
+    }
+    return renderer;
+}
@@ -0,0 +1,53 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+namespace Mlt {
+class Profile;
+} // namespace Mlt
+
+/** @brief Helpers to cache the render of a nested sequence (a playlist clip) in chunks.
+    The sequence is cut in chunks of timelinechunks frames, like the timeline preview. Each chunk is named after a fingerprint of
+    everything that contributes to its frames: the clips, their effects and the compositions overlapping it, with their position
+    relative to the chunk. When the sequence is edited, only the chunks whose fingerprint changed have to be encoded again, the
+    others are found in the cache. The cached render of the sequence is an MLT playlist of the chunk files.
+ */
+class SequenceCache
+{
+public:
+    /** @brief Returns one fingerprint per chunk of the sequence stored in the MLT xml file at path
+        @param length is the number of frames of the sequence
+        @param fps is the frame rate used to read time values if the file does not define a profile
+        @param salt is mixed in every fingerprint, it should describe the profile and encoding parameters */
+    static QStringList chunkFingerprints(const QString &path, int length, int chunkSize, double fps, const QString &salt);
+    /** @brief Write an MLT playlist concatenating the chunk files to path. Returns false if a chunk cannot be opened */
+    static bool writePlaylist(Mlt::Profile &profile, const QStringList &chunks, int chunkSize, int length, const QString &path);
+    /** @brief Returns the file names of the chunks listed in the playlist at path */
+    static QStringList playlistChunks(const QString &path);
+    /** @brief Delete the playlist at path, and its chunks that are neither in keep nor listed by another playlist of the same folder */
+    static void removePlaylist(const QString &path, const QStringList &keep);
+    /** @brief Returns the path of the kdenlive_render executable, used to encode chunks */
+    static QString rendererPath();
+};
@@ -0,0 +1,189 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#include "thumbnailarchive.hpp"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+namespace {
+const quint32 archiveMagic = 0x4b544842; // "KTHB"
+const quint32 archiveVersion = 1;
+// magic, version, count
+const int headerSize = 3 * sizeof(quint32);
+// position, offset, size
+const int indexEntrySize = sizeof(qint32) + 2 * sizeof(quint32);
+
+// Thumbnails are usually decoded with an alpha channel even when the frame is fully opaque
+bool hasTransparency(const QImage &img)
+{
+    if (!img.hasAlphaChannel()) {
+        return false;
+    }
+    const QImage argb = img.format() == QImage::Format_ARGB32 ? img : img.convertToFormat(QImage::Format_ARGB32);
+    for (int y = 0; y < argb.height(); ++y) {
+        const auto *line = reinterpret_cast<const QRgb *>(argb.constScanLine(y));
+        for (int x = 0; x < argb.width(); ++x) {
+            if (qAlpha(line[x]) != 255) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+} // namespace
+
+const QString ThumbnailArchive::extension = QStringLiteral(".thumbs");
+
+ThumbnailArchive::ThumbnailArchive(const QString &path)
+    : m_path(path)
+{
+}
+
+bool ThumbnailArchive::load()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+    if (data.size() < headerSize) {
+        return false;
+    }
+    QDataStream stream(data);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != archiveMagic || version != archiveVersion || count > quint32((data.size() - headerSize) / indexEntrySize)) {
+        qDebug() << "// Invalid thumbnail archive: " << m_path;
+        return false;
+    }
+    m_tiles.clear();
+    m_bytes = 0;
+    for (quint32 i = 0; i < count; ++i) {
+        qint32 pos;
+        quint32 offset, size;
+        stream >> pos >> offset >> size;
+        if (qint64(offset) + size > data.size()) {
+            qDebug() << "// Truncated thumbnail archive: " << m_path;
+            m_tiles.clear();
+            m_bytes = 0;
+            return false;
+        }
+        m_bytes += qint64(size) - (m_tiles.count(pos) > 0 ? m_tiles.at(pos).size() : 0);
+        m_tiles[pos] = data.mid(int(offset), int(size));
+    }
+    return true;
+}
+
+const QString &ThumbnailArchive::path() const
+{
+    return m_path;
+}
+
+bool ThumbnailArchive::isEmpty() const
+{
+    return m_tiles.empty();
+}
+
+bool ThumbnailArchive::contains(int pos) const
+{
+    return m_tiles.count(pos) > 0;
+}
+
+QImage ThumbnailArchive::image(int pos) const
+{
+    auto it = m_tiles.find(pos);
+    if (it == m_tiles.end()) {
+        return QImage();
+    }
+    return QImage::fromData(it->second);
+}
+
+qint64 ThumbnailArchive::memorySize() const
+{
+    return m_bytes;
+}
+
+void ThumbnailArchive::insertTile(int pos, const QByteArray &tile)
+{
+    if (!tile.isEmpty()) {
+        auto it = m_tiles.find(pos);
+        m_bytes += tile.size() - (it != m_tiles.end() ? it->second.size() : 0);
+        m_tiles[pos] = tile;
+    }
+}
+
+// static
+QByteArray ThumbnailArchive::encode(const QImage &img)
+{
+    QByteArray result;
+    if (img.isNull()) {
+        return result;
+    }
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+    if (hasTransparency(img)) {
+        img.save(&buffer, "PNG");
+    } else {
+        img.save(&buffer, "JPG", 90);
+    }
+    return result;
+}
+
+QByteArray ThumbnailArchive::serialize() const
+{
+    QByteArray result;
+    int dataSize = 0;
+    for (const auto &tile : m_tiles) {
+        dataSize += tile.second.size();
+    }
+    const int indexSize = headerSize + int(m_tiles.size()) * indexEntrySize;
+    result.reserve(indexSize + dataSize);
+    QDataStream stream(&result, QIODevice::WriteOnly);
+    stream << archiveMagic << archiveVersion << quint32(m_tiles.size());
+    quint32 offset = quint32(indexSize);
+    for (const auto &tile : m_tiles) {
+        stream << qint32(tile.first) << offset << quint32(tile.second.size());
+        offset += quint32(tile.second.size());
+    }
+    for (const auto &tile : m_tiles) {
+        stream.writeRawData(tile.second.constData(), tile.second.size());
+    }
+    return result;
+}
+
+// static
+bool ThumbnailArchive::writeFile(const QString &path, const QByteArray &data)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "// Cannot open thumbnail archive for writing: " << path;
+        return false;
+    }
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
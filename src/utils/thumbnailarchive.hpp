@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <map>
+
+/** @brief This class holds all the persistent thumbnails of one clip in a single packed file.
+    The file starts with an index (position, offset, size) followed by the encoded tiles, so that
+    opening a clip's thumbnails costs one file read instead of one file open per frame.
+    Opaque frames are stored as JPEG tiles, which decode much faster than PNG. Images with transparent
+    pixels are stored as PNG so that transparency is preserved.
+    This class is not thread safe, access is serialized by the ThumbnailCache.
+ */
+class ThumbnailArchive
+{
+
+public:
+    explicit ThumbnailArchive(const QString &path);
+
+    /* @brief Read the whole archive from disk. Returns false if the file does not exist or is invalid */
+    bool load();
+
+    /* @brief Returns the file this archive is stored in */
+    const QString &path() const;
+
+    bool isEmpty() const;
+    bool contains(int pos) const;
+    QImage image(int pos) const;
+    /* @brief Returns the number of bytes used by the tiles */
+    qint64 memorySize() const;
+
+    /* @brief Insert an already encoded tile (JPEG or PNG data) for the given frame */
+    void insertTile(int pos, const QByteArray &tile);
+
+    /* @brief Encode an image as a tile */
+    static QByteArray encode(const QImage &img);
+
+    /* @brief Serialize the archive, ready to be written with writeFile */
+    QByteArray serialize() const;
+
+    /* @brief Atomically replace the file at path with the given data */
+    static bool writeFile(const QString &path, const QByteArray &data);
+
+    /* @brief Archive file extension */
+    static const QString extension;
+
+private:
+    QString m_path;
+    std::map<int, QByteArray> m_tiles;
+    qint64 m_bytes{0};
+};
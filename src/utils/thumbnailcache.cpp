@@ -24,13 +24,24 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "memorybudget.hpp"
+#include "thumbnailarchive.hpp"
+#include <KLocalizedString>
 #include <QDir>
 #include <QMutexLocker>
+#include <QtConcurrent>
 #include <list>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
 std::once_flag ThumbnailCache::m_onceFlag;
 
+namespace {
+// Maximum number of clip archives kept in memory
+const size_t maxLoadedArchives = 30;
+// Thumbnails are usually stored in series, the write task waits this long (ms) for more so that an archive is rewritten once per series
+const unsigned long writeBatchDelay = 500;
+} // namespace
+
 class ThumbnailCache::Cache_t
 {
 public:
@@ -87,6 +98,19 @@ public:
         m_currentCost = 0;
     }
 
+    int cost() const { return m_currentCost; }
+
+    // Remove the least recently used images until at least bytes are freed, returns the freed cost
+    int release(qint64 bytes)
+    {
+        int freed = 0;
+        while (freed < bytes && !m_data.empty()) {
+            freed += m_data.back().second.second;
+            remove(m_data.back().first);
+        }
+        return freed;
+    }
+
 protected:
     int m_maxCost;
     int m_currentCost{0};
@@ -98,6 +122,44 @@ protected:
 ThumbnailCache::ThumbnailCache()
     : m_volatileCache(new Cache_t(10000000))
 {
+    m_memoryConsumer = MemoryBudget::get()->registerConsumer(
+        i18n("Thumbnails"),
+        [this]() {
+            QMutexLocker locker(&m_mutex);
+            qint64 bytes = m_volatileCache->cost();
+            for (const auto &archive : m_archives) {
+                bytes += archive.second->memorySize();
+            }
+            return bytes;
+        },
+        [this](qint64 bytes) {
+            QMutexLocker locker(&m_mutex);
+            qint64 freed = m_volatileCache->release(bytes);
+            // Then drop the least recently used archives, they are read again from disk when needed
+            while (freed < bytes && !m_archives.empty()) {
+                freed += m_archives.back().second->memorySize();
+                removeArchive(m_archives.back().first);
+            }
+            return freed;
+        });
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    // The write task uses this object, let it complete. It only returns once the queue is empty
+    m_mutex.lock();
+    QFuture<void> task = m_writeTask;
+    m_mutex.unlock();
+    task.waitForFinished();
+}
+
+void ThumbnailCache::shutdown()
+{
+    flushPendingWrites();
+    if (m_memoryConsumer >= 0) {
+        MemoryBudget::get()->unregisterConsumer(m_memoryConsumer);
+        m_memoryConsumer = -1;
+    }
 }
 
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
@@ -117,8 +179,19 @@ bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOn
     if (!ok || volatileOnly) {
         return false;
     }
-    QDir thumbFolder = getDir(pos < 0, &ok);
-    return ok && thumbFolder.exists(key);
+    if (pos < 0) {
+        QDir thumbFolder = getDir(true, &ok);
+        return ok && thumbFolder.exists(key);
+    }
+    const QString path = getArchivePath(binId, &ok);
+    if (!ok) {
+        return false;
+    }
+    if (m_pendingWrites.count(path) > 0 && m_pendingWrites.at(path).count(pos) > 0) {
+        return true;
+    }
+    auto archive = getArchive(path, locker);
+    return archive && archive->contains(pos);
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
@@ -163,12 +236,19 @@ QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatile
     if (!ok || volatileOnly) {
         return QImage();
     }
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(pos);
-        return QImage(thumbFolder.absoluteFilePath(key));
+    const QString path = getArchivePath(binId, &ok);
+    if (!ok) {
+        return QImage();
     }
-    return QImage();
+    if (m_pendingWrites.count(path) > 0) {
+        const auto &pending = m_pendingWrites.at(path);
+        auto it = pending.find(pos);
+        if (it != pending.end()) {
+            return it->second;
+        }
+    }
+    auto archive = getArchive(path, locker);
+    return archive ? archive->image(pos) : QImage();
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
@@ -180,12 +260,9 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
         return;
     }
     if (persistent) {
-        QDir thumbFolder = getDir(false, &ok);
+        const QString path = getArchivePath(binId, &ok);
         if (ok) {
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: "<<thumbFolder.absoluteFilePath(key);
-            }
-            m_storedOnDisk[binId].push_back(pos);
+            queueWrite(path, pos, img);
             // if volatile cache also contains this entry, update it
             if (m_volatileCache->contains(key)) {
                 m_volatileCache->remove(key);
@@ -198,22 +275,36 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
         m_volatileCache->insert(key, img, (int)img.sizeInBytes());
         m_storedVolatile[binId].push_back(pos);
     }
+    MemoryBudget::get()->requestCheck();
 }
 
 void ThumbnailCache::saveCachedThumbs(QStringList keys)
 {
+    QMutexLocker locker(&m_mutex);
     bool ok;
     QDir thumbFolder = getDir(false, &ok);
     if (!ok) {
         return;
     }
     for (const QString &key : keys) {
-        if (!thumbFolder.exists(key) && m_volatileCache->contains(key)) {
-            QImage img = m_volatileCache->get(key);
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                break;
-            }
+        // keys have the form hash#pos.png
+        int separator = key.lastIndexOf(QLatin1Char('#'));
+        if (separator < 0 || !m_volatileCache->contains(key)) {
+            continue;
+        }
+        int pos = key.midRef(separator + 1).chopped(4).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        const QString path = thumbFolder.absoluteFilePath(key.left(separator) + ThumbnailArchive::extension);
+        auto archive = getArchive(path, locker);
+        if (archive && archive->contains(pos)) {
+            continue;
+        }
+        // The image may have been dropped while the archive was loading
+        const QImage img = m_volatileCache->get(key);
+        if (!img.isNull()) {
+            queueWrite(path, pos, img);
         }
     }
 }
@@ -233,35 +324,215 @@ void ThumbnailCache::invalidateThumbsForClip(const QString &binId, bool reloadAu
     }
     bool ok = false;
     // Video thumbs
-    QDir thumbFolder = getDir(false, &ok);
+    QString archivePath = getArchivePath(binId, &ok);
+    QStringList legacyFiles;
+    if (ok) {
+        m_pendingWrites.erase(archivePath);
+        m_migratedFiles.erase(archivePath);
+        removeArchive(archivePath);
+        m_archiveGeneration++;
+        if (m_writeTaskRunning) {
+            m_discardedArchives.insert(archivePath);
+        }
+        // Remove thumbnails saved by older versions that were never migrated
+        QFileInfo info(archivePath);
+        QDir thumbFolder = info.dir();
+        const QString prefix = info.completeBaseName() + QLatin1Char('#');
+        for (const QString &file : thumbFolder.entryList({prefix + QStringLiteral("*.png")}, QDir::Files)) {
+            legacyFiles << thumbFolder.absoluteFilePath(file);
+        }
+    } else {
+        archivePath.clear();
+    }
+    // Audio thumbs
     QDir audioThumbFolder = getDir(true, &ok);
     if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
-        // Remove persistent cache
-        for (int pos : m_storedOnDisk.at(binId)) {
-            if (pos < 0) {
-                if (reloadAudio) {
-                    auto key = getAudioKey(binId, &ok);
-                    if (ok) {
-                        QFile::remove(audioThumbFolder.absoluteFilePath(key));
-                    }
-                }
-            } else {
-                auto key = getKey(binId, pos, &ok);
-                if (ok) {
-                    QFile::remove(thumbFolder.absoluteFilePath(key));
-                }
+        if (reloadAudio) {
+            auto key = getAudioKey(binId, &ok);
+            if (ok) {
+                legacyFiles << audioThumbFolder.absoluteFilePath(key);
             }
         }
         m_storedOnDisk.erase(binId);
     }
+    locker.unlock();
+    // Remove persistent cache. This must not happen while the write task is saving the same archive
+    QMutexLocker writeLocker(&m_writeMutex);
+    if (!archivePath.isEmpty()) {
+        QFile::remove(archivePath);
+    }
+    for (const QString &file : legacyFiles) {
+        QFile::remove(file);
+    }
 }
 
 void ThumbnailCache::clearCache()
 {
+    flushPendingWrites();
     QMutexLocker locker(&m_mutex);
     m_volatileCache->clear();
     m_storedVolatile.clear();
     m_storedOnDisk.clear();
+    m_archives.clear();
+    m_archiveIndex.clear();
+    m_archiveGeneration++;
+}
+
+void ThumbnailCache::flushPendingWrites()
+{
+    QMutexLocker locker(&m_mutex);
+    m_flushRequests++;
+    m_flushRequested.wakeAll();
+    while (m_writeTaskRunning || !m_pendingWrites.empty() || !m_migratedFiles.empty()) {
+        if (!m_writeTaskRunning) {
+            m_writeTaskRunning = true;
+            m_writeTask = QtConcurrent::run(this, &ThumbnailCache::processWriteQueue);
+        }
+        QFuture<void> task = m_writeTask;
+        locker.unlock();
+        task.waitForFinished();
+        locker.relock();
+    }
+    m_flushRequests--;
+}
+
+std::shared_ptr<ThumbnailArchive> ThumbnailCache::getArchive(const QString &path, QMutexLocker &locker) const
+{
+    while (true) {
+        auto it = m_archiveIndex.find(path);
+        if (it != m_archiveIndex.end()) {
+            // put the archive in front to remember last access
+            m_archives.splice(m_archives.begin(), m_archives, it->second);
+            return it->second->second;
+        }
+        // Reading the archive or the legacy files hits the disk, don't block the other cache users meanwhile
+        const int generation = m_archiveGeneration;
+        locker.unlock();
+        auto archive = std::make_shared<ThumbnailArchive>(path);
+        QStringList migrated;
+        if (!archive->load()) {
+            // No archive yet, import the png files written by older versions of the cache
+            QFileInfo info(path);
+            QDir thumbFolder = info.dir();
+            const QString prefix = info.completeBaseName() + QLatin1Char('#');
+            for (const QString &file : thumbFolder.entryList({prefix + QStringLiteral("*.png")}, QDir::Files)) {
+                bool ok = false;
+                int pos = file.midRef(prefix.size()).chopped(4).toInt(&ok);
+                QFile legacy(thumbFolder.absoluteFilePath(file));
+                if (!ok || !legacy.open(QIODevice::ReadOnly)) {
+                    continue;
+                }
+                // png data is a valid tile, no need to decode and encode again
+                archive->insertTile(pos, legacy.readAll());
+                migrated << legacy.fileName();
+            }
+        }
+        locker.relock();
+        if (m_archiveIndex.count(path) > 0 || generation != m_archiveGeneration) {
+            // Loaded by another thread, or the archives were invalidated while loading: look again
+            continue;
+        }
+        if (!migrated.isEmpty()) {
+            // Archive will be written with the next batch of thumbnails
+            m_migratedFiles[path] << migrated;
+        }
+        m_archives.emplace_front(path, archive);
+        m_archiveIndex[path] = m_archives.begin();
+        while (m_archives.size() > maxLoadedArchives) {
+            // Tiles of an evicted archive are on disk or still queued, it is simply loaded again when needed
+            removeArchive(m_archives.back().first);
+        }
+        MemoryBudget::get()->requestCheck();
+        return archive;
+    }
+}
+
+void ThumbnailCache::removeArchive(const QString &path) const
+{
+    auto it = m_archiveIndex.find(path);
+    if (it == m_archiveIndex.end()) {
+        return;
+    }
+    m_archives.erase(it->second);
+    m_archiveIndex.erase(it);
+}
+
+void ThumbnailCache::queueWrite(const QString &path, int pos, const QImage &img)
+{
+    m_pendingWrites[path][pos] = img;
+    if (!m_writeTaskRunning) {
+        m_writeTaskRunning = true;
+        m_writeTask = QtConcurrent::run(this, &ThumbnailCache::processWriteQueue);
+    }
+}
+
+void ThumbnailCache::processWriteQueue()
+{
+    while (true) {
+        std::unordered_map<QString, std::map<int, QImage>> pending;
+        std::unordered_map<QString, QStringList> migrated;
+        m_mutex.lock();
+        if (m_flushRequests == 0 && (!m_pendingWrites.empty() || !m_migratedFiles.empty())) {
+            m_flushRequested.wait(&m_mutex, writeBatchDelay);
+        }
+        std::swap(pending, m_pendingWrites);
+        std::swap(migrated, m_migratedFiles);
+        m_discardedArchives.clear();
+        if (pending.empty() && migrated.empty()) {
+            m_writeTaskRunning = false;
+            m_mutex.unlock();
+            return;
+        }
+        m_mutex.unlock();
+        // Encode outside of the lock so that the cache stays responsive
+        std::unordered_map<QString, std::map<int, QByteArray>> tiles;
+        for (const auto &archive : pending) {
+            for (const auto &img : archive.second) {
+                tiles[archive.first][img.first] = ThumbnailArchive::encode(img.second);
+            }
+        }
+        for (const auto &archive : migrated) {
+            tiles[archive.first];
+        }
+        for (const auto &archiveTiles : tiles) {
+            const QString &path = archiveTiles.first;
+            QMutexLocker writeLocker(&m_writeMutex);
+            QByteArray data;
+            QMutexLocker locker(&m_mutex);
+            if (m_discardedArchives.count(path) == 0) {
+                auto archive = getArchive(path, locker);
+                if (m_discardedArchives.count(path) > 0) {
+                    // Invalidated while the archive was loading
+                    removeArchive(path);
+                    continue;
+                }
+                for (const auto &tile : archiveTiles.second) {
+                    archive->insertTile(tile.first, tile.second);
+                }
+                if (!archive->isEmpty()) {
+                    data = archive->serialize();
+                }
+                // Loading the archive could have queued files for migration, they are included in this write
+                if (m_migratedFiles.count(path) > 0) {
+                    migrated[path] << m_migratedFiles.at(path);
+                    m_migratedFiles.erase(path);
+                }
+            }
+            locker.unlock();
+            if (data.isEmpty()) {
+                continue;
+            }
+            if (!ThumbnailArchive::writeFile(path, data)) {
+                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMBS in: " << path;
+                continue;
+            }
+            if (migrated.count(path) > 0) {
+                for (const QString &file : migrated.at(path)) {
+                    QFile::remove(file);
+                }
+            }
+        }
+    }
 }
 
 // static
@@ -276,6 +547,18 @@ QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
     return *ok ? binClip->hash() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".png") : QString();
 }
 
+// static
+QString ThumbnailCache::getArchivePath(const QString &binId, bool *ok)
+{
+    auto binClip = pCore->projectItemModel()->getClipByBinID(binId);
+    if (binClip == nullptr) {
+        *ok = false;
+        return QString();
+    }
+    QDir thumbFolder = getDir(false, ok);
+    return *ok ? thumbFolder.absoluteFilePath(binClip->hash() + ThumbnailArchive::extension) : QString();
+}
+
 // static
 QString ThumbnailCache::getAudioKey(const QString &binId, bool *ok)
 {
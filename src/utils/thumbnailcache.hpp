@@ -25,15 +25,28 @@
 #include <QDir>
 #include <QUrl>
 #include <QImage>
+#include <QFuture>
 #include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+class ThumbnailArchive;
+
 /** @brief This class class is an interface to the caches that store thumbnails.
     In Kdenlive, we use two such caches, a persistent that is stored on disk to allow thumbnails to be reused when reopening.
     The other one is a volatile LRU cache that lives in memory.
+    The persistent cache stores one packed ThumbnailArchive per clip. Writes are queued and performed by a background
+    task, so that storing a thumbnail never blocks on image encoding or disk access. The task groups the thumbnails
+    stored within a short delay, since each write rewrites the whole archive. Thumbnails saved as individual
+    png files by older versions are migrated into the archive the first time a clip's archive is opened.
+    Only the archives of the most recently used clips are kept in memory.
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
@@ -46,6 +59,7 @@ class ThumbnailCache
 public:
     // Returns the instance of the Singleton
     static std::unique_ptr<ThumbnailCache> &get();
+    ~ThumbnailCache();
 
     /* @brief Check whether a given thumbnail is in the cache
        @param binId is the id of the queried clip
@@ -76,9 +90,15 @@ public:
     /* @brief Save all cached thumbs to disk */
     void saveCachedThumbs(QStringList keys);
 
-    /* @brief Reset cache (discarding all thumbs stored in memory) */
+    /* @brief Reset cache (discarding all thumbs stored in memory). Pending disk writes are completed first */
     void clearCache();
 
+    /* @brief Write all queued thumbnails to disk, blocking until done */
+    void flushPendingWrites();
+
+    /* @brief Write the queued thumbnails and stop reporting to the memory budget. Called by Core::clean when the application exits */
+    void shutdown();
+
 protected:
     // Constructor is protected because class is a Singleton
     ThumbnailCache();
@@ -86,6 +106,19 @@ protected:
     // Return the key associated to a thumbnail
     static QString getKey(const QString &binId, int pos, bool *ok);
     static QString getAudioKey(const QString &binId, bool *ok);
+    // Return the path of the packed archive holding the persistent thumbnails of a clip
+    static QString getArchivePath(const QString &binId, bool *ok);
+
+    /* @brief Return the archive stored at path, loading or migrating it if needed.
+       locker must hold m_mutex. It is released while the archive file is read, so the cache state can change during the call
+    */
+    std::shared_ptr<ThumbnailArchive> getArchive(const QString &path, QMutexLocker &locker) const;
+    // Forget the loaded archive stored at path. m_mutex must be locked
+    void removeArchive(const QString &path) const;
+    // Queue an image to be written to the archive at path. m_mutex must be locked
+    void queueWrite(const QString &path, int pos, const QImage &img);
+    // Background task writing queued thumbnails to disk
+    void processWriteQueue();
 
     // Return the dir where the persistent cache lives
     static QDir getDir(bool audio, bool *ok);
@@ -101,4 +134,25 @@ protected:
     // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
     std::unordered_map<QString, std::vector<int>> m_storedVolatile;
     mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+
+    // loaded archives as (path, archive), most recently used first. At most maxLoadedArchives are kept
+    mutable std::list<std::pair<QString, std::shared_ptr<ThumbnailArchive>>> m_archives;
+    mutable std::unordered_map<QString, decltype(m_archives.begin())> m_archiveIndex;
+    // incremented each time loaded archives are dropped, so that an archive loaded meanwhile is not kept
+    int m_archiveGeneration{0};
+    // thumbnails waiting to be written, indexed by archive path
+    std::unordered_map<QString, std::map<int, QImage>> m_pendingWrites;
+    // archives that must be saved because legacy png files were migrated into them, with the files to remove once written
+    mutable std::unordered_map<QString, QStringList> m_migratedFiles;
+    // archives invalidated while the write task was running, which must not be written back
+    std::unordered_set<QString> m_discardedArchives;
+    // serializes archive file writes and removals
+    QMutex m_writeMutex;
+    QFuture<void> m_writeTask;
+    bool m_writeTaskRunning{false};
+    // number of threads waiting in flushPendingWrites, the write task does not wait for more thumbnails meanwhile
+    int m_flushRequests{0};
+    QWaitCondition m_flushRequested;
+    // id of the memory budget consumer reporting the volatile cache and the loaded archives, -1 after shutdown
+    int m_memoryConsumer;
 };
@@ -0,0 +1,44 @@
+#include "bin/binclipindex.h"
+#include "test_utils.hpp"
+
+using namespace fakeit;
+Mlt::Profile profile_binclipindex;
+
+TEST_CASE("Bin clip index", "[BinClipIndex]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId1 = createProducer(profile_binclipindex, "red", binModel);
+    QString binId2 = createProducer(profile_binclipindex, "blue", binModel);
+    auto clip1 = binModel->getClipByBinID(binId1);
+    REQUIRE(clip1);
+    REQUIRE(binModel->getClipByBinID(binId2));
+    REQUIRE(binModel->getClipsByType(ClipType::Color).size() == 2);
+    REQUIRE(binModel->getClipsByType(ClipType::AV).isEmpty());
+    REQUIRE(binModel->getAllClips().size() == 2);
+    REQUIRE(binModel->getClipsByHash(clip1->hash()) == QStringList({binId1}));
+
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    REQUIRE(binModel->requestBinClipDeletion(clip1, undo, redo));
+    clip1.reset();
+    REQUIRE_FALSE(binModel->getClipByBinID(binId1));
+    REQUIRE(binModel->getClipsByType(ClipType::Color).size() == 1);
+    REQUIRE(binModel->getAllClips().size() == 1);
+
+    // Undoing the deletion registers the clip again
+    REQUIRE(undo());
+    REQUIRE(binModel->getClipByBinID(binId1));
+    REQUIRE(binModel->getAllClips().size() == 2);
+
+    binModel->clean();
+    REQUIRE(binModel->getAllClips().isEmpty());
+    pCore->m_projectManager = nullptr;
+}
@@ -0,0 +1,113 @@
+#include "bin/binsearchindex.h"
+#include "utils/producercache.hpp"
+#include "test_utils.hpp"
+
+using namespace fakeit;
+Mlt::Profile profile_binsearch;
+
+TEST_CASE("Bin search index", "[BinSearch]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    auto clip1 = binModel->getClipByBinID(createProducer(profile_binsearch, "red", binModel));
+    auto clip2 = binModel->getClipByBinID(createProducer(profile_binsearch, "blue", binModel));
+    clip1->setName(QStringLiteral("Interview Camera A"));
+    clip2->setName(QStringLiteral("Drone shot"));
+    binModel->onItemUpdated(clip1, AbstractProjectItem::DataName);
+    binModel->onItemUpdated(clip2, AbstractProjectItem::DataName);
+
+    BinSearchIndex *index = binModel->searchIndex();
+    BinSearchIndex::Filter filter;
+
+    SECTION("Text search is case insensitive and accepts ancestors")
+    {
+        filter.text = QStringLiteral("CAMERA");
+        auto visible = index->visibleItems(filter);
+        REQUIRE(visible.count(clip1->getId()) == 1);
+        REQUIRE(visible.count(clip2->getId()) == 0);
+        REQUIRE(visible.count(binModel->getRootFolder()->getId()) == 1);
+
+        // Searches shorter than a trigram scan all entries
+        filter.text = QStringLiteral("a");
+        visible = index->visibleItems(filter);
+        REQUIRE(visible.count(clip1->getId()) == 1);
+        REQUIRE(visible.count(clip2->getId()) == 0);
+
+        filter.text = QStringLiteral("missing");
+        REQUIRE(index->visibleItems(filter).empty());
+    }
+
+    SECTION("Index follows item changes")
+    {
+        int revision = index->revision();
+        clip2->setName(QStringLiteral("Camera B drone"));
+        binModel->onItemUpdated(clip2, AbstractProjectItem::DataName);
+        REQUIRE(index->revision() != revision);
+        filter.text = QStringLiteral("camera");
+        auto visible = index->visibleItems(filter);
+        REQUIRE(visible.count(clip1->getId()) == 1);
+        REQUIRE(visible.count(clip2->getId()) == 1);
+        REQUIRE(index->visibleItems({QStringLiteral("shot"), {}, 0, 0}).empty());
+    }
+
+    SECTION("Rating filter")
+    {
+        clip1->AbstractProjectItem::setRating(4);
+        binModel->onItemUpdated(clip1, AbstractProjectItem::DataRating);
+        filter.rating = 3;
+        auto visible = index->visibleItems(filter);
+        REQUIRE(visible.count(clip1->getId()) == 1);
+        REQUIRE(visible.count(clip2->getId()) == 0);
+    }
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Producer cache budget", "[BinSearch]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    auto &cache = ProducerCache::get();
+    cache->clear();
+    auto clip1 = binModel->getClipByBinID(createProducer(profile_binsearch, "red", binModel));
+    auto clip2 = binModel->getClipByBinID(createProducer(profile_binsearch, "blue", binModel));
+    auto clip3 = binModel->getClipByBinID(createProducer(profile_binsearch, "green", binModel));
+    cache->touch(clip1);
+    cache->touch(clip2);
+    cache->touch(clip3);
+    // Touching a clip again does not count it twice
+    cache->touch(clip1);
+    REQUIRE(cache->count() == 3);
+
+    // clip2 is now the least recently used clip
+    cache->enforceBudget(2);
+    REQUIRE(cache->count() == 2);
+    cache->touch(clip3);
+    cache->enforceBudget(1);
+    REQUIRE(cache->count() == 1);
+    // A released clip reopens its producers on demand
+    REQUIRE(clip1->thumbProducer() != nullptr);
+    REQUIRE(cache->count() == 2);
+
+    // No limit
+    cache->enforceBudget(0);
+    REQUIRE(cache->count() == 2);
+
+    binModel->clean();
+    REQUIRE(cache->count() == 0);
+    pCore->m_projectManager = nullptr;
+}
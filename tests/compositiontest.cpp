@@ -1,4 +1,5 @@
 #include "test_utils.hpp"
+#include <mlt++/MltField.h>
 
 Mlt::Profile profile_composition;
 QString aCompo;
@@ -412,5 +413,52 @@ TEST_CASE("Composition manipulation", "[CompositionModel]")
         REQUIRE(timeline->requestItemResize(cid1, length - 2, true) > -1);
         REQUIRE(timeline->requestItemResize(cid2, length, false) > -1);
     }
+
+    SECTION("Compositions keep their planting order")
+    {
+        auto checkOrder = [&]() {
+            REQUIRE(timeline->checkConsistency());
+            // Walk the field from the top, we must find the compositions in the reverse planting order
+            std::vector<int> found;
+            QScopedPointer<Mlt::Field> field(timeline->m_tractor->field());
+            mlt_service service = mlt_service_get_producer(field->get_service());
+            while (service != nullptr && mlt_service_identify(service) == transition_type) {
+                for (const auto &compo : timeline->m_allCompositions) {
+                    if (compo.second->get_service() == service) {
+                        found.insert(found.begin(), compo.first);
+                    }
+                }
+                service = mlt_service_producer(service);
+            }
+            REQUIRE(found == timeline->m_plantedCompositions);
+            for (size_t i = 1; i < found.size(); ++i) {
+                REQUIRE_FALSE(timeline->compositionPlantedBefore(found[i], found[i - 1]));
+            }
+        };
+        REQUIRE(timeline->requestCompositionMove(cid1, tid2, 0));
+        checkOrder();
+        REQUIRE(timeline->requestCompositionMove(cid2, tid3, 0));
+        checkOrder();
+        REQUIRE(timeline->m_plantedCompositions.size() == 2);
+
+        REQUIRE(timeline->requestCompositionMove(cid1, tid1, 0));
+        checkOrder();
+        REQUIRE(timeline->requestCompositionMove(cid2, tid2, 5));
+        checkOrder();
+        undoStack->undo();
+        checkOrder();
+        undoStack->undo();
+        checkOrder();
+        undoStack->redo();
+        checkOrder();
+        REQUIRE(timeline->m_plantedCompositions.size() == 2);
+
+        REQUIRE(timeline->requestItemDeletion(cid1));
+        checkOrder();
+        REQUIRE(timeline->m_plantedCompositions.size() == 1);
+        undoStack->undo();
+        checkOrder();
+        REQUIRE(timeline->m_plantedCompositions.size() == 2);
+    }
     Logger::print_trace();
 }
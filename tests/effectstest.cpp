@@ -2,6 +2,7 @@
 #include "doc/docundostack.hpp"
 #include "test_utils.hpp"
 
+#include <QDomDocument>
 #include <QString>
 #include <cmath>
 #include <iostream>
@@ -112,5 +113,38 @@ TEST_CASE("Effects stack", "[Effects]")
         REQUIRE(clipModel->rowCount() == 0);
         REQUIRE(splitModel->rowCount() == 1);
     }
+
+    SECTION("Add effects to several clips in one operation")
+    {
+        int cid2;
+        REQUIRE(timeline->requestClipInsertion(binId, tid1, 400, cid2));
+        auto stack1 = timeline->getClipPtr(cid1)->m_effectStack;
+        auto stack2 = timeline->getClipPtr(cid2)->m_effectStack;
+        REQUIRE(timeline->requestClipsEffect({cid1, cid2}, anEffect));
+        REQUIRE(stack1->checkConsistency());
+        REQUIRE(stack2->checkConsistency());
+        REQUIRE(stack1->rowCount() == 1);
+        REQUIRE(stack2->rowCount() == 1);
+
+        // A single undo removes the effect from all clips
+        undoStack->undo();
+        REQUIRE(stack1->rowCount() == 0);
+        REQUIRE(stack2->rowCount() == 0);
+        undoStack->redo();
+        REQUIRE(stack1->rowCount() == 1);
+        REQUIRE(stack2->rowCount() == 1);
+
+        // Paste the stack of the first clip on both clips
+        QDomDocument doc;
+        QDomElement xml = stack1->toXml(doc);
+        REQUIRE(timeline->requestClipsEffectsFromXml({cid1, cid2}, xml));
+        REQUIRE(stack1->checkConsistency());
+        REQUIRE(stack2->checkConsistency());
+        REQUIRE(stack1->rowCount() == 2);
+        REQUIRE(stack2->rowCount() == 2);
+        undoStack->undo();
+        REQUIRE(stack1->rowCount() == 1);
+        REQUIRE(stack2->rowCount() == 1);
+    }
     Logger::print_trace();
 }
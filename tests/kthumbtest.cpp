@@ -0,0 +1,82 @@
+#include "catch.hpp"
+#include "doc/kthumb.h"
+
+#include <QElapsedTimer>
+#include <iostream>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+
+Mlt::Profile profile_kthumb;
+
+namespace {
+// Conversion used before the single copy path, kept to measure the gain
+QImage legacyGetFrame(Mlt::Frame *frame, int width, int height, int scaledWidth)
+{
+    int ow = width;
+    int oh = height;
+    mlt_image_format format = mlt_image_rgb24a;
+    const uchar *imagedata = frame->get_image(format, ow, oh);
+    QImage temp(ow, oh, QImage::Format_ARGB32);
+    memcpy(temp.scanLine(0), imagedata, (unsigned)(ow * oh * 4));
+    if (scaledWidth == 0 || scaledWidth == width) {
+        return temp.rgbSwapped();
+    }
+    return temp.rgbSwapped().scaled(scaledWidth, height);
+}
+} // namespace
+
+TEST_CASE("Thumbnail extraction from frames", "[KThumb]")
+{
+    Mlt::Producer producer(profile_kthumb, "color", "0xff8000ff");
+    REQUIRE(producer.is_valid());
+
+    SECTION("Colors are preserved")
+    {
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        QImage img = KThumb::getFrame(frame.data(), 64, 36);
+        REQUIRE(img.size() == QSize(64, 36));
+        QColor color = img.pixelColor(10, 10);
+        REQUIRE(color.red() == 255);
+        REQUIRE(color.green() == 128);
+        REQUIRE(color.blue() == 0);
+        REQUIRE(color.alpha() == 255);
+    }
+
+    SECTION("Frames are rescaled horizontally")
+    {
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        QImage img = KThumb::getFrame(frame.data(), 48, 36, 64);
+        REQUIRE(img.size() == QSize(64, 36));
+        REQUIRE(img.pixelColor(63, 35) == QColor(255, 128, 0));
+    }
+}
+
+TEST_CASE("Thumbnail conversion throughput", "[.][benchmark][KThumb]")
+{
+    // Run with: runTests "[benchmark]" -d yes
+    Mlt::Producer producer(profile_kthumb, "color", "0xff8000ff");
+    const int count = 500;
+    for (int scaledWidth : {0, 171}) {
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < count; ++i) {
+            QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+            legacyGetFrame(frame.data(), 128, 72, scaledWidth);
+        }
+        qint64 legacy = timer.nsecsElapsed();
+        timer.restart();
+        for (int i = 0; i < count; ++i) {
+            QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+            KThumb::getFrame(frame.data(), 128, 72, scaledWidth);
+        }
+        qint64 current = timer.nsecsElapsed();
+        std::cout << "Thumbnails per second (scaled width " << scaledWidth << "): before " << (count * 1e9 / legacy) << ", after "
+                  << (count * 1e9 / current) << std::endl;
+    }
+    BENCHMARK("KThumb::getFrame 1280x720")
+    {
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        KThumb::getFrame(frame.data(), 1280, 720);
+    }
+}
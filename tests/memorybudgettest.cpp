@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include "utils/memorybudget.hpp"
+#include <algorithm>
+
+TEST_CASE("Memory budget release", "[MemoryBudget]")
+{
+    auto &budget = MemoryBudget::get();
+    qint64 baseline = budget->totalUsage();
+    qint64 big = 3000;
+    qint64 small = 1000;
+    qint64 fixed = 500;
+    auto releaser = [](qint64 &usage) {
+        return [&usage](qint64 bytes) {
+            qint64 freed = qMin(usage, bytes);
+            usage -= freed;
+            return freed;
+        };
+    };
+    int bigId = budget->registerConsumer(QStringLiteral("test cache"), [&big]() { return big; }, releaser(big));
+    int smallId = budget->registerConsumer(QStringLiteral("test cache"), [&small]() { return small; }, releaser(small));
+    int fixedId = budget->registerConsumer(QStringLiteral("test fixed"), [&fixed]() { return fixed; });
+    REQUIRE(budget->totalUsage() == baseline + 4500);
+
+    // Consumers sharing a name are reported together
+    auto usage = budget->usage();
+    auto it = std::find_if(usage.begin(), usage.end(), [](const MemoryBudget::Usage &u) { return u.name == QStringLiteral("test cache"); });
+    REQUIRE(it != usage.end());
+    REQUIRE(it->bytes == 4000);
+    REQUIRE(it->releasable);
+
+    // Nothing to do below the budget
+    REQUIRE(budget->release(baseline + 5000) == 0);
+
+    // The excess is shared in proportion of the usage
+    qint64 freed = budget->release(baseline + 2500);
+    REQUIRE(freed >= 2000);
+    REQUIRE(budget->totalUsage() <= baseline + 2500);
+    REQUIRE(big < 3000);
+    REQUIRE(small < 1000);
+    REQUIRE(big > small);
+    REQUIRE(fixed == 500);
+
+    // Releasable consumers keep part of the budget when the others alone exceed it
+    fixed = 6000;
+    budget->release(baseline + 4000);
+    REQUIRE(big + small > 0);
+    REQUIRE(big + small <= (baseline + 4000) / 4);
+    REQUIRE(fixed == 6000);
+
+    // Non releasable consumers are never asked
+    budget->release(0);
+    REQUIRE(big == 0);
+    REQUIRE(small == 0);
+    REQUIRE(fixed == 500);
+
+    budget->unregisterConsumer(bigId);
+    budget->unregisterConsumer(smallId);
+    budget->unregisterConsumer(fixedId);
+    REQUIRE(budget->totalUsage() <= baseline);
+}
@@ -0,0 +1,103 @@
+#include "catch.hpp"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <memory>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+#include <mutex>
+#define private public
+#define protected public
+#include "utils/probecache.hpp"
+
+namespace {
+void writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    file.open(QIODevice::Append);
+    file.write(data);
+}
+} // namespace
+
+TEST_CASE("Probe cache entries", "[ProbeCache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    // Entries are written to a temporary folder instead of the user cache
+    auto &cache = ProbeCache::get();
+    cache->m_pool.waitForDone();
+    const QDir previousDir = cache->m_dir;
+    cache->m_dir = QDir(dir.filePath(QStringLiteral("probe")));
+    cache->m_dir.mkpath(QStringLiteral("."));
+
+    const QString media = dir.filePath(QStringLiteral("media.mkv"));
+    writeFile(media, "data");
+    Mlt::Profile profile;
+    Mlt::Producer producer(profile, "color", "red");
+    REQUIRE(producer.is_valid());
+    // Set like the avformat producer does when probing the file
+    producer.set("length", 250);
+    producer.set("out", 249);
+    producer.set("meta.media.width", 1920);
+    const double fps = producer.get_fps();
+    cache->store(media, producer);
+
+    SECTION("A stored probe is found until the file changes")
+    {
+        QMap<QByteArray, QByteArray> properties;
+        REQUIRE(cache->readEntry(media, fps, properties));
+        REQUIRE(properties.value("length") == QByteArray("250"));
+        REQUIRE(properties.value("meta.media.width") == QByteArray("1920"));
+        // Lengths are in frames, they don't apply to another frame rate
+        REQUIRE_FALSE(cache->readEntry(media, fps * 2, properties));
+        writeFile(media, "more data");
+        REQUIRE_FALSE(cache->readEntry(media, fps, properties));
+    }
+
+    SECTION("A restored producer has the probed duration")
+    {
+        QMap<QByteArray, QByteArray> properties;
+        REQUIRE(cache->readEntry(media, fps, properties));
+        Mlt::Producer restored(profile, "color", "red");
+        REQUIRE(restored.is_valid());
+        cache->applyProperties(restored, properties);
+        REQUIRE(restored.get_length() == producer.get_length());
+        REQUIRE(restored.get_playtime() == producer.get_playtime());
+    }
+
+    SECTION("Revalidation rewrites outdated entries only")
+    {
+        REQUIRE_FALSE(cache->updateEntry(media, fps, producer));
+        producer.set("meta.media.width", 1280);
+        REQUIRE(cache->updateEntry(media, fps, producer));
+        QMap<QByteArray, QByteArray> properties;
+        REQUIRE(cache->readEntry(media, fps, properties));
+        REQUIRE(properties.value("meta.media.width") == QByteArray("1280"));
+        REQUIRE_FALSE(cache->updateEntry(media, fps, producer));
+    }
+
+    SECTION("Least recently used entries are evicted")
+    {
+        QStringList files{media};
+        for (int i = 1; i < 3; ++i) {
+            files << dir.filePath(QStringLiteral("media%1.mkv").arg(i));
+            writeFile(files.last(), "data");
+            cache->store(files.last(), producer);
+        }
+        // The first file is the least recently used
+        for (int i = 0; i < files.count(); ++i) {
+            QFile entry(cache->entryPath(files.at(i)));
+            REQUIRE(entry.open(QIODevice::Append));
+            entry.setFileTime(QDateTime::currentDateTime().addSecs(100 * (i - files.count())), QFileDevice::FileModificationTime);
+        }
+        cache->evict(2);
+        QMap<QByteArray, QByteArray> properties;
+        REQUIRE_FALSE(cache->readEntry(files.at(0), fps, properties));
+        REQUIRE(cache->readEntry(files.at(1), fps, properties));
+        REQUIRE(cache->readEntry(files.at(2), fps, properties));
+    }
+    cache->m_dir = previousDir;
+}
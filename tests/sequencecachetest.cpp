@@ -0,0 +1,94 @@
+#include "catch.hpp"
+#include "utils/sequencecache.hpp"
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+QString sequence(const QString &filterValue, const QString &blankLength)
+{
+    return QStringLiteral("<mlt><profile frame_rate_num=\"25\" frame_rate_den=\"1\"/>"
+                          "<producer id=\"a\" in=\"0\" out=\"99\"><property name=\"resource\">a.mp4</property>"
+                          "<property name=\"kdenlive:clipname\">A</property></producer>"
+                          "<producer id=\"b\" in=\"0\" out=\"99\"><property name=\"resource\">b.mp4</property></producer>"
+                          "<playlist id=\"playlist0\"><entry producer=\"a\" in=\"0\" out=\"49\"/><blank length=\"%2\"/>"
+                          "<entry producer=\"b\" in=\"00:00:01.000\" out=\"74\"><filter id=\"f\"><property name=\"mlt_service\">brightness</property>"
+                          "<property name=\"level\">%1</property></filter></entry></playlist>"
+                          "<tractor id=\"main\"><track producer=\"playlist0\"/></tractor></mlt>")
+        .arg(filterValue, blankLength);
+}
+
+QStringList fingerprints(const QTemporaryDir &dir, const QString &xml)
+{
+    const QString path = dir.filePath(QStringLiteral("sequence.mlt"));
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(xml.toUtf8());
+    file.close();
+    return SequenceCache::chunkFingerprints(path, 150, 25, 25., QStringLiteral("salt"));
+}
+} // namespace
+
+TEST_CASE("Nested sequence chunk fingerprints", "[SequenceCache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QStringList reference = fingerprints(dir, sequence(QStringLiteral("1"), QStringLiteral("50")));
+    // B starts at frame 100 and lasts 50 frames (1 second in = frame 25)
+    REQUIRE(reference.count() == 6);
+    REQUIRE(fingerprints(dir, sequence(QStringLiteral("1"), QStringLiteral("50"))) == reference);
+
+    SECTION("Editing an effect only changes the chunks of its clip")
+    {
+        const QStringList edited = fingerprints(dir, sequence(QStringLiteral("0.5"), QStringLiteral("50")));
+        REQUIRE(edited.count() == 6);
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(edited.at(i) == reference.at(i));
+        }
+        REQUIRE(edited.at(4) != reference.at(4));
+        REQUIRE(edited.at(5) != reference.at(5));
+    }
+
+    SECTION("Moving a clip changes the chunks it leaves and enters")
+    {
+        const QStringList moved = fingerprints(dir, sequence(QStringLiteral("1"), QStringLiteral("75")));
+        REQUIRE(moved.at(0) == reference.at(0));
+        REQUIRE(moved.at(1) == reference.at(1));
+        REQUIRE(moved.at(2) == reference.at(2));
+        REQUIRE(moved.at(4) != reference.at(4));
+        REQUIRE(moved.at(5) != reference.at(5));
+    }
+}
+
+TEST_CASE("Stale sequence chunks are removed", "[SequenceCache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    auto write = [&dir](const QString &name, const QString &content) {
+        QFile file(dir.filePath(name));
+        file.open(QIODevice::WriteOnly);
+        file.write(content.toUtf8());
+    };
+    auto playlist = [](const QStringList &chunks) {
+        QString xml = QStringLiteral("<mlt><playlist id=\"main\">");
+        for (const QString &chunk : chunks) {
+            xml += QStringLiteral("<producer><property name=\"resource\">%1</property></producer>").arg(chunk);
+        }
+        return xml + QStringLiteral("</playlist></mlt>");
+    };
+    for (const QString &chunk : {QStringLiteral("a.mkv"), QStringLiteral("b.mkv"), QStringLiteral("c.mkv"), QStringLiteral("d.mkv")}) {
+        write(chunk, QStringLiteral("data"));
+    }
+    write(QStringLiteral("old.mlt"), playlist({dir.filePath(QStringLiteral("a.mkv")), dir.filePath(QStringLiteral("b.mkv")), QStringLiteral("c.mkv")}));
+    // Another sequence with the same content shares chunk c
+    write(QStringLiteral("other.mlt"), playlist({QStringLiteral("c.mkv"), QStringLiteral("d.mkv")}));
+    REQUIRE(SequenceCache::playlistChunks(dir.filePath(QStringLiteral("old.mlt"))) ==
+            QStringList({QStringLiteral("a.mkv"), QStringLiteral("b.mkv"), QStringLiteral("c.mkv")}));
+
+    // The new render reuses chunk a
+    SequenceCache::removePlaylist(dir.filePath(QStringLiteral("old.mlt")), {dir.filePath(QStringLiteral("a.mkv"))});
+    REQUIRE_FALSE(QFile::exists(dir.filePath(QStringLiteral("old.mlt"))));
+    REQUIRE(QFile::exists(dir.filePath(QStringLiteral("a.mkv"))));
+    REQUIRE_FALSE(QFile::exists(dir.filePath(QStringLiteral("b.mkv"))));
+    REQUIRE(QFile::exists(dir.filePath(QStringLiteral("c.mkv"))));
+    REQUIRE(QFile::exists(dir.filePath(QStringLiteral("d.mkv"))));
+}
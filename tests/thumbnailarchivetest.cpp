@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "utils/thumbnailarchive.hpp"
+#include <QFile>
+#include <QTemporaryDir>
+
+TEST_CASE("Packed thumbnail archive", "[ThumbnailCache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("clip") + ThumbnailArchive::extension);
+
+    QImage opaque(64, 36, QImage::Format_RGB32);
+    opaque.fill(Qt::red);
+    QImage transparent(64, 36, QImage::Format_ARGB32);
+    transparent.fill(Qt::transparent);
+
+    SECTION("Missing or invalid archives are rejected")
+    {
+        ThumbnailArchive archive(path);
+        REQUIRE_FALSE(archive.load());
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write("not an archive");
+        file.close();
+        REQUIRE_FALSE(archive.load());
+        REQUIRE(archive.isEmpty());
+    }
+
+    SECTION("Tiles survive a save and reload")
+    {
+        ThumbnailArchive archive(path);
+        archive.insertTile(0, ThumbnailArchive::encode(opaque));
+        archive.insertTile(250, ThumbnailArchive::encode(transparent));
+        archive.insertTile(12, QByteArray());
+        REQUIRE(ThumbnailArchive::writeFile(path, archive.serialize()));
+
+        ThumbnailArchive reloaded(path);
+        REQUIRE(reloaded.load());
+        REQUIRE(reloaded.contains(0));
+        REQUIRE(reloaded.contains(250));
+        REQUIRE_FALSE(reloaded.contains(12));
+        QImage img = reloaded.image(0);
+        REQUIRE(img.size() == opaque.size());
+        REQUIRE(!img.hasAlphaChannel());
+        img = reloaded.image(250);
+        REQUIRE(img.size() == transparent.size());
+        REQUIRE(img.hasAlphaChannel());
+        REQUIRE(qAlpha(img.pixel(10, 10)) == 0);
+        REQUIRE(reloaded.image(1).isNull());
+    }
+}
@@ -0,0 +1,39 @@
+#include "bin/projectclip.h"
+#include "jobs/thumbjob.hpp"
+#include "test_utils.hpp"
+#include <QThread>
+
+using namespace fakeit;
+Mlt::Profile profile_thumbproducer;
+
+TEST_CASE("Thumbnail producer pool", "[ThumbProducer]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_thumbproducer, "red", binModel);
+    auto clip = binModel->getClipByBinID(binId);
+    REQUIRE(clip);
+
+    // Finished jobs are kept alive, they must not hold on to their producer
+    const int cap = QThread::idealThreadCount();
+    std::vector<std::unique_ptr<ThumbJob>> jobs;
+    for (int i = 0; i < cap + 3; ++i) {
+        jobs.push_back(std::make_unique<ThumbJob>(binId, i));
+        REQUIRE(jobs.back()->startJob());
+    }
+    REQUIRE(clip->m_thumbProducerCount > 0);
+    REQUIRE(clip->m_thumbProducerCount <= cap);
+    REQUIRE(clip->m_idleThumbProducers.size() == size_t(clip->m_thumbProducerCount));
+
+    jobs.clear();
+    clip.reset();
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}